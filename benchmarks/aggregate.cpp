@@ -0,0 +1,338 @@
+#include "harness.hpp"
+
+#include <numeric>
+#include <unordered_map>
+
+
+/*
+    Aggregates, quantifiers and comparisons: operators that scan the whole input and produce a single value.
+*/
+namespace {
+
+    using namespace bench;
+
+
+    template<typename container>
+    auto group_counts_loop(const container& src) {
+        std::unordered_map<int64_t, size_t> index;
+        std::vector<std::pair<int64_t, size_t>> result;
+        for (const auto& value : src) {
+            auto found = index.try_emplace(group_of()(value), result.size());
+            if (found.second)
+                result.emplace_back(found.first->first, 0);
+            ++result[found.first->second].second;
+        }
+        return result;
+    }
+
+
+    using pod64_columns = simlinq::columns<&pod64::key>;
+
+    /* The columnar copy of the input is built once, outside of the timed calls. */
+    const pod64_columns& columns_of(const std::vector<pod64>& src) {
+        static const std::vector<pod64>* from = nullptr;
+        static pod64_columns table;
+        if (from != &src or table.size() != src.size()) {
+            table = pod64_columns(src.begin(), src.end());
+            from = &src;
+        }
+        return table;
+    }
+
+
+    const bool registered = [] {
+        add<int, double, std::string, pod64>("Aggregate",
+            [](const auto& src) { return simlinq::Aggregate(src, [](const auto& v, auto& best) { if (best < v) best = v; }); },
+            [](const auto& src) {
+                value_t<decltype(src)> best{};
+                for (const auto& v : src)
+                    if (best < v)
+                        best = v;
+                return best;
+            });
+
+        add<int, double, std::string, pod64>("Aggregate(seed)",
+            [](const auto& src) { return simlinq::Aggregate(src, int64_t(0), [](const auto& v, int64_t& total) { total += key(v); }); },
+            [](const auto& src) {
+                int64_t total = 0;
+                for (const auto& v : src)
+                    total += key(v);
+                return total;
+            });
+
+        add<int, double, std::string, pod64>("Aggregate(seed, selector)",
+            [](const auto& src) {
+                return simlinq::Aggregate(src, int64_t(0), [](const auto& v, int64_t& total) { total += key(v); },
+                                          [](int64_t total) { return total % 1000; });
+            },
+            [](const auto& src) {
+                int64_t total = 0;
+                for (const auto& v : src)
+                    total += key(v);
+                return total % 1000;
+            });
+
+        add<int, double, std::string, pod64>("AggregateBy",
+            [](const auto& src) {
+                return simlinq::AggregateBy(src, group_of(), int64_t(0), [](const auto& v, int64_t& total) { total += key(v); });
+            },
+            [](const auto& src) {
+                std::unordered_map<int64_t, size_t> index;
+                std::vector<std::pair<int64_t, int64_t>> result;
+                for (const auto& value : src) {
+                    auto found = index.try_emplace(group_of()(value), result.size());
+                    if (found.second)
+                        result.emplace_back(found.first->first, 0);
+                    result[found.first->second].second += key(value);
+                }
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("All",
+            [](const auto& src) { return simlinq::All(src, [](const auto& v) { return key(v) >= 0; }); },
+            [](const auto& src) {
+                for (const auto& v : src)
+                    if (key(v) < 0)
+                        return false;
+                return true;
+            });
+
+        add<int, double, std::string, pod64>("All(par)",
+            [](const auto& src) { return simlinq::All(simlinq::par, src, [](const auto& v) { return key(v) >= 0; }); },
+            [](const auto& src) {
+                for (const auto& v : src)
+                    if (key(v) < 0)
+                        return false;
+                return true;
+            });
+
+        add<int, double, std::string, pod64>("Any",
+            [](const auto& src) { return simlinq::Any(src, [](const auto& v) { return key(v) < 0; }); },
+            [](const auto& src) {
+                for (const auto& v : src)
+                    if (key(v) < 0)
+                        return true;
+                return false;
+            });
+
+        add<int, double, std::string, pod64>("Any(par)",
+            [](const auto& src) { return simlinq::Any(simlinq::par, src, [](const auto& v) { return key(v) < 0; }); },
+            [](const auto& src) {
+                for (const auto& v : src)
+                    if (key(v) < 0)
+                        return true;
+                return false;
+            });
+
+        add<int, double>("Average",
+            [](const auto& src) { return simlinq::Average(src); },
+            [](const auto& src) {
+                value_t<decltype(src)> total{};
+                for (auto v : src)
+                    total += v;
+                return total / static_cast<decltype(total)>(src.size());
+            });
+
+        add<int, double, std::string, pod64>("Average(selector)",
+            [](const auto& src) { return simlinq::Average(src, [](const auto& v) { return static_cast<double>(key(v)); }); },
+            [](const auto& src) {
+                double total = 0;
+                for (const auto& v : src)
+                    total += static_cast<double>(key(v));
+                return total / static_cast<double>(src.size());
+            });
+
+        add<int, double, std::string, pod64>("Contains",
+            [](const auto& src) {
+                return simlinq::Contains(src, make_value<value_t<decltype(src)>>(-1));
+            },
+            [](const auto& src) {
+                const auto missing = make_value<value_t<decltype(src)>>(-1);
+                for (const auto& v : src)
+                    if (v == missing)
+                        return true;
+                return false;
+            });
+
+        add<int, double, std::string, pod64>("Contains(par)",
+            [](const auto& src) {
+                return simlinq::Contains(simlinq::par, src, make_value<value_t<decltype(src)>>(-1));
+            },
+            [](const auto& src) {
+                const auto missing = make_value<value_t<decltype(src)>>(-1);
+                for (const auto& v : src)
+                    if (v == missing)
+                        return true;
+                return false;
+            });
+
+        add<int, double, std::string, pod64>("Count",
+            [](const auto& src) { return simlinq::Count(src, is_even()); },
+            [](const auto& src) {
+                size_t count = 0;
+                for (const auto& v : src)
+                    count += is_even()(v);
+                return count;
+            });
+
+        add<int, double, std::string, pod64>("Count(par)",
+            [](const auto& src) { return simlinq::Count(simlinq::par, src, is_even()); },
+            [](const auto& src) {
+                size_t count = 0;
+                for (const auto& v : src)
+                    count += is_even()(v);
+                return count;
+            });
+
+        add<int, double, std::string, pod64>("CountBy",
+            [](const auto& src) { return simlinq::CountBy(src, group_of()); },
+            [](const auto& src) { return group_counts_loop(src); },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("LongCount",
+            [](const auto& src) { return simlinq::LongCount(src, is_even()); },
+            [](const auto& src) {
+                long long count = 0;
+                for (const auto& v : src)
+                    count += is_even()(v);
+                return count;
+            });
+
+        add<int, double, std::string, pod64>("Max",
+            [](const auto& src) { return simlinq::Max(src); },
+            [](const auto& src) {
+                auto result = src.front();
+                for (const auto& v : src)
+                    if (result < v)
+                        result = v;
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Max(par)",
+            [](const auto& src) { return simlinq::Max(simlinq::par, src); },
+            [](const auto& src) {
+                auto result = src.front();
+                for (const auto& v : src)
+                    if (result < v)
+                        result = v;
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Max(selector)",
+            [](const auto& src) { return simlinq::Max(src, key_of()); },
+            [](const auto& src) {
+                auto result = key(src.front());
+                for (const auto& v : src)
+                    result = std::max(result, key(v));
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Min",
+            [](const auto& src) { return simlinq::Min(src); },
+            [](const auto& src) {
+                auto result = src.front();
+                for (const auto& v : src)
+                    if (v < result)
+                        result = v;
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Min(par)",
+            [](const auto& src) { return simlinq::Min(simlinq::par, src); },
+            [](const auto& src) {
+                auto result = src.front();
+                for (const auto& v : src)
+                    if (v < result)
+                        result = v;
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Min(selector)",
+            [](const auto& src) { return simlinq::Min(src, key_of()); },
+            [](const auto& src) {
+                auto result = key(src.front());
+                for (const auto& v : src)
+                    result = std::min(result, key(v));
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("SequenceEqual",
+            [](const auto& src, const auto& other) { return simlinq::SequenceEqual(src, other); },
+            [](const auto& src, const auto& other) {
+                if (src.size() != other.size())
+                    return false;
+                for (size_t i = 0; i < src.size(); ++i)
+                    if (not (src[i] == other[i]))
+                        return false;
+                return true;
+            });
+
+        add<int, double>("Sum",
+            [](const auto& src) { return simlinq::Sum(src); },
+            [](const auto& src) {
+                value_t<decltype(src)> total{};
+                for (auto v : src)
+                    total += v;
+                return total;
+            });
+
+        add<pod64>("Sum(field)",
+            [](const auto& src) { return simlinq::Sum(src, simlinq::field<&pod64::key>()); },
+            [](const auto& src) {
+                int64_t total = 0;
+                for (const auto& v : src)
+                    total += v.key;
+                return total;
+            });
+
+        add<pod64>("Sum(columns)",
+            [](const auto& src) { return simlinq::Sum(columns_of(src), simlinq::field<&pod64::key>()); },
+            [](const auto& src) {
+                int64_t total = 0;
+                for (const auto& v : src)
+                    total += v.key;
+                return total;
+            });
+
+        add<pod64>("Count(columns)",
+            [](const auto& src) { return simlinq::Count(columns_of(src), simlinq::on<&pod64::key>([](int64_t k) { return (k & 1) == 0; })); },
+            [](const auto& src) {
+                size_t count = 0;
+                for (const auto& v : src)
+                    count += (v.key & 1) == 0;
+                return count;
+            });
+
+        add<int, double>("Sum(par)",
+            [](const auto& src) { return simlinq::Sum(simlinq::par, src); },
+            [](const auto& src) {
+                value_t<decltype(src)> total{};
+                for (auto v : src)
+                    total += v;
+                return total;
+            });
+
+        add<double>("Sum(kahan)",
+            [](const auto& src) { return simlinq::Sum(src, simlinq::summation::kahan); },
+            [](const auto& src) {
+                double total = 0, compensation = 0;
+                for (auto v : src) {
+                    const double y = v - compensation;
+                    const double t = total + y;
+                    compensation = (t - total) - y;
+                    total = t;
+                }
+                return total;
+            });
+
+        add<double>("Sum(pairwise)",
+            [](const auto& src) { return simlinq::Sum(src, simlinq::summation::pairwise); },
+            [](const auto& src) { return std::accumulate(src.begin(), src.end(), 0.0); });
+
+        return true;
+    }();
+
+}
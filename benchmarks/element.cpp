@@ -0,0 +1,155 @@
+#include "harness.hpp"
+
+
+/*
+    Element operators. The predicates look for the element farthest from where the search starts, so every call scans
+    the whole input on the permutation distributions.
+*/
+namespace {
+
+    using namespace bench;
+
+
+    const bool registered = [] {
+        add<int, double, std::string, pod64>("DefaultIfEmpty",
+            [](const auto& src) { return simlinq::DefaultIfEmpty(src); },
+            [](const auto& src) { return src; });
+
+        add<int, double, std::string, pod64>("ElementAt",
+            [](const auto& src) { return simlinq::ElementAt(src, static_cast<int>(src.size() / 2)); },
+            [](const auto& src) { return src[src.size() / 2]; });
+
+        add<int, double, std::string, pod64>("ElementAtOrDefault",
+            [](const auto& src) { return simlinq::ElementAtOrDefault(src, static_cast<int>(src.size() / 2)); },
+            [](const auto& src) { return src[src.size() / 2]; });
+
+        add<int, double, std::string, pod64>("Empty",
+            [](const auto& src) { return simlinq::Empty<std::decay_t<decltype(src)>>(); },
+            [](const auto& src) { return std::decay_t<decltype(src)>(); });
+
+        add<int, double, std::string, pod64>("First",
+            [](const auto& src) {
+                const auto target = key(src.back());
+                return simlinq::First(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.back());
+                for (const auto& v : src)
+                    if (key(v) == target)
+                        return v;
+                return value_t<decltype(src)>();
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("FirstOrDefault",
+            [](const auto& src) {
+                const auto target = key(src.back());
+                return simlinq::FirstOrDefault(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.back());
+                for (const auto& v : src)
+                    if (key(v) == target)
+                        return v;
+                return value_t<decltype(src)>();
+            });
+
+        add<int, double, std::string, pod64>("Last",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::Last(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                for (size_t i = src.size(); i-- > 0;)
+                    if (key(src[i]) == target)
+                        return src[i];
+                return value_t<decltype(src)>();
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Last(par)",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::Last(simlinq::par, src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                for (size_t i = src.size(); i-- > 0;)
+                    if (key(src[i]) == target)
+                        return src[i];
+                return value_t<decltype(src)>();
+            });
+
+        add<int, double, std::string, pod64>("LastOrDefault",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::LastOrDefault(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                for (size_t i = src.size(); i-- > 0;)
+                    if (key(src[i]) == target)
+                        return src[i];
+                return value_t<decltype(src)>();
+            });
+
+        add<int, double, std::string, pod64>("Single",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::Single(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                const value_t<decltype(src)>* found = nullptr;
+                for (const auto& v : src) {
+                    if (key(v) == target) {
+                        if (found != nullptr)
+                            return value_t<decltype(src)>();
+                        found = &v;
+                    }
+                }
+                return found != nullptr ? *found : value_t<decltype(src)>();
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Single(par)",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::Single(simlinq::par, src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                const value_t<decltype(src)>* found = nullptr;
+                for (const auto& v : src) {
+                    if (key(v) == target) {
+                        if (found != nullptr)
+                            return value_t<decltype(src)>();
+                        found = &v;
+                    }
+                }
+                return found != nullptr ? *found : value_t<decltype(src)>();
+            });
+
+        add<int, double, std::string, pod64>("SingleOrDefault",
+            [](const auto& src) {
+                const auto target = key(src.front());
+                return simlinq::SingleOrDefault(src, [target](const auto& v) { return key(v) == target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src.front());
+                const value_t<decltype(src)>* found = nullptr;
+                for (const auto& v : src) {
+                    if (key(v) == target) {
+                        if (found != nullptr)
+                            return value_t<decltype(src)>();
+                        found = &v;
+                    }
+                }
+                return found != nullptr ? *found : value_t<decltype(src)>();
+            });
+
+        return true;
+    }();
+
+}
@@ -0,0 +1,405 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+
+/*
+    Operators producing a new sequence: filtering, partitioning, set operations, joins, grouping, ordering and the
+    materializers. Binary operators receive the input and its copy.
+
+    OfType (needs a sequence of polymorphic pointers) and Prepend (takes the source by const reference and cannot
+    modify it) are not covered.
+*/
+namespace {
+
+    using namespace bench;
+
+
+    /* The input cut into collections of 1 to 15 elements, built once outside of the timed calls. */
+    template<typename T>
+    const std::vector<std::vector<T>>& nested_of(const std::vector<T>& src) {
+        static const std::vector<T>* from = nullptr;
+        static std::vector<std::vector<T>> nested;
+        if (from != &src or nested.empty() != src.empty()) {
+            nested.clear();
+            for (size_t i = 0, length = 1; i < src.size(); i += length, length = length % 15 + 1)
+                nested.emplace_back(src.begin() + i, src.begin() + std::min(src.size(), i + length));
+            from = &src;
+        }
+        return nested;
+    }
+
+
+    const bool registered = [] {
+        add<int, double, std::string, pod64>("Append",
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                for (auto value : src)
+                    simlinq::Append(result, value);
+                return result;
+            },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    result.push_back(value);
+                return result;
+            });
+
+        add<int, double>("Cast",
+            [](const auto& src) { return simlinq::Cast<long long>(src); },
+            [](const auto& src) {
+                std::vector<long long> result;
+                result.reserve(src.size());
+                for (auto value : src)
+                    result.push_back(static_cast<long long>(value));
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Concat",
+            [](const auto& src, const auto& other) { return simlinq::Concat(src, other); },
+            [](const auto& src, const auto& other) {
+                std::decay_t<decltype(src)> result;
+                result.reserve(src.size() + other.size());
+                result.insert(result.end(), src.begin(), src.end());
+                result.insert(result.end(), other.begin(), other.end());
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Distinct",
+            [](const auto& src, const auto& other) { return simlinq::Distinct(src, other); },
+            [](const auto& src, const auto& other) {
+                std::unordered_set<value_t<decltype(src)>> second(other.begin(), other.end());
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (second.count(value) == 0)
+                        result.push_back(value);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Distinct(src)",
+            [](const auto& src) { return simlinq::Distinct(src); },
+            [](const auto& src) {
+                std::unordered_set<value_t<decltype(src)>> seen;
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (seen.insert(value).second)
+                        result.push_back(value);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("DistinctBy",
+            [](const auto& src) { return simlinq::DistinctBy(src, group_of()); },
+            [](const auto& src) {
+                std::unordered_set<int64_t> seen;
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (seen.insert(group_of()(value)).second)
+                        result.push_back(value);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("except",
+            [](const auto& src, const auto& other) { return simlinq::except(src, other); },
+            [](const auto& src, const auto& other) {
+                std::unordered_set<value_t<decltype(src)>> second(other.begin(), other.end());
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (second.count(value) == 0)
+                        result.push_back(value);
+                return result;
+            },
+            config().up_to(10000));
+
+        add<int, double, std::string, pod64>("GroupBy",
+            [](const auto& src) { return simlinq::GroupBy(src, group_of()); },
+            [](const auto& src) {
+                std::unordered_map<int64_t, std::decay_t<decltype(src)>> groups;
+                for (const auto& value : src)
+                    groups[group_of()(value)].push_back(value);
+                return groups;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("GroupJoin",
+            [](const auto& src, const auto& other) {
+                return simlinq::GroupJoin(src, other, key_of(), key_of(),
+                                          [](const auto&, const auto& group) { return group.size(); });
+            },
+            [](const auto& src, const auto& other) {
+                std::unordered_map<int64_t, size_t> index;
+                for (const auto& value : other)
+                    ++index[key(value)];
+                std::vector<size_t> result;
+                result.reserve(src.size());
+                for (const auto& value : src) {
+                    auto found = index.find(key(value));
+                    result.push_back(found != index.end() ? found->second : 0);
+                }
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Intersect",
+            [](const auto& src, const auto& other) { return simlinq::Intersect(src, other); },
+            [](const auto& src, const auto& other) {
+                std::unordered_set<value_t<decltype(src)>> second(other.begin(), other.end());
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (second.erase(value) != 0)
+                        result.push_back(value);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Join",
+            [](const auto& src, const auto& other) {
+                return simlinq::Join(src, other, key_of(), key_of(),
+                                     [](const auto& l, const auto& r) { return key(l) + key(r); });
+            },
+            [](const auto& src, const auto& other) {
+                std::unordered_multimap<int64_t, const value_t<decltype(src)>*> index;
+                for (const auto& value : other)
+                    index.emplace(key(value), &value);
+                std::vector<int64_t> result;
+                for (const auto& value : src) {
+                    auto range = index.equal_range(key(value));
+                    for (auto it = range.first; it != range.second; ++it)
+                        result.push_back(key(value) + key(*it->second));
+                }
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("OrderBy",
+            [](const auto& src) { return simlinq::OrderBy(src, key_of()); },
+            [](const auto& src) {
+                auto result = src;
+                std::sort(result.begin(), result.end(), [](const auto& l, const auto& r) { return key(l) < key(r); });
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("OrderBy(string key)",
+            [](const auto& src) { return simlinq::OrderBy(src, [](const auto& v) { return std::to_string(key(v)); }); },
+            [](const auto& src) {
+                auto result = src;
+                std::sort(result.begin(), result.end(), [](const auto& l, const auto& r) {
+                    return std::to_string(key(l)) < std::to_string(key(r));
+                });
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("OrderBy(par)",
+            [](const auto& src) { return simlinq::OrderBy(simlinq::par, src, key_of()); },
+            [](const auto& src) {
+                auto result = src;
+                std::sort(result.begin(), result.end(), [](const auto& l, const auto& r) { return key(l) < key(r); });
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("OrderByDescending",
+            [](const auto& src) { return simlinq::OrderByDescending(src, key_of()); },
+            [](const auto& src) {
+                auto result = src;
+                std::sort(result.begin(), result.end(), [](const auto& l, const auto& r) { return key(l) > key(r); });
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double>("range",
+            [](const auto& src) { return simlinq::range<std::decay_t<decltype(src)>>(value_t<decltype(src)>(), static_cast<uint32_t>(src.size())); },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result(src.size());
+                for (size_t i = 0; i < result.size(); ++i)
+                    result[i] = static_cast<value_t<decltype(src)>>(i);
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Repeat",
+            [](const auto& src) { return simlinq::Repeat<std::decay_t<decltype(src)>>(src.front(), static_cast<uint32_t>(src.size())); },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                result.reserve(src.size());
+                for (size_t i = 0; i < src.size(); ++i)
+                    result.push_back(src.front());
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Reverse",
+            [](const auto& src) {
+                auto result = src;
+                simlinq::Reverse(result);
+                return result;
+            },
+            [](const auto& src) { return std::decay_t<decltype(src)>(src.rbegin(), src.rend()); });
+
+        add<int, double>("select",
+            [](const auto& src) { return simlinq::select<std::vector>(src, [](auto v) { return v + 1; }); },
+            [](const auto& src) {
+                auto result = src;
+                for (auto& v : result)
+                    v = v + 1;
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("Skip",
+            [](const auto& src) { return simlinq::Skip(src, src.size() / 2); },
+            [](const auto& src) { return std::decay_t<decltype(src)>(src.begin() + src.size() / 2, src.end()); });
+
+        add<int, double, std::string, pod64>("Page",
+            [](const auto& src) { return simlinq::Page(src, src.size() / 2, 100); },
+            [](const auto& src) {
+                const auto first = src.begin() + src.size() / 2;
+                return std::decay_t<decltype(src)>(first, first + std::min<size_t>(100, src.end() - first));
+            });
+
+        add<int, double>("Sum(SkipView, TakeView)",
+            [](const auto& src) { return simlinq::Sum(simlinq::TakeView(simlinq::SkipView(src, src.size() / 2), 100)); },
+            [](const auto& src) {
+                const auto first = src.begin() + src.size() / 2;
+                return std::accumulate(first, first + std::min<size_t>(100, src.end() - first), value_t<decltype(src)>());
+            });
+
+        add<int, double, std::string, pod64>("SkipWhile",
+            [](const auto& src) {
+                const auto target = key(src[src.size() / 2]);
+                return simlinq::SkipWhile(src, [target](const auto& v) { return key(v) != target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src[src.size() / 2]);
+                auto it = src.begin();
+                while (it != src.end() and key(*it) != target)
+                    ++it;
+                return std::decay_t<decltype(src)>(it, src.end());
+            });
+
+        add<int, double, std::string, pod64>("Take",
+            [](const auto& src) { return simlinq::Take<512>(src); },
+            [](const auto& src) { return std::decay_t<decltype(src)>(src.begin(), src.begin() + std::min<size_t>(512, src.size())); });
+
+        add<int, double, std::string, pod64>("TakeWhile",
+            [](const auto& src) {
+                const auto target = key(src[src.size() / 2]);
+                return simlinq::TakeWhile(src, [target](const auto& v) { return key(v) != target; });
+            },
+            [](const auto& src) {
+                const auto target = key(src[src.size() / 2]);
+                auto it = src.begin();
+                while (it != src.end() and key(*it) != target)
+                    ++it;
+                return std::decay_t<decltype(src)>(src.begin(), it);
+            });
+
+        add<int, double, std::string, pod64>("ToDictionary",
+            [](const auto& src) { return simlinq::ToDictionary(src, key_of()); },
+            [](const auto& src) {
+                std::unordered_map<int64_t, value_t<decltype(src)>> result;
+                result.reserve(src.size());
+                for (const auto& value : src)
+                    result.emplace(key(value), value);
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("ToDictionary(flat_map)",
+            [](const auto& src) { return simlinq::ToDictionary<simlinq::flat_map>(src, key_of()); },
+            [](const auto& src) {
+                std::unordered_map<int64_t, value_t<decltype(src)>> result;
+                result.reserve(src.size());
+                for (const auto& value : src)
+                    result.emplace(key(value), value);
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("ToHashSet",
+            [](const auto& src) { return simlinq::ToHashSet(src); },
+            [](const auto& src) { return std::unordered_set<value_t<decltype(src)>>(src.begin(), src.end()); },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("ToLookup",
+            [](const auto& src) { return simlinq::ToLookup(src, group_of()); },
+            [](const auto& src) {
+                std::unordered_map<int64_t, std::decay_t<decltype(src)>> groups;
+                for (const auto& value : src)
+                    groups[group_of()(value)].push_back(value);
+                return groups;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("TopBy(100)",
+            [](const auto& src) { return simlinq::TopBy(src, 100, key_of()); },
+            [](const auto& src) {
+                auto result = src;
+                const auto count = std::min<size_t>(100, result.size());
+                std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                                  [](const auto& l, const auto& r) { return key(l) < key(r); });
+                result.resize(count);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Take(OrderBy, 100)",
+            [](const auto& src) { return simlinq::Take<100>(simlinq::OrderBy(src, key_of())); },
+            [](const auto& src) {
+                auto result = src;
+                const auto count = std::min<size_t>(100, result.size());
+                std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                                  [](const auto& l, const auto& r) { return key(l) < key(r); });
+                result.resize(count);
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Union",
+            [](const auto& src, const auto& other) { return simlinq::Union(src, other); },
+            [](const auto& src, const auto& other) {
+                std::unordered_set<value_t<decltype(src)>> result;
+                result.reserve(src.size() + other.size());
+                result.insert(src.begin(), src.end());
+                result.insert(other.begin(), other.end());
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("Where",
+            [](const auto& src) { return simlinq::Where(src, is_even()); },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (is_even()(value))
+                        result.push_back(value);
+                return result;
+            });
+
+        add<std::string>("Zip",
+            [](const auto& src, const auto& other) { return simlinq::Zip(src, other, [](const auto& l, const auto& r) { return l + r; }); },
+            [](const auto& src, const auto& other) {
+                std::vector<std::string> result;
+                const auto count = std::min(src.size(), other.size());
+                result.reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                    result.push_back(src[i] + other[i]);
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("SelectMany",
+            [](const auto& src) {
+                return simlinq::SelectMany(nested_of(src), [](const auto& v) -> const auto& { return v; });
+            },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                for (const auto& inner : nested_of(src))
+                    for (const auto& value : inner)
+                        result.push_back(value);
+                return result;
+            });
+
+        return true;
+    }();
+
+}
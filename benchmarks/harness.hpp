@@ -0,0 +1,256 @@
+#ifndef SIMLINQ_BENCHMARKS_HARNESS_HPP
+#define SIMLINQ_BENCHMARKS_HARNESS_HPP
+
+#include <Linq.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/*
+    Minimal benchmark harness.
+
+    Every benchmark is registered once per element type as a pair of bodies: the simlinq call and the hand-written loop
+    doing the same work. The runner (main.cpp) feeds both with the same input for every size and distribution, and
+    reports ns/element, bytes allocated per call and the ratio against the loop.
+*/
+namespace bench {
+
+    /*
+        64-byte trivially copyable record; only the key takes part in comparisons.
+    */
+    struct pod64 {
+        int64_t key;
+        int64_t payload[7];
+
+        bool operator==(const pod64& other) const { return key == other.key; }
+        bool operator!=(const pod64& other) const { return key != other.key; }
+        bool operator<(const pod64& other) const { return key < other.key; }
+        bool operator>(const pod64& other) const { return key > other.key; }
+    };
+
+    static_assert(sizeof(pod64) == 64, "pod64 must stay 64 bytes");
+
+
+    enum class distribution {
+        sorted,
+        reversed,
+        random,
+        duplicates
+    };
+
+
+    inline const char* to_string(distribution d) {
+        switch (d) {
+            case distribution::sorted:     return "sorted";
+            case distribution::reversed:   return "reversed";
+            case distribution::random:     return "random";
+            case distribution::duplicates: return "duplicates";
+        }
+        return "";
+    }
+
+
+    template<typename T> const char* type_name();
+    template<> inline const char* type_name<int>() { return "int"; }
+    template<> inline const char* type_name<double>() { return "double"; }
+    template<> inline const char* type_name<std::string>() { return "string"; }
+    template<> inline const char* type_name<pod64>() { return "pod64"; }
+
+
+    /*
+        Builds an element from an integer key, and recovers the key from an element.
+        Strings are 16 digits long so that they never fit into the small string buffer.
+    */
+    template<typename T>
+    T make_value(int64_t key) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            std::string result(16, '0');
+            const bool negative = key < 0;
+            uint64_t rest = negative ? static_cast<uint64_t>(-key) : static_cast<uint64_t>(key);
+            for (size_t i = result.size(); i-- > 1 and rest != 0; rest /= 10)
+                result[i] = static_cast<char>('0' + rest % 10);
+            if (negative)
+                result[0] = '-';
+            return result;
+        } else if constexpr (std::is_same_v<T, pod64>) {
+            pod64 result{ key, {} };
+            for (auto& p : result.payload)
+                p = key;
+            return result;
+        } else {
+            return static_cast<T>(key);
+        }
+    }
+
+
+    template<typename T>
+    int64_t key(const T& value) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            int64_t result = 0;
+            for (size_t i = 1; i < value.size(); ++i)
+                result = result * 10 + (value[i] - '0');
+            return value[0] == '-' ? -result : result;
+        } else if constexpr (std::is_same_v<T, pod64>) {
+            return value.key;
+        } else {
+            return static_cast<int64_t>(value);
+        }
+    }
+
+
+    template<typename container>
+    using value_t = typename std::decay_t<container>::value_type;
+
+
+    /*
+        Predicates and selectors shared by the benchmark bodies.
+    */
+    struct is_even {
+        template<typename T>
+        bool operator()(const T& value) const { return (key(value) & 1) == 0; }
+    };
+
+    struct key_of {
+        template<typename T>
+        int64_t operator()(const T& value) const { return key(value); }
+    };
+
+    /* 1024 groups whatever the input size */
+    struct group_of {
+        template<typename T>
+        int64_t operator()(const T& value) const { return key(value) & 1023; }
+    };
+
+
+    /*
+        Keys 0..n-1 in the requested order; `duplicates` draws from about sqrt(n) distinct keys.
+    */
+    template<typename T>
+    std::vector<T> make_input(size_t count, distribution d) {
+        std::vector<int64_t> keys(count);
+        std::mt19937_64 rng(count);
+
+        switch (d) {
+            case distribution::sorted:
+            case distribution::random:
+                for (size_t i = 0; i < count; ++i)
+                    keys[i] = static_cast<int64_t>(i);
+                if (d == distribution::random)
+                    std::shuffle(keys.begin(), keys.end(), rng);
+                break;
+            case distribution::reversed:
+                for (size_t i = 0; i < count; ++i)
+                    keys[i] = static_cast<int64_t>(count - 1 - i);
+                break;
+            case distribution::duplicates: {
+                uint64_t distinct = 1;
+                while (distinct * distinct < count)
+                    ++distinct;
+                for (auto& k : keys)
+                    k = static_cast<int64_t>(rng() % distinct);
+                break;
+            }
+        }
+
+        std::vector<T> result;
+        result.reserve(count);
+        for (auto k : keys)
+            result.push_back(make_value<T>(k));
+        return result;
+    }
+
+
+    /*
+        Keeps the compiler from discarding a result that is never read.
+    */
+    template<typename T>
+    inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+
+    /*
+        Per-benchmark settings. By default a benchmark only runs on the random distribution; order sensitive operators
+        ask for all of them. Operators with quadratic behaviour cap the input size.
+    */
+    struct config {
+        bool every_distribution = false;
+        size_t max_size = std::numeric_limits<size_t>::max();
+
+        config all_distributions() const {
+            auto result = *this;
+            result.every_distribution = true;
+            return result;
+        }
+
+        config up_to(size_t size) const {
+            auto result = *this;
+            result.max_size = size;
+            return result;
+        }
+    };
+
+
+    /*
+        Bodies receive the input and an equal copy of it, so that binary operators never see the same storage twice.
+    */
+    template<typename T>
+    struct benchmark {
+        std::string name;
+        std::function<void(const std::vector<T>&, const std::vector<T>&)> linq;
+        std::function<void(const std::vector<T>&, const std::vector<T>&)> loop;
+        config settings;
+    };
+
+
+    template<typename T, typename body>
+    auto erase_body(body b) {
+        return [b](const std::vector<T>& src, const std::vector<T>& other) {
+            if constexpr (std::is_invocable_v<const body&, const std::vector<T>&, const std::vector<T>&>)
+                do_not_optimize(b(src, other));
+            else
+                do_not_optimize(b(src));
+        };
+    }
+
+
+    template<typename T>
+    std::vector<benchmark<T>>& registry() {
+        static std::vector<benchmark<T>> benchmarks;
+        return benchmarks;
+    }
+
+
+    /*
+        Registers `linq` and `loop` for every listed element type. Both bodies take the input vector (and optionally its
+        copy) and return the result, which is kept alive until the call is timed.
+    */
+    template<typename... types, typename linq_body, typename loop_body>
+    void add(const std::string& name, linq_body linq, loop_body loop, config settings = {}) {
+        (registry<types>().push_back({ name, erase_body<types>(linq), erase_body<types>(loop), settings }), ...);
+    }
+
+}
+
+
+namespace std {
+
+    template<>
+    struct hash<bench::pod64> {
+        size_t operator()(const bench::pod64& value) const { return hash<int64_t>()(value.key); }
+    };
+
+}
+
+#endif
@@ -0,0 +1,318 @@
+#include "harness.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <thread>
+
+
+/*
+    Every allocation made by the process goes through these, so the runner can report bytes allocated per call.
+*/
+namespace {
+    std::atomic<size_t> allocated_bytes{ 0 };
+    std::atomic<size_t> allocation_count{ 0 };
+}
+
+void* operator new(std::size_t size) {
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+#if defined(__GNUC__) && not defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+namespace {
+
+    struct options {
+        size_t min_size = 1000;
+        size_t max_size = 1000000;
+        double min_time = 0.05;
+        size_t memory_limit = size_t(2) << 30;
+        std::string filter;
+        std::string types;
+        std::string json;
+    };
+
+
+    struct measurement {
+        double ns_per_element = 0;
+        size_t iterations = 0;
+        size_t bytes = 0;
+        size_t allocations = 0;
+    };
+
+
+    struct result {
+        std::string name;
+        std::string op;
+        std::string type;
+        std::string dist;
+        size_t size;
+        measurement linq;
+        measurement loop;
+    };
+
+
+    /*
+        One untimed call measures the allocations and warms the caches, then batches are timed until `min_time` is
+        reached; the batch size is extrapolated from the time spent so far.
+    */
+    template<typename T>
+    measurement measure(const std::function<void(const std::vector<T>&, const std::vector<T>&)>& body,
+                        const std::vector<T>& src,
+                        const std::vector<T>& other,
+                        double min_time) {
+        using clock = std::chrono::steady_clock;
+        measurement m;
+
+        const auto bytes = allocated_bytes.load();
+        const auto count = allocation_count.load();
+        body(src, other);
+        m.bytes = allocated_bytes.load() - bytes;
+        m.allocations = allocation_count.load() - count;
+
+        double elapsed = 0;
+        size_t batch = 1;
+        while (elapsed < min_time) {
+            const auto start = clock::now();
+            for (size_t i = 0; i < batch; ++i)
+                body(src, other);
+            elapsed += std::chrono::duration<double>(clock::now() - start).count();
+            m.iterations += batch;
+
+            const double per_call = elapsed / static_cast<double>(m.iterations);
+            const double wanted = per_call > 0 ? (min_time - elapsed) / per_call : double(batch) * 10;
+            batch = static_cast<size_t>(std::min(std::max(wanted, 1.0), double(batch) * 10));
+        }
+
+        m.ns_per_element = elapsed * 1e9 / static_cast<double>(m.iterations) / static_cast<double>(std::max<size_t>(src.size(), 1));
+        return m;
+    }
+
+
+    template<typename T>
+    size_t footprint(size_t count) {
+        return std::is_same_v<T, std::string>
+            ? count * (sizeof(std::string) + 17)
+            : count * sizeof(T);
+    }
+
+
+    bool selected(const std::string& list, const std::string& item) {
+        if (list.empty())
+            return true;
+        std::stringstream stream(list);
+        std::string token;
+        while (std::getline(stream, token, ','))
+            if (token == item)
+                return true;
+        return false;
+    }
+
+
+    void print(const result& r) {
+        printf("%-56s %12.3f %12.3f %8.2fx %14zu %10zu\n",
+               r.name.c_str(),
+               r.linq.ns_per_element,
+               r.loop.ns_per_element,
+               r.loop.ns_per_element > 0 ? r.linq.ns_per_element / r.loop.ns_per_element : 0.0,
+               r.linq.bytes,
+               r.loop.bytes);
+        fflush(stdout);
+    }
+
+
+    template<typename T>
+    void run_type(const options& opts, std::vector<result>& results) {
+        if (not selected(opts.types, bench::type_name<T>()))
+            return;
+
+        const bench::distribution distributions[] = {
+            bench::distribution::sorted,
+            bench::distribution::reversed,
+            bench::distribution::random,
+            bench::distribution::duplicates
+        };
+
+        for (size_t size = std::max<size_t>(opts.min_size, 1); size <= opts.max_size; size *= 10) {
+            if (footprint<T>(size) > opts.memory_limit) {
+                fprintf(stderr, "skipping %s/%zu: input exceeds the memory limit\n", bench::type_name<T>(), size);
+                break;
+            }
+
+            for (auto dist : distributions) {
+                std::vector<T> input;
+                std::vector<T> other;
+
+                for (const auto& b : bench::registry<T>()) {
+                    if (size > b.settings.max_size)
+                        continue;
+                    if (dist != bench::distribution::random and not b.settings.every_distribution)
+                        continue;
+
+                    auto name = b.name + "/" + bench::type_name<T>() + "/" + bench::to_string(dist) + "/" + std::to_string(size);
+                    if (not opts.filter.empty() and name.find(opts.filter) == std::string::npos)
+                        continue;
+
+                    if (input.size() != size) {
+                        input = bench::make_input<T>(size, dist);
+                        other = input;
+                    }
+
+                    result r{ name, b.name, bench::type_name<T>(), bench::to_string(dist), size, {}, {} };
+                    r.linq = measure(b.linq, input, other, opts.min_time);
+                    r.loop = measure(b.loop, input, other, opts.min_time);
+                    print(r);
+                    results.push_back(std::move(r));
+                }
+            }
+        }
+    }
+
+
+    std::string escape(const std::string& s) {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' or c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+
+    const char* instruction_set_name() {
+        using simlinq::detail::simd::instruction_set;
+        switch (simlinq::detail::simd::supported()) {
+            case instruction_set::avx512: return "avx512";
+            case instruction_set::avx2:   return "avx2";
+            case instruction_set::sse2:   return "sse2";
+            case instruction_set::scalar: return "scalar";
+        }
+        return "";
+    }
+
+
+    /*
+        One object per benchmark, in a stable order so that two runs can be diffed.
+    */
+    void write_json(const std::string& path, const options& opts, const std::vector<result>& results) {
+        std::ofstream out(path);
+        char buffer[64];
+
+        auto number = [&buffer](double value) {
+            snprintf(buffer, sizeof(buffer), "%.4f", value);
+            return std::string(buffer);
+        };
+
+        auto write_measurement = [&](const char* field, const measurement& m) {
+            out << "      \"" << field << "\": { "
+                << "\"ns_per_element\": " << number(m.ns_per_element) << ", "
+                << "\"iterations\": " << m.iterations << ", "
+                << "\"bytes_allocated\": " << m.bytes << ", "
+                << "\"allocations\": " << m.allocations << " }";
+        };
+
+        out << "{\n"
+            << "  \"context\": {\n"
+#ifdef __VERSION__
+            << "    \"compiler\": \"" << escape(__VERSION__) << "\",\n"
+#endif
+            << "    \"instruction_set\": \"" << instruction_set_name() << "\",\n"
+            << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+            << "    \"min_time\": " << number(opts.min_time) << "\n"
+            << "  },\n"
+            << "  \"benchmarks\": [\n";
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << "    {\n"
+                << "      \"name\": \"" << escape(r.name) << "\",\n"
+                << "      \"operator\": \"" << escape(r.op) << "\",\n"
+                << "      \"type\": \"" << r.type << "\",\n"
+                << "      \"distribution\": \"" << r.dist << "\",\n"
+                << "      \"size\": " << r.size << ",\n";
+            write_measurement("simlinq", r.linq);
+            out << ",\n";
+            write_measurement("loop", r.loop);
+            out << ",\n"
+                << "      \"ratio\": " << number(r.loop.ns_per_element > 0 ? r.linq.ns_per_element / r.loop.ns_per_element : 0.0) << "\n"
+                << "    }" << (i + 1 != results.size() ? "," : "") << "\n";
+        }
+
+        out << "  ]\n"
+            << "}\n";
+    }
+
+
+    void usage(const char* program) {
+        printf("usage: %s [--filter=<substring>] [--types=int,double,string,pod64]\n"
+               "          [--min-size=1e3] [--max-size=1e6] [--min-time=0.05] [--memory-limit=<bytes>]\n"
+               "          [--json=<file>]\n",
+               program);
+    }
+
+}
+
+
+int main(int argc, const char* argv[]) {
+    options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        const auto name = arg.substr(0, eq);
+        const auto value = eq != std::string::npos ? arg.substr(eq + 1) : std::string();
+
+        if (name == "--filter")
+            opts.filter = value;
+        else if (name == "--types")
+            opts.types = value;
+        else if (name == "--json")
+            opts.json = value;
+        else if (name == "--min-size")
+            opts.min_size = static_cast<size_t>(std::stod(value));
+        else if (name == "--max-size")
+            opts.max_size = static_cast<size_t>(std::stod(value));
+        else if (name == "--min-time")
+            opts.min_time = std::stod(value);
+        else if (name == "--memory-limit")
+            opts.memory_limit = static_cast<size_t>(std::stod(value));
+        else {
+            usage(argv[0]);
+            return name == "--help" ? 0 : 1;
+        }
+    }
+
+    printf("%-56s %12s %12s %9s %14s %10s\n", "benchmark", "ns/elem", "loop ns/elem", "ratio", "bytes", "loop bytes");
+
+    std::vector<result> results;
+    run_type<int>(opts, results);
+    run_type<double>(opts, results);
+    run_type<std::string>(opts, results);
+    run_type<bench::pod64>(opts, results);
+
+    if (not opts.json.empty())
+        write_json(opts.json, opts, results);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "harness.hpp"
+
+#include <algorithm>
+
+
+/*
+    Lazy pipelines built with simlinq::from, against the fused loop a programmer would write by hand.
+*/
+namespace {
+
+    using namespace bench;
+
+
+    struct not_third {
+        template<typename T>
+        bool operator()(const T& value) const { return key(value) % 3 != 0; }
+    };
+
+    struct in_upper_half {
+        size_t size;
+
+        template<typename T>
+        bool operator()(const T& value) const { return key(value) >= static_cast<int64_t>(size / 2); }
+    };
+
+    template<typename container>
+    size_t three_filters_loop(const container& src) {
+        size_t count = 0;
+        for (const auto& value : src)
+            if (is_even()(value) and not_third()(value) and in_upper_half{ src.size() }(value))
+                ++count;
+        return count;
+    }
+
+
+    const bool registered = [] {
+        add<int, double, std::string, pod64>("from.Where.Select.Sum",
+            [](const auto& src) { return simlinq::from(src).Where(is_even()).Select(key_of()).Sum(); },
+            [](const auto& src) {
+                int64_t total = 0;
+                for (const auto& value : src)
+                    if (is_even()(value))
+                        total += key(value);
+                return total;
+            });
+
+        add<int, double, std::string, pod64>("from.Where.Count",
+            [](const auto& src) { return simlinq::from(src).Where(is_even()).Count(); },
+            [](const auto& src) {
+                size_t count = 0;
+                for (const auto& value : src)
+                    count += is_even()(value);
+                return count;
+            });
+
+        add<int, double, std::string, pod64>("from.Where.ToVector",
+            [](const auto& src) { return simlinq::from(src).Where(is_even()).ToVector(); },
+            [](const auto& src) {
+                std::decay_t<decltype(src)> result;
+                for (const auto& value : src)
+                    if (is_even()(value))
+                        result.push_back(value);
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("from.Skip.Take.Max",
+            [](const auto& src) { return simlinq::from(src).Skip(src.size() / 4).Take(src.size() / 2).Select(key_of()).Max(); },
+            [](const auto& src) {
+                auto result = key(src[src.size() / 4]);
+                for (size_t i = src.size() / 4; i < src.size() / 4 + src.size() / 2; ++i)
+                    result = std::max(result, key(src[i]));
+                return result;
+            });
+
+        add<int, double, std::string, pod64>("from.Concat.Any",
+            [](const auto& src, const auto& other) { return simlinq::from(src).Concat(other).Any([](const auto& v) { return key(v) < 0; }); },
+            [](const auto& src, const auto& other) {
+                for (const auto& value : src)
+                    if (key(value) < 0)
+                        return true;
+                for (const auto& value : other)
+                    if (key(value) < 0)
+                        return true;
+                return false;
+            });
+
+        add<int, double, std::string, pod64>("from.OrderBy.ThenBy.ToVector",
+            [](const auto& src) { return simlinq::from(src).OrderBy(group_of()).ThenBy(key_of()).ToVector(); },
+            [](const auto& src) {
+                std::vector<value_t<decltype(src)>> result(src.begin(), src.end());
+                std::sort(result.begin(), result.end(), [](const auto& l, const auto& r) {
+                    const auto lg = group_of()(l), rg = group_of()(r);
+                    return lg != rg ? lg < rg : key(l) < key(r);
+                });
+                return result;
+            },
+            config().all_distributions());
+
+        add<int, double, std::string, pod64>("from.Where.Where.Where.Count",
+            [](const auto& src) {
+                return simlinq::from(src).Where(is_even()).Where(not_third()).Where(in_upper_half{ src.size() }).Count();
+            },
+            [](const auto& src) { return three_filters_loop(src); });
+
+        add<int, double, std::string, pod64>("mask.Where.Where.Where.Count",
+            [](const auto& src) {
+                return simlinq::mask(src).Where(is_even()).Where(not_third()).Where(in_upper_half{ src.size() }).Count();
+            },
+            [](const auto& src) { return three_filters_loop(src); });
+
+        return true;
+    }();
+
+}
@@ -1,15 +1,112 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <numeric>
 #include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include <string>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && not defined(SIMLINQ_NO_SIMD)
+#define SIMLINQ_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if (defined(__unix__) || defined(__APPLE__)) && not defined(SIMLINQ_NO_MMAP)
+#define SIMLINQ_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace simlinq {
 
+    template<typename iterator>
+    class view;
+    
     
     namespace detail {
         
+        template<typename T>
+        struct is_view : std::false_type {};
+        
+        template<typename iterator>
+        struct is_view<view<iterator>> : std::true_type {};
+        
+        /* the container a query over `container` materializes into: views do not own their elements, so they give a vector */
+        template<typename container>
+        using owning_t = std::conditional_t<is_view<container>::value,
+                                            std::vector<typename std::iterator_traits<decltype(std::begin(std::declval<const container&>()))>::value_type>,
+                                            container>;
+        
+        template<typename container, typename = void>
+        struct has_allocator : std::false_type {};
+        
+        template<typename container>
+        struct has_allocator<container, std::void_t<decltype(std::declval<const container&>().get_allocator())>> : std::true_type {};
+        
+        template<typename T, typename = void>
+        struct is_allocator : std::false_type {};
+        
+        template<typename T>
+        struct is_allocator<T, std::void_t<typename T::value_type,
+                                           decltype(std::declval<T&>().allocate(size_t()))>> : std::true_type {};
+        
+        template<typename T>
+        inline constexpr bool is_allocator_v = is_allocator<std::decay_t<T>>::value;
+        
+        template<typename T>
+        using disable_for_allocator = std::enable_if_t<not is_allocator_v<T>>;
+        
+        template<typename allocator, typename T>
+        using rebind_alloc_t = typename std::allocator_traits<std::decay_t<allocator>>::template rebind_alloc<T>;
+        
+        /*
+            Constructs a container of the same type as `like` from `a...`, using the allocator of `like` when it has one,
+            so that results of a pmr source are allocated from the same memory resource. Views give a std::vector; a copy
+            of a view copies its elements.
+         */
+        template<typename container, typename... args>
+        owning_t<container> make_like(const container& like, args&&... a) {
+            if constexpr (is_view<container>::value and sizeof...(args) == 1 and (std::is_same_v<std::decay_t<args>, container> and ...))
+                return owning_t<container>(std::begin(a)..., std::end(a)...);
+            else if constexpr (is_view<container>::value)
+                return owning_t<container>(std::forward<args>(a)...);
+            else if constexpr (has_allocator<container>::value)
+                return container(std::forward<args>(a)..., like.get_allocator());
+            else
+                return container(std::forward<args>(a)...);
+        }
+        
         template<typename container>
         bool is_sorted(const container& c) {
             return std::is_sorted(std::begin(c), std::end(c));
@@ -21,20 +118,22 @@ namespace simlinq {
         }
         
         template<typename container>
-        auto copy_sort(container src) {
-            std::sort(std::begin(src), std::end(src));
-            return src;
+        auto copy_sort(const container& src) {
+            auto result = make_like(src, src);
+            std::sort(std::begin(result), std::end(result));
+            return result;
         }
         
         template<typename container, typename binary_predicate>
-        auto copy_sort(container src, binary_predicate&& comparer) {
-            std::sort(std::begin(src), std::end(src), comparer);
-            return src;
+        auto copy_sort(const container& src, binary_predicate&& comparer) {
+            auto result = make_like(src, src);
+            std::sort(std::begin(result), std::end(result), comparer);
+            return result;
         }
         
         template<typename container>
         inline auto distinct_impl(const container& f, const container& s) {
-            container r;
+            auto r = make_like(f);
             std::set_difference(std::begin(f), std::end(f),
                                 std::begin(s), std::end(s),
                                 std::back_inserter(r));
@@ -43,1047 +142,6724 @@ namespace simlinq {
         
         template<typename container, typename binary_predicate>
         inline auto distinct_impl(const container& f, const container& s, binary_predicate&& comparer) {
-            container r;
+            auto r = make_like(f);
             std::set_difference(std::begin(f), std::end(f),
                                 std::begin(s), std::end(s),
                                 std::back_inserter(r),
                                 comparer);
             return r;
         }
-
-    }
-    
-    
-
-    /*
-        Applies an accumulator function over a sequence. The specified seed value is used as the initial accumulator value, and the specified function is used to select the result value.
-    */
-    template<typename container, typename seed, typename accumulator, typename selector>
-    auto Aggregate(const container& src, seed&& s, accumulator&& acc, selector&& sel) {
-        decltype(acc) result(s);
-
-        for (const auto& value : src) {
-            acc(value, result);
-        }
-        return sel(result);
-    }
-
-
-    /*
-        Applies an accumulator function over a sequence. The specified seed value is used as the initial accumulator value.
-    */
-    template<typename container, typename seed, typename accumulator>
-    auto Aggregate(const container& src, seed&& s, accumulator&& acc) {
-        decltype(acc) result(s);
-
-        for (const auto& value : src) {
-            acc(value, result);
+        
+        /*
+            Selects the overloads that take ownership of a non-const rvalue container and reuse its storage. Views own no
+            storage, so temporaries of them go to the copying overloads.
+         */
+        template<typename container>
+        using enable_for_rvalue = std::enable_if_t<not std::is_reference_v<container> and not std::is_const_v<container> and
+                                                   not is_view<container>::value>;
+        
+        /*
+            std::set_difference / std::set_intersection writing into the first (sorted) range itself; the output never
+            overtakes the read position, so it can be compacted in place and erased behind.
+         */
+        template<typename container, typename sorted_range, typename binary_predicate>
+        void difference_in_place(container& f, const sorted_range& s, binary_predicate&& comparer) {
+            auto out = std::begin(f);
+            auto it = std::begin(f);
+            auto other = std::begin(s);
+            for (; it != std::end(f) and other != std::end(s);) {
+                if (comparer(*it, *other)) {
+                    *out++ = std::move(*it++);
+                } else {
+                    if (not comparer(*other, *it))
+                        ++it;
+                    ++other;
+                }
+            }
+            out = std::move(it, std::end(f), out);
+            f.erase(out, std::end(f));
         }
-        result;
-    }
-
-
-    /*
-        Applies an accumulator function over a sequence.
-    */
-    template <typename container, typename accumulator>
-    auto Aggregate(const container &c, accumulator &&acc) {
-        typename container::value_type result;
-
-        for (const auto &value : c)
-        {
-            acc(value, result);
+        
+        template<typename container, typename sorted_range, typename binary_predicate>
+        void intersection_in_place(container& f, const sorted_range& s, binary_predicate&& comparer) {
+            auto out = std::begin(f);
+            auto it = std::begin(f);
+            auto other = std::begin(s);
+            while (it != std::end(f) and other != std::end(s)) {
+                if (comparer(*it, *other)) {
+                    ++it;
+                } else {
+                    if (not comparer(*other, *it))
+                        *out++ = std::move(*it++);
+                    ++other;
+                }
+            }
+            f.erase(out, std::end(f));
         }
 
-        return result;
-    }
-
-
-    /*
-        Appends a value to the end of the sequence.
-    */
-    template <typename container>
-    void Append(container &c, typename container::value_type &value) {
-        // TODO: this is bad container-specific implementation; should be rewritten.
-        c.push_back(value);
     }
-
-
+    
+    
     /*
-        Computes the average of a sequence.
-    */
-    template <typename container, typename result_type = typename container::value_type>
-    result_type Average(const container &c) {
-        if (std::begin(c) == std::end(c))
-            throw std::invalid_argument("Average: an empty array");
-
-        result_type result;
-        for (const auto &value : c)
-        {
-            result += c;
+        Monotonic arena for query results.
+        
+        Operators that build a container of the source type allocate it with the allocator of the source, and the
+        operators creating a new element type take an optional allocator. A chain of queries over std::pmr containers
+        backed by one arena therefore never touches the global heap until the arena runs out of its initial buffer;
+        memory is returned all at once by `release()` or by destroying the arena. Individual deallocations are no-ops.
+        
+            simlinq::arena a;
+            std::pmr::vector<int> values(a.allocator<int>());
+            auto even = simlinq::Where(values, pred);   // allocated from `a`
+     */
+    class arena {
+    public:
+        explicit arena(size_t initial_size = 4096,
+                       std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : resource_(initial_size, upstream) {}
+        
+        /* the first allocations are served from a caller-provided buffer, e.g. on the stack */
+        arena(void* buffer, size_t size,
+              std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : resource_(buffer, size, upstream) {}
+        
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+        
+        template<typename T = std::byte>
+        std::pmr::polymorphic_allocator<T> allocator() {
+            return std::pmr::polymorphic_allocator<T>(&resource_);
         }
-        result /= std::size(c);
-        return result;
-    }
-
-
-    /*
-        Computes the average of a sequence that are obtained by invoking a transform function on each element of the input sequence.
-    */
-    template <typename container, typename transform>
-    auto Average(const container &src, transform &&trans) {
-        using optional_type = std::optional<decltype(trans)>;
-
-        if (std::begin(src) == std::end(src)) {
-            return optional_type();
+        
+        std::pmr::memory_resource* resource() {
+            return &resource_;
         }
-
-        decltype(trans) result;
-        for (const auto &value : src)
-        {
-            result += trans(src);
+        
+        /* frees everything allocated so far; containers using the arena must not be used afterwards */
+        void release() {
+            resource_.release();
         }
-        result /= std::size(src);
-        return optional_type(result);
-    }
-
-
-    /*
-        Casts the elements of an IEnumerable to the specified type.
-    */
-    template<typename cast_type, typename container> 
-    auto Cast(const container& src) {
-        std::vector<cast_type> result;
-
-        std::transform(std::begin(src),
-                       std::end(src),
-                       std::begin(result),
-                       [](const auto& value) { return static_cast<cast_type>(value); }
-                       );
-        return result;
-    }
-
+        
+    private:
+        std::pmr::monotonic_buffer_resource resource_;
+    };
+    
     
     /*
-        Returns the elements of the specified sequence or the type parameter's default value in a singleton collection if the sequence is empty.
+        Executors.
+        
+        Parallel operators hand all chunks but the first to an executor, process the first on the calling thread and
+        then call run_pending until every chunk is done, so a waiting caller never idles and nested parallel calls
+        cannot deadlock. Every submitted task must eventually run, on a thread of the executor or in run_pending.
      */
-    template<typename container>
-    auto DefaultIfEmpty(const container& src) {
-        return std::size(src) != 0
-            ? src
-            : container({ typename container::value_type{} });
-    }
+    class executor {
+    public:
+        virtual ~executor() = default;
+        
+        /* threads running submitted tasks, not counting the callers that help */
+        virtual size_t concurrency() const = 0;
+        
+        virtual void submit(std::function<void()> task) = 0;
+        
+        /* runs one queued task on the calling thread, if there is one */
+        virtual bool run_pending() { return false; }
+    };
     
     
     /*
-        Returns the elements of the specified sequence or the specified value in a singleton collection if the sequence is empty.
+        Execution policies.
+        
+        Operators that accept a policy as their first argument run either serially (`seq`) or split a
+        random-access input into chunks processed on an executor, by default the library thread pool (`par`).
+        Inputs shorter than the policy threshold are always processed serially. Callables passed to parallel
+        operators are invoked concurrently and must be thread-safe.
      */
-    template<typename container>
-    auto DefaultIfEmpty(const container& src, typename container::value_type value) {
-        return std::size(src) != 0
-            ? src
-            : container({ value });
-    }
-
+    struct sequenced_policy {};
     
-    /*
-        Returns distinct elements from a sequence by using the default equality comparer to compare values.
-     */
-    template<typename container>
-    auto Distinct(const container& first, const container& second) {
-        using namespace detail;
+    struct parallel_policy {
+        /* inputs with fewer elements than this are processed serially */
+        size_t threshold = size_t(1) << 15;
         
-        if (is_sorted(first) and is_sorted(second)) {
-            return distinct_impl(first, second);
+        /* elements per chunk at least; 0 derives it from `cost` */
+        size_t grain = 0;
+        
+        /* cost of the callable per element, relative to an addition or a comparison */
+        double cost = 1;
+        
+        /* where the chunks run; null for the default executor */
+        executor* exec = nullptr;
+        
+        constexpr parallel_policy with_threshold(size_t value) const {
+            auto result = *this;
+            result.threshold = value;
+            return result;
         }
         
-        return distinct_impl( copy_sort(first),
-                              copy_sort(second));
-    }
+        constexpr parallel_policy with_grain(size_t value) const {
+            auto result = *this;
+            result.grain = value;
+            return result;
+        }
+        
+        constexpr parallel_policy with_cost(double value) const {
+            auto result = *this;
+            result.cost = value;
+            return result;
+        }
+        
+        constexpr parallel_policy on(executor& e) const {
+            auto result = *this;
+            result.exec = &e;
+            return result;
+        }
+    };
     
+    inline constexpr sequenced_policy seq{};
+    inline constexpr parallel_policy par{};
     
-    /*
-        Returns distinct elements from a sequence by using a specified IEqualityComparer<T> to compare values.
-     */
-    template<typename container, typename binary_predicate>
-    auto Distinct(const container& first, const container& second, binary_predicate&& comparer) {
-        using namespace detail;
+    template<typename T>
+    struct is_execution_policy : std::false_type {};
+    
+    template<>
+    struct is_execution_policy<sequenced_policy> : std::true_type {};
+    
+    template<>
+    struct is_execution_policy<parallel_policy> : std::true_type {};
+    
+    template<typename T>
+    inline constexpr bool is_execution_policy_v = is_execution_policy<std::decay_t<T>>::value;
+    
+    
+    namespace detail {
         
-        if (is_sorted(first, comparer) and is_sorted(second, comparer)) {
-            return distinct_impl(first, second, comparer);
+        template<typename T>
+        using enable_for_policy = std::enable_if_t<is_execution_policy_v<T>>;
+        
+        template<typename T>
+        using disable_for_policy = std::enable_if_t<not is_execution_policy_v<T>>;
+        
+        /*
+            Iterator category of a sequence. Operators dispatch on it at compile time: constant-time positioning for
+            random-access sequences, reverse scans for bidirectional ones, single forward walks otherwise.
+         */
+        template<typename container>
+        using iterator_category_t = typename std::iterator_traits<
+            decltype(std::begin(std::declval<const container&>()))>::iterator_category;
+        
+        template<typename container>
+        inline constexpr bool is_random_access_v = std::is_base_of_v<std::random_access_iterator_tag,
+                                                                     iterator_category_t<container>>;
+        
+        template<typename container>
+        inline constexpr bool is_bidirectional_v = std::is_base_of_v<std::bidirectional_iterator_tag,
+                                                                     iterator_category_t<container>>;
+        
+        template<typename container, typename = void>
+        struct is_sized : std::false_type {};
+        
+        template<typename container>
+        struct is_sized<container, std::void_t<decltype(std::size(std::declval<const container&>()))>> : std::true_type {};
+        
+        template<typename container, typename = void>
+        struct has_push_back : std::false_type {};
+        
+        template<typename container>
+        struct has_push_back<container, std::void_t<decltype(std::declval<container&>().push_back(
+                                                        std::declval<const typename container::value_type&>()))>>
+            : std::true_type {};
+        
+        /* whether a range of elements can be erased in place; std::forward_list only has erase_after */
+        template<typename container, typename = void>
+        struct has_range_erase : std::false_type {};
+        
+        template<typename container>
+        struct has_range_erase<container, std::void_t<decltype(std::declval<container&>().erase(
+                                                          std::begin(std::declval<container&>()), std::end(std::declval<container&>())))>>
+            : std::true_type {};
+        
+        template<typename container>
+        auto as_vector(const container& src) {
+            using value_type = typename std::iterator_traits<decltype(std::begin(src))>::value_type;
+            return std::vector<value_type>(std::begin(src), std::end(src));
+        }
+        
+        /*
+            Runs an in-place operator on a std::vector copy of a sequence that cannot erase a range itself, e.g.
+            std::forward_list, and moves the result back into the type of the sequence, with its allocator.
+         */
+        template<typename container, typename operation>
+        container through_vector(const container& src, operation&& op) {
+            auto result = op(as_vector(src));
+            return make_like(src, std::make_move_iterator(std::begin(result)), std::make_move_iterator(std::end(result)));
+        }
+        
+        /* number of elements; counted for sequences that do not store it, e.g. std::forward_list */
+        template<typename container>
+        size_t size_of(const container& src) {
+            if constexpr (is_sized<container>::value)
+                return static_cast<size_t>(std::size(src));
+            else
+                return static_cast<size_t>(std::distance(std::begin(src), std::end(src)));
+        }
+        
+        /* `first` advanced by `count` elements, stopping at `last`: in constant time for random-access iterators */
+        template<typename iterator>
+        iterator advance_within(iterator first, iterator last, size_t count) {
+            if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                            typename std::iterator_traits<iterator>::iterator_category>) {
+                return first + static_cast<std::ptrdiff_t>(std::min<size_t>(count, static_cast<size_t>(last - first)));
+            } else {
+                for (; count != 0 and first != last; --count)
+                    ++first;
+                return first;
+            }
+        }
+        
+        /* iterator to the element at `index`, or the end of the sequence if it is shorter */
+        template<typename container>
+        auto element_at(const container& src, size_t index) {
+            return advance_within(std::begin(src), std::end(src), index);
+        }
+        
+        /* iterator to the last element of a non-empty sequence */
+        template<typename container>
+        auto last_element(const container& src) {
+            if constexpr (is_bidirectional_v<container>) {
+                return std::prev(std::end(src));
+            } else {
+                auto last = std::begin(src);
+                for (auto it = last; ++it != std::end(src);)
+                    last = it;
+                return last;
+            }
+        }
+        
+        /* iterator to the last element that satisfies a condition, or the end of the sequence */
+        template<typename container, typename unary_predicate>
+        auto find_last_if(const container& src, unary_predicate& condition) {
+            if constexpr (is_bidirectional_v<container>) {
+                auto found = std::find_if(std::rbegin(src), std::rend(src), condition);
+                return found == std::rend(src) ? std::end(src) : std::prev(found.base());
+            } else {
+                auto found = std::end(src);
+                for (auto it = std::begin(src); it != std::end(src); ++it)
+                    if (condition(*it))
+                        found = it;
+                return found;
+            }
+        }
+        
+        /* iterator to the only element that satisfies a condition, or the end of the sequence; stops at a second match */
+        template<typename container, typename unary_predicate>
+        auto find_single_if(const container& src, unary_predicate& condition) {
+            const auto found = std::find_if(std::begin(src), std::end(src), condition);
+            if (found == std::end(src) or std::find_if(std::next(found), std::end(src), condition) != std::end(src))
+                return std::end(src);
+            return found;
+        }
+        
+        /* whether a sequence has exactly one element */
+        template<typename container>
+        bool has_single(const container& src) {
+            if constexpr (is_sized<container>::value)
+                return std::size(src) == 1;
+            else
+                return std::begin(src) != std::end(src) and std::next(std::begin(src)) == std::end(src);
+        }
+        
+        
+        /* the pool and queue index of the calling thread when it is a pool worker */
+        struct worker_identity {
+            const void* pool = nullptr;
+            size_t index = 0;
+        };
+        
+        inline worker_identity& this_worker() {
+            static thread_local worker_identity identity;
+            return identity;
+        }
+        
+        /* best effort: a core that does not exist or is not allowed leaves the thread where the system put it */
+        inline void pin_thread(std::thread& thread, unsigned core) {
+#if defined(__linux__)
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            CPU_SET(core, &cores);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(cores), &cores);
+#else
+            (void)thread;
+            (void)core;
+#endif
         }
         
-        return distinct_impl( copy_sort(first, comparer),
-                              copy_sort(second, comparer),
-                              comparer);
     }
     
     
-    /*
-        Returns the element at a specified index in a sequence.
-     */
-    template<typename container>
-    auto ElementAt(const container& src, int index) {
-        using optional_type = std::optional<typename container::value_type>;
+    struct thread_pool_options {
+        /* worker threads; the callers of parallel operators always take part as well, so one hardware thread is left for them */
+        size_t workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
         
-        return (index < std::size(src) and index >= 0)
-            ? optional_type(*(std::begin(src) + index))
-            : optional_type();
-    }
+        /*
+            Cores the workers are pinned to, worker i to cores[i % cores.size()]; empty leaves placement to the system.
+            Listing the cores of one NUMA node keeps the workers, and the pages they touch first, on that node.
+            Pinning is only supported on Linux and ignored elsewhere.
+         */
+        std::vector<unsigned> cores;
+    };
     
     
     /*
-        Returns the element at a specified index in a sequence or a default value if the index is out of range.
+        Work-stealing thread pool. Every worker owns a deque: tasks a worker submits go to the back of its own deque and
+        are taken back from there, so nested work runs while its data is still in cache; idle workers and waiting callers
+        steal from the front of the other deques. Tasks submitted from outside the pool are spread over the deques round
+        robin. Workers sleep while nothing is queued. Queued tasks are still run by the destructor's join.
      */
-    template<typename container>
-    auto ElementAtOrDefault(const container& src, int index) {
-        return (index < std::size(src) and index >= 0)
-            ? *(std::begin(src) + index)
-            : typename container::value_type();
-    }
-    
-    
-    /*
-        Returns the first element of a sequence.
-    */
-    template <typename container>
-    auto First(const container &src) {
-        using optional_type = std::optional<typename container::value_type>;
+    class thread_pool : public executor {
+    public:
+        explicit thread_pool(const thread_pool_options& options = {})
+            : queues_(new queue[options.workers]), queue_count_(options.workers) {
+            threads_.reserve(options.workers);
+            for (size_t i = 0; i < options.workers; ++i) {
+                threads_.emplace_back([this, i] { work(i); });
+                if (not options.cores.empty())
+                    detail::pin_thread(threads_.back(), options.cores[i % options.cores.size()]);
+            }
+        }
+        
+        ~thread_pool() override {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& thread : threads_)
+                thread.join();
+        }
+        
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        
+        size_t concurrency() const override { return threads_.size(); }
+        
+        void submit(std::function<void()> task) override {
+            if (queue_count_ == 0) {
+                task();
+                return;
+            }
+            
+            const auto& self = detail::this_worker();
+            const size_t index = self.pool == this ? self.index : next_.fetch_add(1, std::memory_order_relaxed) % queue_count_;
+            
+            /* counted before it is visible, so the count never drops below zero; a thief may briefly see a task that is not there yet */
+            queued_.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(queues_[index].mutex);
+                queues_[index].tasks.push_back(std::move(task));
+            }
+            if (sleeping_.load() != 0) {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                wake_.notify_one();
+            }
+        }
+        
+        bool run_pending() override {
+            const auto& self = detail::this_worker();
+            const bool own = self.pool == this;
+            
+            std::function<void()> task;
+            if (not take(own ? self.index : next_.load(std::memory_order_relaxed), own, task))
+                return false;
+            task();
+            return true;
+        }
+        
+    private:
+        struct queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        
+        /* the back of the own deque first, then the fronts of the others */
+        bool take(size_t index, bool own, std::function<void()>& task) {
+            if (queued_.load(std::memory_order_relaxed) == 0)
+                return false;
+            
+            for (size_t k = 0; k < queue_count_; ++k) {
+                auto& victim = queues_[(index + k) % queue_count_];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.tasks.empty())
+                    continue;
+                
+                if (k == 0 and own) {
+                    task = std::move(victim.tasks.back());
+                    victim.tasks.pop_back();
+                } else {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                }
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+        
+        void work(size_t index) {
+            detail::this_worker() = detail::worker_identity{ this, index };
+            for (;;) {
+                std::function<void()> task;
+                if (take(index, true, task)) {
+                    task();
+                    continue;
+                }
+                
+                /* sleeping_ is raised before queued_ is checked and submit checks them the other way round, so a wakeup is never lost */
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                sleeping_.fetch_add(1);
+                wake_.wait(lock, [this] { return stop_ or queued_.load() != 0; });
+                sleeping_.fetch_sub(1);
+                if (stop_ and queued_.load() == 0)
+                    return;
+            }
+        }
+        
+        std::unique_ptr<queue[]> queues_;
+        size_t queue_count_;
+        std::vector<std::thread> threads_;
+        std::atomic<size_t> queued_{ 0 };
+        std::atomic<size_t> sleeping_{ 0 };
+        std::atomic<size_t> next_{ 0 };
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        bool stop_ = false;
+    };
+    
+    
+    namespace detail {
+        
+        inline std::atomic<executor*>& default_executor_override() {
+            static std::atomic<executor*> override{ nullptr };
+            return override;
+        }
+        
+        inline thread_pool& default_pool() {
+            static thread_pool pool;
+            return pool;
+        }
+        
+    }
+    
+    
+    /*
+        Makes parallel operators whose policy names no executor run on `e`; nullptr restores the library pool.
+        The executor must outlive every parallel call that can reach it.
+     */
+    inline void set_default_executor(executor* e) {
+        detail::default_executor_override().store(e, std::memory_order_release);
+    }
+    
+    
+    namespace detail {
+        
+        inline executor& executor_of(const parallel_policy& p) {
+            if (p.exec != nullptr)
+                return *p.exec;
+            if (auto* e = default_executor_override().load(std::memory_order_acquire))
+                return *e;
+            return default_pool();
+        }
+        
+        /* threads working on a parallel call: the executor's and the caller */
+        inline size_t thread_count(const parallel_policy& p) {
+            return executor_of(p).concurrency() + 1;
+        }
+        
+        
+        /* Work, in units of one cheap per-element operation, that makes a task worth queueing. */
+        inline constexpr size_t parallel_grain = size_t(1) << 12;
+        
+        /* Chunks per thread: threads that finish early steal the remaining ones instead of idling. */
+        inline constexpr size_t parallel_oversplit = 4;
+        
+        inline size_t grain_size(const parallel_policy& p) {
+            if (p.grain != 0)
+                return p.grain;
+            const double grain = static_cast<double>(parallel_grain) / std::max(p.cost, 1.0 / parallel_grain);
+            return std::max<size_t>(1, static_cast<size_t>(grain));
+        }
+        
+        inline size_t chunk_count(const parallel_policy& p, size_t count) {
+            const size_t grain = grain_size(p);
+            if (count < p.threshold or count < 2 * grain)
+                return 1;
+            const size_t threads = thread_count(p);
+            if (threads < 2)
+                return 1;
+            return std::min(threads * parallel_oversplit, count / grain);
+        }
+        
+        
+        /*
+            Splits [0, count) into `chunks` contiguous parts and calls func(chunk, begin, end) for each of them.
+            The other chunks are submitted to `exec`; the calling thread processes the first one, helps with queued tasks
+            and then blocks until all chunks are done. The first exception thrown by any chunk is rethrown to the caller.
+         */
+        template<typename chunk_function>
+        void parallel_chunks(executor& exec, size_t count, size_t chunks, chunk_function&& func) {
+            size_t pending = chunks - 1;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable done;
+            
+            auto run = [&](size_t chunk) {
+                try {
+                    func(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (not error)
+                        error = std::current_exception();
+                }
+            };
+            
+            for (size_t chunk = 1; chunk < chunks; ++chunk) {
+                exec.submit([&run, &pending, &mutex, &done, chunk] {
+                    run(chunk);
+                    /* notified under the lock: the caller cannot see the count drop and return while it is still in use */
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--pending == 0)
+                        done.notify_all();
+                });
+            }
+            run(0);
+            
+            /* helps while the executor has queued tasks, then sleeps until the chunks running elsewhere are done */
+            std::unique_lock<std::mutex> lock(mutex);
+            while (pending != 0) {
+                lock.unlock();
+                const bool helped = exec.run_pending();
+                lock.lock();
+                if (not helped)
+                    done.wait(lock, [&pending] { return pending == 0; });
+            }
+            
+            if (error)
+                std::rethrow_exception(error);
+        }
+        
+        
+        /*
+            Reduces every chunk of a random-access sequence with reduce(first, last) and folds the partial results
+            with combine. Returns nullopt when the input should be processed serially.
+         */
+        template<typename policy, typename container, typename chunk_reduce, typename combine>
+        auto parallel_reduce(const policy& p, const container& src, chunk_reduce&& reduce, combine&& comb)
+            -> std::optional<std::decay_t<decltype(reduce(std::begin(src), std::end(src)))>> {
+            using result_type = std::decay_t<decltype(reduce(std::begin(src), std::end(src)))>;
+            
+            if constexpr (not std::is_same_v<policy, parallel_policy> or not is_random_access_v<container>) {
+                return std::nullopt;
+            } else {
+                const size_t count = std::size(src);
+                const size_t chunks = chunk_count(p, count);
+                if (chunks < 2)
+                    return std::nullopt;
+                
+                const auto first = std::begin(src);
+                std::vector<std::optional<result_type>> partials(chunks);
+                parallel_chunks(executor_of(p), count, chunks, [&](size_t chunk, size_t b, size_t e) {
+                    partials[chunk].emplace(reduce(first + b, first + e));
+                });
+                
+                result_type result = std::move(*partials[0]);
+                for (size_t chunk = 1; chunk < chunks; ++chunk)
+                    result = comb(std::move(result), std::move(*partials[chunk]));
+                return result;
+            }
+        }
+        
+        
+        /*
+            Checks whether any element of a random-access sequence satisfies the condition. Workers scan their chunk
+            block by block and give up as soon as any of them has found a match.
+            Returns nullopt when the input should be processed serially.
+         */
+        template<typename policy, typename container, typename unary_predicate>
+        std::optional<bool> parallel_any(const policy& p, const container& src, unary_predicate&& condition) {
+            if constexpr (not std::is_same_v<policy, parallel_policy> or not is_random_access_v<container>) {
+                return std::nullopt;
+            } else {
+                const size_t count = std::size(src);
+                const size_t chunks = chunk_count(p, count);
+                if (chunks < 2)
+                    return std::nullopt;
+                
+                constexpr size_t block = 1024;
+                const auto first = std::begin(src);
+                std::atomic<bool> found(false);
+                parallel_chunks(executor_of(p), count, chunks, [&](size_t, size_t b, size_t e) {
+                    for (; b < e and not found.load(std::memory_order_relaxed); b += block) {
+                        const auto block_end = first + std::min(b + block, e);
+                        if (std::any_of(first + b, block_end, condition)) {
+                            found.store(true, std::memory_order_relaxed);
+                            return;
+                        }
+                    }
+                });
+                return found.load();
+            }
+        }
+        
+        
+        /*
+            Position of the only element of a random-access sequence that satisfies the condition, or the size of the
+            sequence if there are none or several. Every worker stops once two matches have been seen in total.
+            Returns nullopt when the input should be processed serially.
+         */
+        template<typename policy, typename container, typename unary_predicate>
+        std::optional<size_t> parallel_find_single(const policy& p, const container& src, unary_predicate&& condition) {
+            if constexpr (not std::is_same_v<policy, parallel_policy> or not is_random_access_v<container>) {
+                return std::nullopt;
+            } else {
+                const size_t count = std::size(src);
+                const size_t chunks = chunk_count(p, count);
+                if (chunks < 2)
+                    return std::nullopt;
+                
+                const auto first = std::begin(src);
+                std::atomic<size_t> matches(0);
+                std::atomic<size_t> position(count);
+                parallel_chunks(executor_of(p), count, chunks, [&](size_t, size_t b, size_t e) {
+                    for (; b < e and matches.load(std::memory_order_relaxed) < 2; b += parallel_grain) {
+                        const auto block_end = first + std::min(b + parallel_grain, e);
+                        for (auto it = std::find_if(first + b, block_end, condition);
+                             it != block_end;
+                             it = std::find_if(it + 1, block_end, condition)) {
+                            if (matches.fetch_add(1, std::memory_order_relaxed) != 0)
+                                return;
+                            position.store(static_cast<size_t>(it - first), std::memory_order_relaxed);
+                        }
+                    }
+                });
+                return matches.load() == 1 ? position.load() : count;
+            }
+        }
+        
+        
+        /*
+            Position of the last element of a random-access sequence that satisfies the condition, or the size of the
+            sequence if there is none. Workers scan their chunk from its end and give up as soon as a later chunk has
+            found a match. Returns nullopt when the input should be processed serially.
+         */
+        template<typename policy, typename container, typename unary_predicate>
+        std::optional<size_t> parallel_find_last(const policy& p, const container& src, unary_predicate&& condition) {
+            if constexpr (not std::is_same_v<policy, parallel_policy> or not is_random_access_v<container>) {
+                return std::nullopt;
+            } else {
+                const size_t count = std::size(src);
+                const size_t chunks = chunk_count(p, count);
+                if (chunks < 2)
+                    return std::nullopt;
+                
+                const auto first = std::begin(src);
+                std::vector<size_t> found(chunks, count);
+                /* one past the highest chunk with a match */
+                std::atomic<size_t> decided(0);
+                parallel_chunks(executor_of(p), count, chunks, [&](size_t chunk, size_t b, size_t e) {
+                    while (e > b and decided.load(std::memory_order_relaxed) <= chunk) {
+                        const size_t block_begin = e - std::min(parallel_grain, e - b);
+                        const auto rfound = std::find_if(std::make_reverse_iterator(first + e),
+                                                         std::make_reverse_iterator(first + block_begin),
+                                                         condition);
+                        if (rfound != std::make_reverse_iterator(first + block_begin)) {
+                            found[chunk] = static_cast<size_t>(rfound.base() - first) - 1;
+                            size_t current = decided.load(std::memory_order_relaxed);
+                            while (current <= chunk and not decided.compare_exchange_weak(current, chunk + 1))
+                                ;
+                            return;
+                        }
+                        e = block_begin;
+                    }
+                });
+                
+                for (size_t chunk = chunks; chunk-- > 0;)
+                    if (found[chunk] != count)
+                        return found[chunk];
+                return count;
+            }
+        }
+        
+        
+        /*
+            Number of elements of the first run among the first k elements of the stable merge of two sorted runs.
+         */
+        template<typename first_iterator, typename second_iterator, typename compare>
+        size_t merge_split(first_iterator a, size_t na, second_iterator b, size_t nb, size_t k, compare& less) {
+            size_t lo = k > nb ? k - nb : 0;
+            size_t hi = std::min(k, na);
+            while (lo < hi) {
+                const size_t i = lo + (hi - lo) / 2;
+                if (not less(b[k - i - 1], a[i]))
+                    lo = i + 1;
+                else
+                    hi = i;
+            }
+            return lo;
+        }
+        
+        
+        /*
+            Merges neighbouring runs of `from` into `to`, returning the new run boundaries. Every merge is cut into parts
+            of about `part` output elements at the points given by merge_split, so the last rounds, with few long runs,
+            keep all workers busy too. All the cuts are found before any element is moved.
+         */
+        template<typename source, typename destination, typename compare>
+        std::vector<size_t> merge_runs(executor& exec, source from, destination to, const std::vector<size_t>& runs, size_t part, compare& less) {
+            struct job {
+                size_t first, middle, last, begin, end, first_taken, last_taken;
+            };
+            
+            std::vector<job> jobs;
+            std::vector<size_t> merged{ 0 };
+            for (size_t r = 0; r + 1 < runs.size(); r += 2) {
+                const size_t first = runs[r];
+                const size_t middle = runs[r + 1];
+                const size_t last = r + 2 < runs.size() ? runs[r + 2] : middle;
+                size_t taken = 0;
+                for (size_t k = 0; k < last - first; k += part) {
+                    const size_t end = std::min(k + part, last - first);
+                    const size_t end_taken = merge_split(from + first, middle - first, from + middle, last - middle, end, less);
+                    jobs.push_back(job{ first, middle, last, k, end, taken, end_taken });
+                    taken = end_taken;
+                }
+                merged.push_back(last);
+            }
+            
+            parallel_chunks(exec, jobs.size(), jobs.size(), [&](size_t j, size_t, size_t) {
+                const job& w = jobs[j];
+                const auto a = from + w.first;
+                const auto b = from + w.middle;
+                std::merge(std::make_move_iterator(a + w.first_taken), std::make_move_iterator(a + w.last_taken),
+                           std::make_move_iterator(b + (w.begin - w.first_taken)), std::make_move_iterator(b + (w.end - w.last_taken)),
+                           to + w.first + w.begin,
+                           less);
+            });
+            return merged;
+        }
+        
+        
+        /*
+            Merge sort of a random-access range on the thread pool: the chunks are sorted concurrently, then merged in
+            rounds between the range and a buffer. The merges are stable, so the whole sort is stable when the chunks are
+            sorted with std::stable_sort. The merges assign into the buffer, so its elements are default-constructed up
+            front; ranges of types that are not default-constructible are left to the serial sort. Returns false when the
+            range should be sorted serially.
+         */
+        template<typename iterator, typename compare>
+        bool parallel_sort(const parallel_policy& p, iterator first, size_t count, compare less, bool stable) {
+            using value_type = typename std::iterator_traits<iterator>::value_type;
+            
+            /* one run per thread: more would only add merge rounds */
+            const size_t chunks = std::min(chunk_count(p, count), thread_count(p));
+            if constexpr (not std::is_default_constructible_v<value_type>) {
+                return false;
+            } else {
+                if (chunks < 2)
+                    return false;
+                
+                std::vector<size_t> runs(chunks + 1);
+                for (size_t c = 0; c <= chunks; ++c)
+                    runs[c] = count * c / chunks;
+                
+                parallel_chunks(executor_of(p), chunks, chunks, [&](size_t c, size_t, size_t) {
+                    if (stable)
+                        std::stable_sort(first + runs[c], first + runs[c + 1], less);
+                    else
+                        std::sort(first + runs[c], first + runs[c + 1], less);
+                });
+                
+                /* default-initialized: trivial types are left uninitialized, others are constructed one by one before the first merge */
+                std::unique_ptr<value_type[]> buffer(new value_type[count]);
+                const size_t part = (count + chunks - 1) / chunks;
+                bool in_buffer = false;
+                while (runs.size() > 2) {
+                    runs = in_buffer
+                        ? merge_runs(executor_of(p), buffer.get(), first, runs, part, less)
+                        : merge_runs(executor_of(p), first, buffer.get(), runs, part, less);
+                    in_buffer = not in_buffer;
+                }
+                
+                if (in_buffer) {
+                    parallel_chunks(executor_of(p), count, chunks, [&](size_t, size_t b, size_t e) {
+                        std::move(buffer.get() + b, buffer.get() + e, first + b);
+                    });
+                }
+                return true;
+            }
+        }
+        
+    }
+    
+    
+    namespace detail {
+        
+        template<typename container>
+        using value_type_t = typename std::iterator_traits<decltype(std::begin(std::declval<const container&>()))>::value_type;
+        
+        
+        /* storage of the keys of a flat_index: std::vector<bool> packs bits and cannot hand out references to its elements */
+        template<typename key>
+        using key_storage_t = std::conditional_t<std::is_same_v<key, bool>, std::deque<bool>, std::vector<key>>;
+        
+        
+        /*
+            Open-addressing hash index that maps keys to dense ids 0..size()-1 in insertion order.
+            Keys are stored contiguously; the slot array only keeps a hash tag and the key id, so probing
+            touches a single flat array. At most 2^32 - 1 distinct keys are supported.
+         */
+        template<typename key, typename hash = std::hash<key>, typename key_equal = std::equal_to<key>>
+        class flat_index {
+        public:
+            static constexpr size_t npos = size_t(-1);
+            
+            explicit flat_index(hash h = hash(), key_equal eq = key_equal())
+                : hasher_(std::move(h)), equal_(std::move(eq)) {}
+            
+            size_t size() const { return keys_.size(); }
+            const key_storage_t<key>& keys() const { return keys_; }
+            const key& operator[](size_t id) const { return keys_[id]; }
+            
+            void reserve(size_t count) {
+                if constexpr (not std::is_same_v<key, bool>)
+                    keys_.reserve(count);
+                if (2 * count > slots_.size())
+                    rehash(capacity_for(count));
+            }
+            
+            size_t find(const key& k) const {
+                if (slots_.empty())
+                    return npos;
+                
+                const auto h = mix(k);
+                const auto tag = static_cast<uint32_t>(h >> 32);
+                const auto mask = slots_.size() - 1;
+                for (auto pos = static_cast<size_t>(h) & mask; ; pos = (pos + 1) & mask) {
+                    const auto& s = slots_[pos];
+                    if (s.id == empty)
+                        return npos;
+                    if (s.tag == tag and equal_(keys_[s.id], k))
+                        return s.id;
+                }
+            }
+            
+            /* Returns the id of the key and whether it has just been added. */
+            template<typename K>
+            std::pair<size_t, bool> insert(K&& k) {
+                if (2 * (keys_.size() + 1) > slots_.size())
+                    rehash(capacity_for(keys_.size() + 1));
+                
+                const auto h = mix(k);
+                const auto tag = static_cast<uint32_t>(h >> 32);
+                const auto mask = slots_.size() - 1;
+                auto pos = static_cast<size_t>(h) & mask;
+                for (; slots_[pos].id != empty; pos = (pos + 1) & mask) {
+                    const auto& s = slots_[pos];
+                    if (s.tag == tag and equal_(keys_[s.id], k))
+                        return { s.id, false };
+                }
+                
+                slots_[pos] = slot{ tag, static_cast<uint32_t>(keys_.size()) };
+                keys_.emplace_back(std::forward<K>(k));
+                return { keys_.size() - 1, true };
+            }
+            
+        private:
+            struct slot {
+                uint32_t tag;
+                uint32_t id;
+            };
+            
+            static constexpr uint32_t empty = uint32_t(-1);
+            
+            /* keeps the load factor at or below 1/2 */
+            static size_t capacity_for(size_t count) {
+                size_t capacity = 16;
+                while (capacity < 2 * count)
+                    capacity *= 2;
+                return capacity;
+            }
+            
+            /* std::hash is the identity for integers on common implementations, so the bits are mixed before masking */
+            template<typename K>
+            uint64_t mix(const K& k) const {
+                auto h = static_cast<uint64_t>(hasher_(k));
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                h *= 0xc4ceb9fe1a85ec53ULL;
+                h ^= h >> 33;
+                return h;
+            }
+            
+            void rehash(size_t capacity) {
+                slots_.assign(capacity, slot{ 0, empty });
+                const auto mask = capacity - 1;
+                for (size_t id = 0; id < keys_.size(); ++id) {
+                    const auto h = mix(keys_[id]);
+                    auto pos = static_cast<size_t>(h) & mask;
+                    while (slots_[pos].id != empty)
+                        pos = (pos + 1) & mask;
+                    slots_[pos] = slot{ static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(id) };
+                }
+            }
+            
+            hash hasher_;
+            key_equal equal_;
+            key_storage_t<key> keys_;
+            std::vector<slot> slots_;
+        };
+        
+        
+        /* Read-only range over elements referenced by a contiguous block of pointers. */
+        template<typename T>
+        class indirect_range {
+        public:
+            using value_type = T;
+            
+            class iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type        = T;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = const T&;
+                using pointer           = const T*;
+                
+                iterator() = default;
+                explicit iterator(const T* const* it) : it_(it) {}
+                
+                reference operator*() const { return **it_; }
+                pointer operator->() const { return *it_; }
+                reference operator[](difference_type n) const { return *it_[n]; }
+                
+                iterator& operator++() { ++it_; return *this; }
+                iterator operator++(int) { auto tmp = *this; ++it_; return tmp; }
+                iterator& operator--() { --it_; return *this; }
+                iterator operator--(int) { auto tmp = *this; --it_; return tmp; }
+                iterator& operator+=(difference_type n) { it_ += n; return *this; }
+                iterator& operator-=(difference_type n) { it_ -= n; return *this; }
+                iterator operator+(difference_type n) const { return iterator(it_ + n); }
+                iterator operator-(difference_type n) const { return iterator(it_ - n); }
+                difference_type operator-(const iterator& other) const { return it_ - other.it_; }
+                
+                bool operator==(const iterator& other) const { return it_ == other.it_; }
+                bool operator!=(const iterator& other) const { return it_ != other.it_; }
+                bool operator<(const iterator& other) const { return it_ < other.it_; }
+                bool operator>(const iterator& other) const { return it_ > other.it_; }
+                bool operator<=(const iterator& other) const { return it_ <= other.it_; }
+                bool operator>=(const iterator& other) const { return it_ >= other.it_; }
+                
+            private:
+                const T* const* it_ = nullptr;
+            };
+            
+            indirect_range() = default;
+            indirect_range(const T* const* first, const T* const* last)
+                : first_(first), last_(last) {}
+            
+            iterator begin() const { return iterator(first_); }
+            iterator end() const { return iterator(last_); }
+            size_t size() const { return static_cast<size_t>(last_ - first_); }
+            bool empty() const { return first_ == last_; }
+            const T& front() const { return **first_; }
+            const T& back() const { return *last_[-1]; }
+            const T& operator[](size_t n) const { return *first_[n]; }
+            
+        private:
+            const T* const* first_ = nullptr;
+            const T* const* last_ = nullptr;
+        };
+        
+        
+        /*
+            Pointers to the elements of a sequence bucketed by key id, built with a count-then-scatter pass:
+            the elements of group g are items[offsets[g]] .. items[offsets[g + 1]], in source order.
+         */
+        template<typename T>
+        struct pointer_groups {
+            std::vector<size_t> offsets;
+            std::vector<const T*> items;
+            
+            size_t size() const { return offsets.size() - 1; }
+            
+            indirect_range<T> operator[](size_t group) const {
+                return indirect_range<T>(items.data() + offsets[group],
+                                         items.data() + offsets[group + 1]);
+            }
+        };
+        
+        
+        /*
+            Buckets the elements of src by the id of their key in the index. With insert_keys new keys are
+            added to the index, otherwise elements whose key is not in the index are dropped.
+         */
+        template<bool insert_keys, typename index, typename container, typename key_selector>
+        auto group_pointers(index& idx, const container& src, key_selector& key_sel) {
+            using value_type = value_type_t<container>;
+            constexpr auto no_group = uint32_t(-1);
+            
+            std::vector<uint32_t> group_of;
+            group_of.reserve(std::size(src));
+            std::vector<size_t> counts(idx.size() + 1, 0);
+            
+            for (const auto& value : src) {
+                size_t group;
+                if constexpr (insert_keys) {
+                    group = idx.insert(key_sel(value)).first;
+                    if (group + 1 >= counts.size())
+                        counts.resize(group + 2, 0);
+                } else {
+                    group = idx.find(key_sel(value));
+                }
+                
+                if (group == index::npos) {
+                    group_of.push_back(no_group);
+                } else {
+                    group_of.push_back(static_cast<uint32_t>(group));
+                    ++counts[group + 1];
+                }
+            }
+            
+            pointer_groups<value_type> groups;
+            groups.offsets.resize(idx.size() + 1, 0);
+            for (size_t g = 0; g < idx.size(); ++g)
+                groups.offsets[g + 1] = groups.offsets[g] + counts[g + 1];
+            
+            groups.items.resize(groups.offsets.back());
+            std::vector<size_t> cursor(groups.offsets.begin(), groups.offsets.end() - 1);
+            size_t row = 0;
+            for (const auto& value : src) {
+                const auto group = group_of[row++];
+                if (group != no_group)
+                    groups.items[cursor[group]++] = std::addressof(value);
+            }
+            return groups;
+        }
+        
+        
+        /*
+            Build/probe hash join. The hash index is built over the keys of the smaller input; for every outer
+            element, in outer order, on_outer(outer_value, inner_group) is called with the range of matching
+            inner elements in inner order.
+         */
+        template<typename outer_container, typename inner_container,
+                 typename outer_key_selector, typename inner_key_selector,
+                 typename hash, typename key_equal, typename outer_function>
+        void hash_join(const outer_container& outer, const inner_container& inner,
+                       outer_key_selector& outer_key, inner_key_selector& inner_key,
+                       hash h, key_equal eq, outer_function&& on_outer) {
+            using key_type = std::decay_t<decltype(outer_key(*std::begin(outer)))>;
+            using index_type = flat_index<key_type, hash, key_equal>;
+            
+            index_type idx(std::move(h), std::move(eq));
+            
+            if (std::size(inner) <= std::size(outer)) {
+                idx.reserve(std::size(inner));
+                const auto groups = group_pointers<true>(idx, inner, inner_key);
+                
+                using group_type = decltype(groups[0]);
+                for (const auto& value : outer) {
+                    const auto group = idx.find(outer_key(value));
+                    on_outer(value, group == index_type::npos
+                                        ? group_type()
+                                        : groups[group]);
+                }
+            } else {
+                idx.reserve(std::size(outer));
+                std::vector<uint32_t> outer_groups;
+                outer_groups.reserve(std::size(outer));
+                for (const auto& value : outer)
+                    outer_groups.push_back(static_cast<uint32_t>(idx.insert(outer_key(value)).first));
+                
+                const auto groups = group_pointers<false>(idx, inner, inner_key);
+                
+                size_t row = 0;
+                for (const auto& value : outer)
+                    on_outer(value, groups[outer_groups[row++]]);
+            }
+        }
+        
+    }
+    
+    
+    /*
+        Hash and key equality functions used together to compare keys; the counterpart of IEqualityComparer<T>.
+     */
+    template<typename hash, typename key_equal>
+    struct equality_comparer {
+        hash hasher;
+        key_equal equal;
+    };
+    
+    template<typename hash, typename key_equal>
+    equality_comparer(hash, key_equal) -> equality_comparer<hash, key_equal>;
+    
+    
+    namespace detail {
+        
+        template<typename T>
+        struct is_equality_comparer : std::false_type {};
+        
+        template<typename hash, typename key_equal>
+        struct is_equality_comparer<equality_comparer<hash, key_equal>> : std::true_type {};
+        
+        template<typename T>
+        using disable_for_comparer = std::enable_if_t<not is_equality_comparer<std::decay_t<T>>::value>;
+        
+        
+        struct identity {
+            template<typename T>
+            const T& operator()(const T& value) const { return value; }
+        };
+        
+        
+        /* Contiguous read-only range of elements. */
+        template<typename T>
+        class element_range {
+        public:
+            using value_type     = T;
+            using iterator       = const T*;
+            using const_iterator = const T*;
+            
+            element_range() = default;
+            element_range(const T* first, const T* last)
+                : first_(first), last_(last) {}
+            
+            const T* begin() const { return first_; }
+            const T* end() const { return last_; }
+            size_t size() const { return static_cast<size_t>(last_ - first_); }
+            bool empty() const { return first_ == last_; }
+            const T& front() const { return *first_; }
+            const T& back() const { return last_[-1]; }
+            const T& operator[](size_t n) const { return first_[n]; }
+            
+        private:
+            const T* first_ = nullptr;
+            const T* last_ = nullptr;
+        };
+        
+    }
+    
+    
+    /*
+        Collection of keys each mapped to one or more values; the counterpart of ILookup<TKey,TElement>.
+        The elements of all groups live in one contiguous buffer ordered by group, groups are ordered by the
+        first occurrence of their key in the source.
+     */
+    template<typename key, typename element, typename hash = std::hash<key>, typename key_equal = std::equal_to<key>>
+    class lookup {
+    public:
+        using index_type = detail::flat_index<key, hash, key_equal>;
+        
+        class grouping : public detail::element_range<element> {
+        public:
+            grouping(const key* k, const element* first, const element* last)
+                : detail::element_range<element>(first, last), key_(k) {}
+            
+            const key& Key() const { return *key_; }
+            
+        private:
+            const key* key_;
+        };
+        
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = grouping;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = grouping;
+            using pointer           = void;
+            
+            iterator() = default;
+            iterator(const lookup* parent, size_t group)
+                : parent_(parent), group_(group) {}
+            
+            grouping operator*() const { return parent_->group(group_); }
+            grouping operator[](difference_type n) const { return parent_->group(group_ + n); }
+            
+            iterator& operator++() { ++group_; return *this; }
+            iterator operator++(int) { auto tmp = *this; ++group_; return tmp; }
+            iterator& operator--() { --group_; return *this; }
+            iterator operator--(int) { auto tmp = *this; --group_; return tmp; }
+            iterator& operator+=(difference_type n) { group_ += n; return *this; }
+            iterator& operator-=(difference_type n) { group_ -= n; return *this; }
+            iterator operator+(difference_type n) const { return iterator(parent_, group_ + n); }
+            iterator operator-(difference_type n) const { return iterator(parent_, group_ - n); }
+            difference_type operator-(const iterator& other) const {
+                return static_cast<difference_type>(group_) - static_cast<difference_type>(other.group_);
+            }
+            
+            bool operator==(const iterator& other) const { return group_ == other.group_; }
+            bool operator!=(const iterator& other) const { return group_ != other.group_; }
+            bool operator<(const iterator& other) const { return group_ < other.group_; }
+            bool operator>(const iterator& other) const { return group_ > other.group_; }
+            bool operator<=(const iterator& other) const { return group_ <= other.group_; }
+            bool operator>=(const iterator& other) const { return group_ >= other.group_; }
+            
+        private:
+            const lookup* parent_ = nullptr;
+            size_t group_ = 0;
+        };
+        
+        using value_type     = grouping;
+        using const_iterator = iterator;
+        
+        lookup()
+            : offsets_(1, 0) {}
+        
+        /* offsets[g] .. offsets[g + 1] delimit the elements of the group with key id g in the index */
+        lookup(index_type&& index, std::vector<size_t>&& offsets, std::vector<element>&& elements)
+            : index_(std::move(index)), offsets_(std::move(offsets)), elements_(std::move(elements)) {}
+        
+        /* number of groups */
+        size_t size() const { return index_.size(); }
+        bool empty() const { return index_.size() == 0; }
+        
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size()); }
+        
+        grouping front() const { return group(0); }
+        grouping back() const { return group(size() - 1); }
+        
+        bool contains(const key& k) const {
+            return index_.find(k) != index_type::npos;
+        }
+        
+        /* The elements of the group with the given key; empty if there is no such group. */
+        detail::element_range<element> operator[](const key& k) const {
+            const auto id = index_.find(k);
+            return id == index_type::npos
+                ? detail::element_range<element>()
+                : detail::element_range<element>(elements_.data() + offsets_[id],
+                                                 elements_.data() + offsets_[id + 1]);
+        }
+        
+        /* All elements ordered by group. */
+        const std::vector<element>& elements() const { return elements_; }
+        
+    private:
+        grouping group(size_t id) const {
+            return grouping(&index_[id],
+                            elements_.data() + offsets_[id],
+                            elements_.data() + offsets_[id + 1]);
+        }
+        
+        index_type index_;
+        std::vector<size_t> offsets_;
+        std::vector<element> elements_;
+    };
+    
+    
+    namespace detail {
+        
+        /* Groups the projected elements of src by key into a lookup with a single contiguous element buffer. */
+        template<typename container, typename key_selector, typename element_selector, typename hash, typename key_equal>
+        auto make_lookup(const container& src, key_selector& key_sel, element_selector& elem_sel, hash h, key_equal eq) {
+            using key_type = std::decay_t<decltype(key_sel(*std::begin(src)))>;
+            using element_type = std::decay_t<decltype(elem_sel(*std::begin(src)))>;
+            using lookup_type = lookup<key_type, element_type, hash, key_equal>;
+            
+            typename lookup_type::index_type index(std::move(h), std::move(eq));
+            auto groups = group_pointers<true>(index, src, key_sel);
+            
+            std::vector<element_type> elements;
+            elements.reserve(groups.items.size());
+            for (const auto* value : groups.items)
+                elements.push_back(elem_sel(*value));
+            
+            return lookup_type(std::move(index), std::move(groups.offsets), std::move(elements));
+        }
+        
+        
+        /*
+            Calls result_sel(key, group) for every group of src. Groups are ranges over the source elements,
+            nothing is copied.
+         */
+        template<typename container, typename key_selector, typename result_selector, typename hash, typename key_equal>
+        auto group_results(const container& src, key_selector& key_sel, result_selector& result_sel, hash h, key_equal eq) {
+            using key_type = std::decay_t<decltype(key_sel(*std::begin(src)))>;
+            using group_type = indirect_range<value_type_t<container>>;
+            using result_type = std::decay_t<decltype(result_sel(std::declval<const key_type&>(), group_type()))>;
+            
+            flat_index<key_type, hash, key_equal> index(std::move(h), std::move(eq));
+            const auto groups = group_pointers<true>(index, src, key_sel);
+            
+            std::vector<result_type> result;
+            result.reserve(index.size());
+            for (size_t g = 0; g < index.size(); ++g)
+                result.push_back(result_sel(index[g], groups[g]));
+            return result;
+        }
+        
+        
+        /*
+            Calls result_sel(key, elements) for every group of src, where elements are the projected elements of
+            the group. Only the group being processed is materialized.
+         */
+        template<typename container, typename key_selector, typename element_selector, typename result_selector,
+                 typename hash, typename key_equal>
+        auto group_results(const container& src, key_selector& key_sel, element_selector& elem_sel,
+                           result_selector& result_sel, hash h, key_equal eq) {
+            using key_type = std::decay_t<decltype(key_sel(*std::begin(src)))>;
+            using element_type = std::decay_t<decltype(elem_sel(*std::begin(src)))>;
+            using result_type = std::decay_t<decltype(result_sel(std::declval<const key_type&>(),
+                                                                 std::declval<const std::vector<element_type>&>()))>;
+            
+            flat_index<key_type, hash, key_equal> index(std::move(h), std::move(eq));
+            const auto groups = group_pointers<true>(index, src, key_sel);
+            
+            std::vector<result_type> result;
+            result.reserve(index.size());
+            std::vector<element_type> elements;
+            for (size_t g = 0; g < index.size(); ++g) {
+                elements.clear();
+                for (const auto& value : groups[g])
+                    elements.push_back(elem_sel(value));
+                result.push_back(result_sel(index[g], static_cast<const std::vector<element_type>&>(elements)));
+            }
+            return result;
+        }
+        
+        
+        /*
+            Third argument of GroupBy: an element selector is called with a source element, anything else is a
+            result selector.
+         */
+        template<typename container, typename key_selector, typename selector, typename hash, typename key_equal>
+        auto group_by(const container& src, key_selector& key_sel, selector& sel, hash h, key_equal eq) {
+            if constexpr (std::is_invocable_v<selector&, const value_type_t<container>&>)
+                return make_lookup(src, key_sel, sel, std::move(h), std::move(eq));
+            else
+                return group_results(src, key_sel, sel, std::move(h), std::move(eq));
+        }
+        
+        
+        template<typename container, typename key_selector>
+        using key_hash_t = std::hash<std::decay_t<decltype(std::declval<key_selector&>()(*std::begin(std::declval<const container&>())))>>;
+        
+        template<typename container, typename key_selector>
+        using key_equal_t = std::equal_to<std::decay_t<decltype(std::declval<key_selector&>()(*std::begin(std::declval<const container&>())))>>;
+        
+    }
+    
+    
+    /*
+        Open-addressing hash set. Elements are stored contiguously in insertion order.
+     */
+    template<typename key, typename hash = std::hash<key>, typename key_equal = std::equal_to<key>>
+    class flat_set {
+    public:
+        using key_type       = key;
+        using value_type     = key;
+        using hasher         = hash;
+        using key_compare    = key_equal;
+        using iterator       = typename detail::key_storage_t<key>::const_iterator;
+        using const_iterator = iterator;
+        
+        flat_set() = default;
+        
+        explicit flat_set(size_t capacity, const hash& h = hash(), const key_equal& eq = key_equal())
+            : index_(h, eq) { index_.reserve(capacity); }
+        
+        size_t size() const { return index_.size(); }
+        bool empty() const { return index_.size() == 0; }
+        void reserve(size_t count) { index_.reserve(count); }
+        
+        iterator begin() const { return index_.keys().begin(); }
+        iterator end() const { return index_.keys().end(); }
+        
+        iterator find(const key& k) const {
+            const auto id = index_.find(k);
+            return id == index_type::npos ? end() : begin() + id;
+        }
+        
+        bool contains(const key& k) const { return index_.find(k) != index_type::npos; }
+        size_t count(const key& k) const { return contains(k) ? 1 : 0; }
+        
+        template<typename K>
+        std::pair<iterator, bool> insert(K&& k) {
+            const auto id = index_.insert(std::forward<K>(k));
+            return { begin() + id.first, id.second };
+        }
+        
+        /* makes the set usable with std::inserter */
+        template<typename K>
+        iterator insert(iterator, K&& k) {
+            return insert(std::forward<K>(k)).first;
+        }
+        
+    private:
+        using index_type = detail::flat_index<key, hash, key_equal>;
+        
+        index_type index_;
+    };
+    
+    
+    /*
+        Open-addressing hash map. Keys and values are stored in two contiguous arrays in insertion order.
+     */
+    template<typename key, typename value, typename hash = std::hash<key>, typename key_equal = std::equal_to<key>>
+    class flat_map {
+    public:
+        using key_type    = key;
+        using mapped_type = value;
+        using value_type  = std::pair<const key&, const value&>;
+        using hasher      = hash;
+        using key_compare = key_equal;
+        
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = flat_map::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = value_type;
+            
+            struct pointer {
+                value_type pair;
+                const value_type* operator->() const { return &pair; }
+            };
+            
+            iterator() = default;
+            iterator(const flat_map* parent, size_t id)
+                : parent_(parent), id_(id) {}
+            
+            reference operator*() const { return reference(parent_->index_[id_], parent_->values_[id_]); }
+            pointer operator->() const { return pointer{ **this }; }
+            
+            iterator& operator++() { ++id_; return *this; }
+            iterator operator++(int) { auto tmp = *this; ++id_; return tmp; }
+            iterator& operator--() { --id_; return *this; }
+            iterator operator--(int) { auto tmp = *this; --id_; return tmp; }
+            iterator& operator+=(difference_type n) { id_ += n; return *this; }
+            iterator operator+(difference_type n) const { return iterator(parent_, id_ + n); }
+            difference_type operator-(const iterator& other) const {
+                return static_cast<difference_type>(id_) - static_cast<difference_type>(other.id_);
+            }
+            
+            bool operator==(const iterator& other) const { return id_ == other.id_; }
+            bool operator!=(const iterator& other) const { return id_ != other.id_; }
+            
+        private:
+            const flat_map* parent_ = nullptr;
+            size_t id_ = 0;
+        };
+        
+        using const_iterator = iterator;
+        
+        flat_map() = default;
+        
+        explicit flat_map(size_t capacity, const hash& h = hash(), const key_equal& eq = key_equal())
+            : index_(h, eq) { reserve(capacity); }
+        
+        size_t size() const { return index_.size(); }
+        bool empty() const { return index_.size() == 0; }
+        
+        void reserve(size_t count) {
+            index_.reserve(count);
+            values_.reserve(count);
+        }
+        
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size()); }
+        
+        const detail::key_storage_t<key>& keys() const { return index_.keys(); }
+        const std::vector<value>& values() const { return values_; }
+        
+        iterator find(const key& k) const {
+            const auto id = index_.find(k);
+            return id == index_type::npos ? end() : iterator(this, id);
+        }
+        
+        bool contains(const key& k) const { return index_.find(k) != index_type::npos; }
+        size_t count(const key& k) const { return contains(k) ? 1 : 0; }
+        
+        const value& at(const key& k) const {
+            const auto id = index_.find(k);
+            if (id == index_type::npos)
+                throw std::out_of_range("flat_map::at: no such key");
+            return values_[id];
+        }
+        
+        value& at(const key& k) {
+            return const_cast<value&>(static_cast<const flat_map&>(*this).at(k));
+        }
+        
+        value& operator[](const key& k) {
+            return values_[try_emplace(k).first - begin()];
+        }
+        
+        /* Inserts value(args...) unless the key is already present; never overwrites. */
+        template<typename K, typename... args>
+        std::pair<iterator, bool> try_emplace(K&& k, args&&... a) {
+            const auto id = index_.insert(std::forward<K>(k));
+            if (id.second)
+                values_.emplace_back(std::forward<args>(a)...);
+            return { iterator(this, id.first), id.second };
+        }
+        
+    private:
+        using index_type = detail::flat_index<key, hash, key_equal>;
+        
+        index_type index_;
+        std::vector<value> values_;
+    };
+    
+    
+    namespace detail {
+        
+        /* number of elements of src if it can be known without iterating it, 0 otherwise */
+        template<typename container>
+        size_t size_hint(const container& src) {
+            if constexpr (is_sized<container>::value)
+                return static_cast<size_t>(std::size(src));
+            else
+                return 0;
+        }
+        
+        
+        template<template<typename...> class map_type, typename container, typename key_selector, typename element_selector,
+                 typename hash, typename key_equal>
+        auto to_dictionary(const container& src, key_selector& key_sel, element_selector& elem_sel, const hash& h, const key_equal& eq) {
+            using key_type = std::decay_t<decltype(key_sel(*std::begin(src)))>;
+            using element_type = std::decay_t<decltype(elem_sel(*std::begin(src)))>;
+            
+            map_type<key_type, element_type, hash, key_equal> result(0, h, eq);
+            result.reserve(size_hint(src));
+            for (const auto& value : src) {
+                if (not result.try_emplace(key_sel(value), elem_sel(value)).second)
+                    throw std::invalid_argument("ToDictionary: duplicate key");
+            }
+            return result;
+        }
+        
+        
+        template<template<typename...> class set_type, typename container, typename hash, typename key_equal>
+        auto to_hash_set(const container& src, const hash& h, const key_equal& eq) {
+            set_type<value_type_t<container>, hash, key_equal> result(0, h, eq);
+            result.reserve(size_hint(src));
+            for (const auto& value : src)
+                result.insert(value);
+            return result;
+        }
+        
+    }
+    
+    
+    /*
+        Summation algorithms for floating-point Sum. `fast` uses the vectorized kernels (several independent
+        accumulators), `pairwise` and `kahan` trade speed for a tighter rounding error bound.
+     */
+    enum class summation {
+        fast,
+        pairwise,
+        kahan
+    };
+    
+    
+    namespace detail {
+        
+        template<typename container, typename = void>
+        struct is_contiguous : std::false_type {};
+        
+        template<typename container>
+        struct is_contiguous<container, std::void_t<decltype(std::data(std::declval<const container&>()))>>
+            : std::is_pointer<decltype(std::data(std::declval<const container&>()))> {};
+        
+        template<typename container>
+        inline constexpr bool is_contiguous_v = is_contiguous<container>::value;
+        
+        
+        /*
+            Vectorized reductions over contiguous arrays of int32_t, float and double.
+            
+            The instruction set is picked at run time (AVX-512F, AVX2, SSE2) on x86 compilers that support
+            per-function target attributes; elsewhere, or with SIMLINQ_NO_SIMD defined, a scalar kernel with
+            independent accumulators is used. Min and Max over floating-point data containing NaN return an
+            unspecified element.
+         */
+        namespace simd {
+            
+            template<typename T>
+            inline constexpr bool is_kernel_type_v = std::is_same_v<T, int32_t>
+                                                     or std::is_same_v<T, float>
+                                                     or std::is_same_v<T, double>;
+            
+            template<typename container>
+            inline constexpr bool has_kernel_v = is_contiguous_v<container>
+                                                 and is_kernel_type_v<std::remove_cv_t<value_type_t<container>>>;
+            
+            
+            template<typename T>
+            T sum_scalar(const T* p, size_t n) {
+                T a0 = T(), a1 = T(), a2 = T(), a3 = T();
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    a0 += p[i];
+                    a1 += p[i + 1];
+                    a2 += p[i + 2];
+                    a3 += p[i + 3];
+                }
+                for (; i < n; ++i)
+                    a0 += p[i];
+                return (a0 + a1) + (a2 + a3);
+            }
+            
+            template<bool take_max, typename T>
+            T extremum_scalar(const T* p, size_t n) {
+                T result = p[0];
+                for (size_t i = 1; i < n; ++i) {
+                    if (take_max ? result < p[i] : p[i] < result)
+                        result = p[i];
+                }
+                return result;
+            }
+            
+            
+#ifdef SIMLINQ_X86_SIMD
+            
+            struct sse2 {
+                __attribute__((target("sse2"))) static __m128i load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+                __attribute__((target("sse2"))) static __m128  load(const float* p)   { return _mm_loadu_ps(p); }
+                __attribute__((target("sse2"))) static __m128d load(const double* p)  { return _mm_loadu_pd(p); }
+                
+                __attribute__((target("sse2"))) static void store(int32_t* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+                __attribute__((target("sse2"))) static void store(float* p, __m128 v)    { _mm_storeu_ps(p, v); }
+                __attribute__((target("sse2"))) static void store(double* p, __m128d v)  { _mm_storeu_pd(p, v); }
+                
+                __attribute__((target("sse2"))) static __m128i zero(const int32_t*) { return _mm_setzero_si128(); }
+                __attribute__((target("sse2"))) static __m128  zero(const float*)   { return _mm_setzero_ps(); }
+                __attribute__((target("sse2"))) static __m128d zero(const double*)  { return _mm_setzero_pd(); }
+                
+                __attribute__((target("sse2"))) static __m128i add(__m128i l, __m128i r) { return _mm_add_epi32(l, r); }
+                __attribute__((target("sse2"))) static __m128  add(__m128 l, __m128 r)   { return _mm_add_ps(l, r); }
+                __attribute__((target("sse2"))) static __m128d add(__m128d l, __m128d r) { return _mm_add_pd(l, r); }
+                
+                /* SSE2 has no 32-bit integer min/max, select through the comparison mask */
+                __attribute__((target("sse2"))) static __m128i min(__m128i l, __m128i r) {
+                    const auto mask = _mm_cmpgt_epi32(l, r);
+                    return _mm_or_si128(_mm_and_si128(mask, r), _mm_andnot_si128(mask, l));
+                }
+                __attribute__((target("sse2"))) static __m128  min(__m128 l, __m128 r)   { return _mm_min_ps(l, r); }
+                __attribute__((target("sse2"))) static __m128d min(__m128d l, __m128d r) { return _mm_min_pd(l, r); }
+                
+                __attribute__((target("sse2"))) static __m128i max(__m128i l, __m128i r) {
+                    const auto mask = _mm_cmpgt_epi32(l, r);
+                    return _mm_or_si128(_mm_and_si128(mask, l), _mm_andnot_si128(mask, r));
+                }
+                __attribute__((target("sse2"))) static __m128  max(__m128 l, __m128 r)   { return _mm_max_ps(l, r); }
+                __attribute__((target("sse2"))) static __m128d max(__m128d l, __m128d r) { return _mm_max_pd(l, r); }
+            };
+            
+            
+            struct avx2 {
+                __attribute__((target("avx2"))) static __m256i load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+                __attribute__((target("avx2"))) static __m256  load(const float* p)   { return _mm256_loadu_ps(p); }
+                __attribute__((target("avx2"))) static __m256d load(const double* p)  { return _mm256_loadu_pd(p); }
+                
+                __attribute__((target("avx2"))) static void store(int32_t* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+                __attribute__((target("avx2"))) static void store(float* p, __m256 v)    { _mm256_storeu_ps(p, v); }
+                __attribute__((target("avx2"))) static void store(double* p, __m256d v)  { _mm256_storeu_pd(p, v); }
+                
+                __attribute__((target("avx2"))) static __m256i zero(const int32_t*) { return _mm256_setzero_si256(); }
+                __attribute__((target("avx2"))) static __m256  zero(const float*)   { return _mm256_setzero_ps(); }
+                __attribute__((target("avx2"))) static __m256d zero(const double*)  { return _mm256_setzero_pd(); }
+                
+                __attribute__((target("avx2"))) static __m256i add(__m256i l, __m256i r) { return _mm256_add_epi32(l, r); }
+                __attribute__((target("avx2"))) static __m256  add(__m256 l, __m256 r)   { return _mm256_add_ps(l, r); }
+                __attribute__((target("avx2"))) static __m256d add(__m256d l, __m256d r) { return _mm256_add_pd(l, r); }
+                
+                __attribute__((target("avx2"))) static __m256i min(__m256i l, __m256i r) { return _mm256_min_epi32(l, r); }
+                __attribute__((target("avx2"))) static __m256  min(__m256 l, __m256 r)   { return _mm256_min_ps(l, r); }
+                __attribute__((target("avx2"))) static __m256d min(__m256d l, __m256d r) { return _mm256_min_pd(l, r); }
+                
+                __attribute__((target("avx2"))) static __m256i max(__m256i l, __m256i r) { return _mm256_max_epi32(l, r); }
+                __attribute__((target("avx2"))) static __m256  max(__m256 l, __m256 r)   { return _mm256_max_ps(l, r); }
+                __attribute__((target("avx2"))) static __m256d max(__m256d l, __m256d r) { return _mm256_max_pd(l, r); }
+            };
+            
+            
+            struct avx512 {
+                __attribute__((target("avx512f"))) static __m512i load(const int32_t* p) { return _mm512_loadu_si512(p); }
+                __attribute__((target("avx512f"))) static __m512  load(const float* p)   { return _mm512_loadu_ps(p); }
+                __attribute__((target("avx512f"))) static __m512d load(const double* p)  { return _mm512_loadu_pd(p); }
+                
+                __attribute__((target("avx512f"))) static void store(int32_t* p, __m512i v) { _mm512_storeu_si512(p, v); }
+                __attribute__((target("avx512f"))) static void store(float* p, __m512 v)    { _mm512_storeu_ps(p, v); }
+                __attribute__((target("avx512f"))) static void store(double* p, __m512d v)  { _mm512_storeu_pd(p, v); }
+                
+                __attribute__((target("avx512f"))) static __m512i zero(const int32_t*) { return _mm512_setzero_si512(); }
+                __attribute__((target("avx512f"))) static __m512  zero(const float*)   { return _mm512_setzero_ps(); }
+                __attribute__((target("avx512f"))) static __m512d zero(const double*)  { return _mm512_setzero_pd(); }
+                
+                __attribute__((target("avx512f"))) static __m512i add(__m512i l, __m512i r) { return _mm512_add_epi32(l, r); }
+                __attribute__((target("avx512f"))) static __m512  add(__m512 l, __m512 r)   { return _mm512_add_ps(l, r); }
+                __attribute__((target("avx512f"))) static __m512d add(__m512d l, __m512d r) { return _mm512_add_pd(l, r); }
+                
+                /* the all-lanes masked forms avoid the undefined pass-through operand of the unmasked ones */
+                __attribute__((target("avx512f"))) static __m512i min(__m512i l, __m512i r) { return _mm512_mask_min_epi32(l, 0xFFFF, l, r); }
+                __attribute__((target("avx512f"))) static __m512  min(__m512 l, __m512 r)   { return _mm512_mask_min_ps(l, 0xFFFF, l, r); }
+                __attribute__((target("avx512f"))) static __m512d min(__m512d l, __m512d r) { return _mm512_mask_min_pd(l, 0xFF, l, r); }
+                
+                __attribute__((target("avx512f"))) static __m512i max(__m512i l, __m512i r) { return _mm512_mask_max_epi32(l, 0xFFFF, l, r); }
+                __attribute__((target("avx512f"))) static __m512  max(__m512 l, __m512 r)   { return _mm512_mask_max_ps(l, 0xFFFF, l, r); }
+                __attribute__((target("avx512f"))) static __m512d max(__m512d l, __m512d r) { return _mm512_mask_max_pd(l, 0xFF, l, r); }
+            };
+            
+            
+            /*
+                The kernels are stamped out once per instruction set: a target attribute cannot depend on a
+                template parameter, and the intrinsics can only be inlined into a function of the same target.
+                Four independent accumulators hide the latency of the vector add.
+             */
+#define SIMLINQ_SIMD_KERNELS(isa, target_name, width_bytes)                                     \
+            template<typename T>                                                                \
+            __attribute__((target(target_name))) T sum_##isa(const T* p, size_t n) {            \
+                constexpr size_t width = width_bytes / sizeof(T);                               \
+                auto a0 = isa::zero(p), a1 = a0, a2 = a0, a3 = a0;                              \
+                size_t i = 0;                                                                   \
+                for (; i + 4 * width <= n; i += 4 * width) {                                    \
+                    a0 = isa::add(a0, isa::load(p + i));                                        \
+                    a1 = isa::add(a1, isa::load(p + i + width));                                \
+                    a2 = isa::add(a2, isa::load(p + i + 2 * width));                            \
+                    a3 = isa::add(a3, isa::load(p + i + 3 * width));                            \
+                }                                                                               \
+                for (; i + width <= n; i += width)                                              \
+                    a0 = isa::add(a0, isa::load(p + i));                                        \
+                a0 = isa::add(isa::add(a0, a1), isa::add(a2, a3));                              \
+                                                                                                \
+                T lanes[width];                                                                 \
+                isa::store(lanes, a0);                                                          \
+                T result = T();                                                                 \
+                for (size_t l = 0; l < width; ++l)                                              \
+                    result += lanes[l];                                                         \
+                for (; i < n; ++i)                                                              \
+                    result += p[i];                                                             \
+                return result;                                                                  \
+            }                                                                                   \
+                                                                                                \
+            template<bool take_max, typename T>                                                 \
+            __attribute__((target(target_name))) T extremum_##isa(const T* p, size_t n) {       \
+                constexpr size_t width = width_bytes / sizeof(T);                               \
+                if (n < 2 * width)                                                              \
+                    return extremum_scalar<take_max>(p, n);                                     \
+                                                                                                \
+                auto a0 = isa::load(p), a1 = isa::load(p + width);                              \
+                size_t i = 2 * width;                                                           \
+                for (; i + 2 * width <= n; i += 2 * width) {                                    \
+                    const auto l0 = isa::load(p + i), l1 = isa::load(p + i + width);            \
+                    a0 = take_max ? isa::max(a0, l0) : isa::min(a0, l0);                        \
+                    a1 = take_max ? isa::max(a1, l1) : isa::min(a1, l1);                        \
+                }                                                                               \
+                /* the tail is covered by overlapping loads, re-reading elements is harmless */ \
+                if (i + width < n) {                                                            \
+                    const auto l0 = isa::load(p + i);                                           \
+                    a0 = take_max ? isa::max(a0, l0) : isa::min(a0, l0);                        \
+                }                                                                               \
+                if (i != n) {                                                                   \
+                    const auto l1 = isa::load(p + n - width);                                   \
+                    a1 = take_max ? isa::max(a1, l1) : isa::min(a1, l1);                        \
+                }                                                                               \
+                a0 = take_max ? isa::max(a0, a1) : isa::min(a0, a1);                            \
+                                                                                                \
+                T lanes[width];                                                                 \
+                isa::store(lanes, a0);                                                          \
+                return extremum_scalar<take_max>(lanes, width);                                 \
+            }
+            
+            SIMLINQ_SIMD_KERNELS(sse2, "sse2", 16)
+            SIMLINQ_SIMD_KERNELS(avx2, "avx2", 32)
+            SIMLINQ_SIMD_KERNELS(avx512, "avx512f", 64)
+            
+#undef SIMLINQ_SIMD_KERNELS
+            
+#endif
+            
+            
+            enum class instruction_set {
+                scalar,
+                sse2,
+                avx2,
+                avx512
+            };
+            
+            inline instruction_set detect() {
+#ifdef SIMLINQ_X86_SIMD
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f"))
+                    return instruction_set::avx512;
+                if (__builtin_cpu_supports("avx2"))
+                    return instruction_set::avx2;
+                if (__builtin_cpu_supports("sse2"))
+                    return instruction_set::sse2;
+#endif
+                return instruction_set::scalar;
+            }
+            
+            inline instruction_set supported() {
+                static const instruction_set level = detect();
+                return level;
+            }
+            
+            
+            template<typename T>
+            T sum(const T* p, size_t n) {
+#ifdef SIMLINQ_X86_SIMD
+                switch (supported()) {
+                    case instruction_set::avx512: return sum_avx512(p, n);
+                    case instruction_set::avx2:   return sum_avx2(p, n);
+                    case instruction_set::sse2:   return sum_sse2(p, n);
+                    case instruction_set::scalar: break;
+                }
+#endif
+                return sum_scalar(p, n);
+            }
+            
+            /* n must be positive */
+            template<bool take_max, typename T>
+            T extremum(const T* p, size_t n) {
+#ifdef SIMLINQ_X86_SIMD
+                switch (supported()) {
+                    case instruction_set::avx512: return extremum_avx512<take_max>(p, n);
+                    case instruction_set::avx2:   return extremum_avx2<take_max>(p, n);
+                    case instruction_set::sse2:   return extremum_sse2<take_max>(p, n);
+                    case instruction_set::scalar: break;
+                }
+#endif
+                return extremum_scalar<take_max>(p, n);
+            }
+            
+        }
+        
+        
+        /* Sum with a bound on the error that grows with log(n) instead of n. */
+        template<typename T>
+        T pairwise_sum(const T* p, size_t n) {
+            if (n <= 128) {
+                T result = T();
+                for (size_t i = 0; i < n; ++i)
+                    result += p[i];
+                return result;
+            }
+            const auto half = n / 2;
+            return pairwise_sum(p, half) + pairwise_sum(p + half, n - half);
+        }
+        
+        
+        /*
+            Compensated (Kahan) sum: the low-order bits lost by every addition are fed back into the next one,
+            so the error does not grow with n.
+         */
+        template<typename iterator>
+        auto kahan_sum(iterator first, iterator last) {
+            using value_type = typename std::iterator_traits<iterator>::value_type;
+            
+            value_type sum = value_type();
+            value_type compensation = value_type();
+            for (; first != last; ++first) {
+                const value_type y = *first - compensation;
+                const value_type t = sum + y;
+                compensation = (t - sum) - y;
+                sum = t;
+            }
+            return sum;
+        }
+        
+    }
+    
+    
+
+    /*
+        Applies an accumulator function over a sequence. The specified seed value is used as the initial accumulator value, and the specified function is used to select the result value.
+    */
+    template<typename container, typename seed, typename accumulator, typename selector>
+    auto Aggregate(const container& src, seed&& s, accumulator&& acc, selector&& sel) {
+        std::decay_t<seed> result(std::forward<seed>(s));
+
+        for (const auto& value : src) {
+            acc(value, result);
+        }
+        return sel(result);
+    }
+
+
+    /*
+        Applies an accumulator function over a sequence. The specified seed value is used as the initial accumulator value.
+    */
+    template<typename container, typename seed, typename accumulator>
+    auto Aggregate(const container& src, seed&& s, accumulator&& acc) {
+        std::decay_t<seed> result(std::forward<seed>(s));
+
+        for (const auto& value : src) {
+            acc(value, result);
+        }
+        return result;
+    }
+
+
+    /*
+        Applies an accumulator function over a sequence.
+    */
+    template <typename container, typename accumulator>
+    auto Aggregate(const container &c, accumulator &&acc) {
+        typename container::value_type result{};
+
+        for (const auto &value : c)
+        {
+            acc(value, result);
+        }
+
+        return result;
+    }
+
+
+    /*
+        Applies an accumulator function over the elements of every group of a sequence, keys are compared by using a specified comparer.
+        Only one accumulator per distinct key is kept; the groups themselves are never materialized.
+    */
+    template<typename container, typename key_selector, typename seed, typename accumulator, typename hash, typename key_equal>
+    auto AggregateBy(const container& src, key_selector&& key_sel, const seed& s, accumulator&& acc,
+                     const equality_comparer<hash, key_equal>& comparer) {
+        using key_type = std::decay_t<decltype(key_sel(*std::begin(src)))>;
+
+        detail::flat_index<key_type, hash, key_equal> index(comparer.hasher, comparer.equal);
+        std::vector<seed> states;
+        for (const auto& value : src) {
+            const auto id = index.insert(key_sel(value));
+            if (id.second)
+                states.push_back(s);
+            acc(value, states[id.first]);
+        }
+
+        std::vector<std::pair<key_type, seed>> result;
+        result.reserve(states.size());
+        for (size_t id = 0; id < states.size(); ++id)
+            result.emplace_back(index[id], std::move(states[id]));
+        return result;
+    }
+
+
+    /*
+        Applies an accumulator function over the elements of every group of a sequence. The seed is the initial accumulator value of every group.
+        Returns (key, accumulated value) pairs ordered by the first occurrence of the key.
+    */
+    template<typename container, typename key_selector, typename seed, typename accumulator>
+    auto AggregateBy(const container& src, key_selector&& key_sel, const seed& s, accumulator&& acc) {
+        return AggregateBy(src, key_sel, s, acc,
+                           equality_comparer{ detail::key_hash_t<container, key_selector>(),
+                                              detail::key_equal_t<container, key_selector>() });
+    }
+
+
+    /*
+        Appends a value to the end of the sequence.
+    */
+    template <typename container>
+    void Append(container &c, const typename container::value_type &value) {
+        if constexpr (detail::has_push_back<container>::value) {
+            c.push_back(value);
+        } else if constexpr (detail::is_bidirectional_v<container>) {
+            c.insert(std::end(c), value);
+        } else {
+            auto last = c.before_begin();
+            for (auto it = std::begin(c); it != std::end(c); ++it)
+                last = it;
+            c.insert_after(last, value);
+        }
+    }
+
+
+    /*
+        Computes the average of a sequence.
+    */
+    template <typename container, typename result_type = typename container::value_type>
+    result_type Average(const container &c) {
+        if (std::begin(c) == std::end(c))
+            throw std::invalid_argument("Average: an empty array");
+
+        result_type result{};
+        if constexpr (detail::simd::has_kernel_v<container> and std::is_same_v<result_type, typename container::value_type>) {
+            result = detail::simd::sum(std::data(c), std::size(c));
+        } else {
+            for (const auto &value : c)
+            {
+                result += value;
+            }
+        }
+        result /= static_cast<result_type>(std::size(c));
+        return result;
+    }
+
+
+    /*
+        Computes the average of a sequence that are obtained by invoking a transform function on each element of the input sequence.
+    */
+    template <typename container, typename transform>
+    auto Average(const container &src, transform &&trans) {
+        using result_type = std::decay_t<decltype(trans(*std::begin(src)))>;
+        using optional_type = std::optional<result_type>;
+
+        if (std::begin(src) == std::end(src)) {
+            return optional_type();
+        }
+
+        result_type result{};
+        for (const auto &value : src)
+        {
+            result += trans(value);
+        }
+        result /= static_cast<result_type>(std::size(src));
+        return optional_type(result);
+    }
+
+
+    /*
+        Casts the elements of an IEnumerable to the specified type. The result is allocated with the specified allocator.
+    */
+    template<typename cast_type, typename container, typename allocator>
+    auto Cast(const container& src, const allocator& alloc) {
+        using allocator_type = detail::rebind_alloc_t<allocator, cast_type>;
+        std::vector<cast_type, allocator_type> result{ allocator_type(alloc) };
+        result.reserve(std::size(src));
+
+        std::transform(std::begin(src),
+                       std::end(src),
+                       std::back_inserter(result),
+                       [](const auto& value) { return static_cast<cast_type>(value); }
+                       );
+        return result;
+    }
+
+
+    /*
+        Casts the elements of an IEnumerable to the specified type.
+    */
+    template<typename cast_type, typename container> 
+    auto Cast(const container& src) {
+        return Cast<cast_type>(src, std::allocator<cast_type>());
+    }
+
+    
+    /*
+        Returns the elements of the specified sequence or the type parameter's default value in a singleton collection if the sequence is empty.
+     */
+    template<typename container>
+    auto DefaultIfEmpty(const container& src) {
+        return std::size(src) != 0
+            ? detail::make_like(src, src)
+            : detail::make_like(src, size_t(1), typename container::value_type{});
+    }
+    
+    
+    /*
+        Returns the elements of the specified sequence or the specified value in a singleton collection if the sequence is empty.
+     */
+    template<typename container>
+    auto DefaultIfEmpty(const container& src, typename container::value_type value) {
+        return std::size(src) != 0
+            ? detail::make_like(src, src)
+            : detail::make_like(src, size_t(1), value);
+    }
+
+    
+    namespace detail {
+        
+        template<typename T, typename = void>
+        struct is_hashable : std::false_type {};
+        
+        template<typename T>
+        struct is_hashable<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>> : std::true_type {};
+        
+        /*
+            Up to this many elements in the second sequence a linear scan is cheaper than building a hash index over it.
+         */
+        inline constexpr size_t hash_set_threshold = 16;
+        
+        /*
+            The elements of a sequence as a multiset: a flat_index over the distinct values and a count per id.
+         */
+        template<typename value_type>
+        class element_counts {
+        public:
+            template<typename container>
+            explicit element_counts(const container& src) {
+                index_.reserve(std::size(src));
+                for (const auto& value : src) {
+                    const auto id = index_.insert(value);
+                    if (id.second)
+                        counts_.push_back(1);
+                    else
+                        ++counts_[id.first];
+                }
+            }
+            
+            /* Takes one occurrence of the value out of the multiset; false when none is left. */
+            bool take(const value_type& value) {
+                const auto id = index_.find(value);
+                if (id == flat_index<value_type>::npos or counts_[id] == 0)
+                    return false;
+                --counts_[id];
+                return true;
+            }
+            
+        private:
+            flat_index<value_type> index_;
+            std::vector<size_t> counts_;
+        };
+        
+        /*
+            Multiset difference / intersection in the order of the first sequence: every element of the second one
+            cancels or matches at most one element of the first, as std::set_difference / std::set_intersection do.
+         */
+        template<typename container>
+        auto hashed_difference(const container& f, const container& s) {
+            element_counts<value_type_t<container>> counts(s);
+            auto result = make_like(f);
+            std::copy_if(std::begin(f), std::end(f), std::back_inserter(result),
+                         [&counts](const auto& value) { return not counts.take(value); });
+            return result;
+        }
+        
+        template<typename container>
+        auto hashed_intersection(const container& f, const container& s) {
+            element_counts<value_type_t<container>> counts(s);
+            auto result = make_like(f);
+            std::copy_if(std::begin(f), std::end(f), std::back_inserter(result),
+                         [&counts](const auto& value) { return counts.take(value); });
+            return result;
+        }
+        
+        template<typename container>
+        void hashed_difference_in_place(container& f, const container& s) {
+            element_counts<value_type_t<container>> counts(s);
+            f.erase(std::remove_if(std::begin(f), std::end(f), [&counts](const auto& value) { return counts.take(value); }),
+                    std::end(f));
+        }
+        
+        template<typename container>
+        void hashed_intersection_in_place(container& f, const container& s) {
+            element_counts<value_type_t<container>> counts(s);
+            f.erase(std::remove_if(std::begin(f), std::end(f), [&counts](const auto& value) { return not counts.take(value); }),
+                    std::end(f));
+        }
+        
+        template<typename container, typename key_selector>
+        using selected_key_t = std::decay_t<decltype(std::declval<key_selector&>()(*std::begin(std::declval<const container&>())))>;
+        
+        template<typename T, typename = void>
+        struct is_less_comparable : std::false_type {};
+        
+        template<typename T>
+        struct is_less_comparable<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>> : std::true_type {};
+        
+        /*
+            Integral keys spanning fewer than this many bits per element are deduplicated with a bitmap over [min, max],
+            which is smaller than a hash index and needs no probing.
+         */
+        inline constexpr size_t distinct_bitmap_bits = 32;
+        
+        /*
+            Calls keep(it) for the first element of every key, in source order; key_of(it, i) reads the key of the i-th
+            element. keep may move the element away, its key has been read by then. Sorted keys are compared with the
+            previous one in a single pass, integral keys spanning a small range are marked in a bitmap, other hashable
+            keys go through a flat_index, and the remaining ones are sorted once to find their first occurrences.
+         */
+        template<typename key_type, typename container, typename key_reader, typename visitor>
+        void first_occurrences(container& src, key_reader&& key_of, visitor&& keep) {
+            constexpr bool small_range = std::is_integral_v<key_type> and not std::is_same_v<key_type, bool>;
+            
+            const size_t n = std::size(src);
+            if (n == 0)
+                return;
+            
+            bool sorted = false;
+            key_type low{}, high{};
+            if constexpr (is_less_comparable<key_type>::value) {
+                auto it = std::begin(src);
+                key_type previous = key_of(it, 0);
+                low = high = previous;
+                sorted = true;
+                size_t i = 1;
+                for (++it; it != std::end(src) and (sorted or small_range); ++it, ++i) {
+                    key_type key = key_of(it, i);
+                    sorted = sorted and not (key < previous);
+                    if constexpr (small_range) {
+                        low = std::min(low, key);
+                        high = std::max(high, key);
+                    }
+                    previous = std::move(key);
+                }
+            }
+            
+            if (sorted) {
+                std::optional<key_type> previous;
+                size_t i = 0;
+                for (auto it = std::begin(src); it != std::end(src); ++it, ++i) {
+                    key_type key = key_of(it, i);
+                    if (not previous or *previous < key) {
+                        previous = std::move(key);
+                        keep(it);
+                    }
+                }
+                return;
+            }
+            
+            if constexpr (small_range) {
+                using unsigned_key = std::make_unsigned_t<key_type>;
+                const auto offset = [low](key_type key) {
+                    return static_cast<uint64_t>(static_cast<unsigned_key>(static_cast<unsigned_key>(key) - static_cast<unsigned_key>(low)));
+                };
+                const uint64_t span = offset(high);
+                if (span < std::max<uint64_t>(distinct_bitmap_bits * n, uint64_t(1) << 16)) {
+                    std::vector<uint64_t> seen(span / 64 + 1);
+                    size_t i = 0;
+                    for (auto it = std::begin(src); it != std::end(src); ++it, ++i) {
+                        const uint64_t bit = offset(key_of(it, i));
+                        const uint64_t mask = uint64_t(1) << (bit % 64);
+                        if ((seen[bit / 64] & mask) == 0) {
+                            seen[bit / 64] |= mask;
+                            keep(it);
+                        }
+                    }
+                    return;
+                }
+            }
+            
+            if constexpr (is_hashable<key_type>::value) {
+                flat_index<key_type> index;
+                index.reserve(n);
+                size_t i = 0;
+                for (auto it = std::begin(src); it != std::end(src); ++it, ++i)
+                    if (index.insert(key_of(it, i)).second)
+                        keep(it);
+            } else {
+                static_assert(is_less_comparable<key_type>::value, "Distinct requires hashable or less-than comparable keys");
+                
+                std::vector<const key_type*> keys;
+                keys.reserve(n);
+                size_t i = 0;
+                for (auto it = std::begin(src); it != std::end(src); ++it, ++i)
+                    keys.push_back(&key_of(it, i));
+                
+                std::vector<size_t> order(n);
+                std::iota(order.begin(), order.end(), size_t(0));
+                std::stable_sort(order.begin(), order.end(), [&keys](size_t l, size_t r) { return *keys[l] < *keys[r]; });
+                
+                std::vector<bool> first(n, false);
+                for (i = 0; i < n; ++i)
+                    first[order[i]] = i == 0 or *keys[order[i - 1]] < *keys[order[i]];
+                
+                i = 0;
+                for (auto it = std::begin(src); it != std::end(src); ++it, ++i)
+                    if (first[i])
+                        keep(it);
+            }
+        }
+        
+        /*
+            Distinct reads the elements themselves; a key selector is evaluated once per element up front, since every
+            strategy reads the keys more than once.
+         */
+        template<typename container, typename key_selector, typename visitor>
+        void first_occurrences_by(container& src, key_selector& key_func, visitor&& keep) {
+            using key_type = selected_key_t<container, key_selector>;
+            
+            if constexpr (std::is_same_v<std::decay_t<key_selector>, identity>) {
+                first_occurrences<key_type>(src, [](auto it, size_t) -> const key_type& { return *it; }, keep);
+            } else {
+                std::vector<key_type> keys;
+                keys.reserve(std::size(src));
+                for (const auto& value : src)
+                    keys.push_back(key_func(value));
+                first_occurrences<key_type>(src, [&keys](auto, size_t i) -> const key_type& { return keys[i]; }, keep);
+            }
+        }
+        
+        template<typename container, typename key_selector>
+        auto distinct_by(const container& src, key_selector& key_func) {
+            auto result = make_like(src);
+            first_occurrences_by(src, key_func, [&result](auto it) { result.push_back(*it); });
+            return result;
+        }
+        
+        template<typename container, typename key_selector>
+        void distinct_by_in_place(container& src, key_selector& key_func) {
+            auto out = std::begin(src);
+            first_occurrences_by(src, key_func, [&out](auto it) {
+                if (out != it)
+                    *out = std::move(*it);
+                ++out;
+            });
+            src.erase(out, std::end(src));
+        }
+        
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using the default equality comparer to compare values: the first
+        occurrence of every value, in the order of the sequence.
+     */
+    template<typename container>
+    auto Distinct(const container& src) {
+        detail::identity key_func;
+        return detail::distinct_by(src, key_func);
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using the default equality comparer to compare values.
+        The sequence is taken over and compacted in place.
+     */
+    template<typename container, typename = detail::enable_for_rvalue<container>>
+    auto Distinct(container&& src) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            detail::identity key_func;
+            detail::distinct_by_in_place(src, key_func);
+            return std::move(src);
+        } else {
+            return detail::through_vector(src, [](auto values) { return Distinct(std::move(values)); });
+        }
+    }
+    
+    
+    /*
+        Returns the first element of every distinct key in a sequence according to a specified key selector function,
+        in the order of the sequence.
+     */
+    template<typename container, typename key_selector>
+    auto DistinctBy(const container& src, key_selector&& key_func) {
+        return detail::distinct_by(src, key_func);
+    }
+    
+    
+    /*
+        Returns the first element of every distinct key in a sequence according to a specified key selector function.
+        The sequence is taken over and compacted in place.
+     */
+    template<typename container, typename key_selector, typename = detail::enable_for_rvalue<container>>
+    auto DistinctBy(container&& src, key_selector&& key_func) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            detail::distinct_by_in_place(src, key_func);
+            return std::move(src);
+        } else {
+            return detail::through_vector(src, [&key_func](auto values) { return DistinctBy(std::move(values), key_func); });
+        }
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using the default equality comparer to compare values.
+        Sorted inputs are merged; otherwise hashable elements go through a hash index and keep the order of the first
+        sequence, and the rest are sorted and merged.
+     */
+    template<typename container>
+    auto Distinct(const container& first, const container& second) {
+        using namespace detail;
+        
+        if (is_sorted(first) and is_sorted(second)) {
+            return distinct_impl(first, second);
+        }
+        
+        if constexpr (is_hashable<value_type_t<container>>::value) {
+            return hashed_difference(first, second);
+        } else {
+            return distinct_impl( copy_sort(first),
+                                  copy_sort(second));
+        }
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using a specified IEqualityComparer<T> to compare values.
+     */
+    template<typename container, typename binary_predicate>
+    auto Distinct(const container& first, const container& second, binary_predicate&& comparer) {
+        using namespace detail;
+        
+        if (is_sorted(first, comparer) and is_sorted(second, comparer)) {
+            return distinct_impl(first, second, comparer);
+        }
+        
+        return distinct_impl( copy_sort(first, comparer),
+                              copy_sort(second, comparer),
+                              comparer);
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using the default equality comparer to compare values.
+        The first sequence is taken over: it is compacted in place instead of being copied.
+     */
+    template<typename container, typename = detail::enable_for_rvalue<container>>
+    auto Distinct(container&& first, const container& second) {
+        using namespace detail;
+        
+        if constexpr (not has_range_erase<container>::value) {
+            return through_vector(first, [&second](auto values) { return Distinct(std::move(values), as_vector(second)); });
+        } else if constexpr (is_hashable<value_type_t<container>>::value) {
+            if (is_sorted(first) and is_sorted(second))
+                difference_in_place(first, second, std::less<>());
+            else
+                hashed_difference_in_place(first, second);
+            return std::move(first);
+        } else {
+            return Distinct(std::move(first), second, std::less<>());
+        }
+    }
+    
+    
+    /*
+        Returns distinct elements from a sequence by using a specified IEqualityComparer<T> to compare values.
+        The first sequence is taken over: it is sorted and compacted in place instead of being copied.
+     */
+    template<typename container, typename binary_predicate, typename = detail::enable_for_rvalue<container>>
+    auto Distinct(container&& first, const container& second, binary_predicate&& comparer) {
+        using namespace detail;
+        
+        if constexpr (not has_range_erase<container>::value) {
+            return through_vector(first, [&](auto values) { return Distinct(std::move(values), as_vector(second), comparer); });
+        } else {
+            if (not is_sorted(first, comparer))
+                std::sort(std::begin(first), std::end(first), comparer);
+            
+            if (is_sorted(second, comparer))
+                difference_in_place(first, second, comparer);
+            else
+                difference_in_place(first, copy_sort(second, comparer), comparer);
+            return std::move(first);
+        }
+    }
+    
+    
+    /*
+        Returns the element at a specified index in a sequence.
+     */
+    template<typename container>
+    auto ElementAt(const container& src, int index) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        const auto it = index >= 0 ? detail::element_at(src, static_cast<size_t>(index)) : std::end(src);
+        return it != std::end(src)
+            ? optional_type(*it)
+            : optional_type();
+    }
+    
+    
+    /*
+        Returns the element at a specified index in a sequence or a default value if the index is out of range.
+     */
+    template<typename container>
+    auto ElementAtOrDefault(const container& src, int index) {
+        const auto it = index >= 0 ? detail::element_at(src, static_cast<size_t>(index)) : std::end(src);
+        return it != std::end(src)
+            ? *it
+            : typename container::value_type();
+    }
+    
+    
+    /*
+        Returns the first element of a sequence.
+    */
+    template <typename container>
+    auto First(const container &src) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        return std::begin(src) == std::end(src)
+            ? optional_type()
+            : optional_type(src.front());
+    }
+
+
+    /*
+        Returns the first element in a sequence that satisfies a specified condition.
+    */
+    template<typename container, typename unary_predicate>
+    auto First(const container& c, unary_predicate&& condition) {
+        using optional_type = std::optional<typename container::value_type>;
+
+        auto res = std::find_if(std::begin(c),
+                                std::end(c),
+                                condition);
+        return res == std::end(c)
+                ? optional_type()
+                : optional_type(*res);
+    }
+
+
+    /*
+        Returns the first element of a sequence, or a default value if the sequence contains no elements.
+    */
+    template<typename container>
+    auto FirstOrDefault(const container& c) {
+        return std::begin(c) == std::end(c)
+            ? typename container::value_type()
+            : typename container::value_type(c.front());
+    }
+
+
+    /*
+        Returns the first element of the sequence that satisfies a condition or a default value if no such element is found.
+    */
+    template<typename container, typename condition>
+    auto FirstOrDefault(const container& c, condition&& cond) {
+        auto res = std::find_if(std::begin(c),
+                                std::end(c),
+                                cond);
+        return res == std::end(c)
+                ? typename container::value_type()
+                : *res;
+    }
+
+
+    /*
+        Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key. Key values are compared by using a specified comparer, and the elements of each group are projected by using a specified function.
+     */
+    template<typename container, typename key_selector, typename element_selector, typename result_selector,
+             typename hash, typename key_equal>
+    auto GroupBy(const container& src, key_selector&& key_sel, element_selector&& elem_sel, result_selector&& result_sel,
+                 const equality_comparer<hash, key_equal>& comparer) {
+        return detail::group_results(src, key_sel, elem_sel, result_sel, comparer.hasher, comparer.equal);
+    }
+    
+    
+    /*
+        Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key. The elements of each group are projected by using a specified function.
+        Only the group passed to the result selector is materialized.
+     */
+    template<typename container, typename key_selector, typename element_selector, typename result_selector,
+             typename = detail::disable_for_comparer<result_selector>>
+    auto GroupBy(const container& src, key_selector&& key_sel, element_selector&& elem_sel, result_selector&& result_sel) {
+        return detail::group_results(src, key_sel, elem_sel, result_sel,
+                                     detail::key_hash_t<container, key_selector>(),
+                                     detail::key_equal_t<container, key_selector>());
+    }
+    
+    
+    /*
+        Groups the elements of a sequence according to a key selector function, comparing keys by using a specified comparer.
+        The selector either projects the elements of each group (and a lookup is returned), or creates a result value from each group and its key.
+     */
+    template<typename container, typename key_selector, typename selector, typename hash, typename key_equal>
+    auto GroupBy(const container& src, key_selector&& key_sel, selector&& sel,
+                 const equality_comparer<hash, key_equal>& comparer) {
+        return detail::group_by(src, key_sel, sel, comparer.hasher, comparer.equal);
+    }
+    
+    
+    /*
+        Groups the elements of a sequence according to a key selector function.
+        The selector either projects the elements of each group (and a lookup is returned), or creates a result value from each group and its key;
+        in the latter case the group is a range over the source elements and nothing is copied.
+     */
+    template<typename container, typename key_selector, typename selector,
+             typename = detail::disable_for_comparer<selector>>
+    auto GroupBy(const container& src, key_selector&& key_sel, selector&& sel) {
+        return detail::group_by(src, key_sel, sel,
+                                detail::key_hash_t<container, key_selector>(),
+                                detail::key_equal_t<container, key_selector>());
+    }
+    
+    
+    /*
+        Groups the elements of a sequence according to a specified key selector function and compares the keys by using a specified comparer.
+     */
+    template<typename container, typename key_selector, typename hash, typename key_equal>
+    auto GroupBy(const container& src, key_selector&& key_sel, const equality_comparer<hash, key_equal>& comparer) {
+        detail::identity elem_sel;
+        return detail::make_lookup(src, key_sel, elem_sel, comparer.hasher, comparer.equal);
+    }
+    
+    
+    /*
+        Groups the elements of a sequence according to a specified key selector function.
+     */
+    template<typename container, typename key_selector>
+    auto GroupBy(const container& src, key_selector&& key_sel) {
+        detail::identity elem_sel;
+        return detail::make_lookup(src, key_sel, elem_sel,
+                                   detail::key_hash_t<container, key_selector>(),
+                                   detail::key_equal_t<container, key_selector>());
+    }
+    
+
+    /*
+        Correlates the elements of two sequences based on key equality and groups the results by using the specified hash and key equality functions.
+        The result selector receives every outer element together with the (possibly empty) range of its matching inner elements.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector, typename hash, typename key_equal>
+    auto GroupJoin(const outer_container& outer, const inner_container& inner,
+                   outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+                   result_selector&& result_sel, hash&& h, key_equal&& eq) {
+        using inner_value = detail::value_type_t<inner_container>;
+        using result_type = std::decay_t<decltype(result_sel(*std::begin(outer), detail::indirect_range<inner_value>()))>;
+        
+        std::vector<result_type> result;
+        result.reserve(std::size(outer));
+        detail::hash_join(outer, inner, outer_key, inner_key,
+                          std::forward<hash>(h), std::forward<key_equal>(eq),
+                          [&result, &result_sel](const auto& value, const auto& group) {
+                              result.push_back(result_sel(value, group));
+                          });
+        return result;
+    }
+    
+    
+    /*
+        Correlates the elements of two sequences based on key equality and groups the results. A specified key equality function is used to compare keys.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector, typename key_equal>
+    auto GroupJoin(const outer_container& outer, const inner_container& inner,
+                   outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+                   result_selector&& result_sel, key_equal&& eq) {
+        using key_type = std::decay_t<decltype(outer_key(*std::begin(outer)))>;
+        
+        return GroupJoin(outer, inner, outer_key, inner_key, result_sel,
+                         std::hash<key_type>(), std::forward<key_equal>(eq));
+    }
+    
+    
+    /*
+        Correlates the elements of two sequences based on equality of keys and groups the results. The default equality comparer is used to compare keys.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector>
+    auto GroupJoin(const outer_container& outer, const inner_container& inner,
+                   outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+                   result_selector&& result_sel) {
+        using key_type = std::decay_t<decltype(outer_key(*std::begin(outer)))>;
+        
+        return GroupJoin(outer, inner, outer_key, inner_key, result_sel,
+                         std::hash<key_type>(), std::equal_to<key_type>());
+    }
+    
+    
+    /*
+        Produces the set intersection of two sequences by using the default equality comparer to compare values.
+        Sorted inputs are merged; otherwise hashable elements go through a hash index and keep the order of the first
+        sequence, and the rest are sorted and merged.
+     */
+    template<typename container>
+    auto Intersect(const container& first, const container& second) {
+        if constexpr (detail::is_hashable<detail::value_type_t<container>>::value) {
+            if (not detail::is_sorted(first) or not detail::is_sorted(second))
+                return detail::hashed_intersection(first, second);
+        }
+        
+        auto prepare = [](const container& src) {
+            auto sorted = detail::make_like(src, src);
+            std::sort(std::begin(sorted), std::end(sorted));
+            return sorted;
+        };
+
+        if (detail::is_sorted(first) and detail::is_sorted(second)) {
+            auto result = detail::make_like(first);
+            std::set_intersection(std::begin(first), std::end(first),
+                                  std::begin(second), std::end(second),
+                                  std::back_inserter(result));
+            return result;
+        }
+        
+        container first_c = prepare(first);
+        container second_c = prepare(second);
+        
+        auto result = detail::make_like(first);
+        std::set_intersection(std::begin(first_c), std::end(first_c),
+                              std::begin(second_c), std::end(second_c),
+                              std::back_inserter(result));
+        return result;
+    }
+    
+    
+    /*
+        Produces the set intersection of two sequences by using the specified IEqualityComparer<T> to compare values.
+     */
+    template<typename container, typename comparator>
+    auto Intersect(const container& first, const container& second, comparator&& comp) {
+        auto prepare = [&comp](const container& src) {
+            auto sorted = detail::make_like(src, src);
+            std::sort(std::begin(sorted), std::end(sorted), comp);
+            return sorted;
+        };
+
+        container first_c = prepare(first);
+        container second_c = prepare(second);
+        
+        auto result = detail::make_like(first);
+        std::set_intersection(std::begin(first_c), std::end(first_c),
+                              std::begin(second_c), std::end(second_c),
+                              std::back_inserter(result),
+                              comp);
+        return result;
+    }
+    
+    
+    /*
+        Produces the set intersection of two sequences by using the default equality comparer to compare values.
+        The first sequence is taken over: it is compacted in place instead of being copied.
+     */
+    template<typename container, typename = detail::enable_for_rvalue<container>>
+    auto Intersect(container&& first, const container& second) {
+        using namespace detail;
+        
+        if constexpr (not has_range_erase<container>::value) {
+            return through_vector(first, [&second](auto values) { return Intersect(std::move(values), as_vector(second)); });
+        } else if constexpr (is_hashable<value_type_t<container>>::value) {
+            if (is_sorted(first) and is_sorted(second))
+                intersection_in_place(first, second, std::less<>());
+            else
+                hashed_intersection_in_place(first, second);
+            return std::move(first);
+        } else {
+            return Intersect(std::move(first), second, std::less<>());
+        }
+    }
+    
+    
+    /*
+        Produces the set intersection of two sequences by using the specified IEqualityComparer<T> to compare values.
+        The first sequence is taken over: it is sorted and compacted in place instead of being copied.
+     */
+    template<typename container, typename comparator, typename = detail::enable_for_rvalue<container>>
+    auto Intersect(container&& first, const container& second, comparator&& comp) {
+        using namespace detail;
+        
+        if constexpr (not has_range_erase<container>::value) {
+            return through_vector(first, [&](auto values) { return Intersect(std::move(values), as_vector(second), comp); });
+        } else {
+            std::sort(std::begin(first), std::end(first), comp);
+            
+            if (is_sorted(second, comp))
+                intersection_in_place(first, second, comp);
+            else
+                intersection_in_place(first, copy_sort(second, comp), comp);
+            return std::move(first);
+        }
+    }
+    
+    
+    /*
+        Correlates the elements of two sequences based on matching keys by using the specified hash and key equality functions.
+        Results follow the order of the outer sequence, and for each outer element the order of the inner sequence.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector, typename hash, typename key_equal>
+    auto Join(const outer_container& outer, const inner_container& inner,
+              outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+              result_selector&& result_sel, hash&& h, key_equal&& eq) {
+        using result_type = std::decay_t<decltype(result_sel(*std::begin(outer), *std::begin(inner)))>;
+        
+        std::vector<result_type> result;
+        detail::hash_join(outer, inner, outer_key, inner_key,
+                          std::forward<hash>(h), std::forward<key_equal>(eq),
+                          [&result, &result_sel](const auto& value, const auto& group) {
+                              for (const auto& matched : group)
+                                  result.push_back(result_sel(value, matched));
+                          });
+        return result;
+    }
+    
+    
+    /*
+        Correlates the elements of two sequences based on matching keys. A specified key equality function is used to compare keys.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector, typename key_equal>
+    auto Join(const outer_container& outer, const inner_container& inner,
+              outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+              result_selector&& result_sel, key_equal&& eq) {
+        using key_type = std::decay_t<decltype(outer_key(*std::begin(outer)))>;
+        
+        return Join(outer, inner, outer_key, inner_key, result_sel,
+                    std::hash<key_type>(), std::forward<key_equal>(eq));
+    }
+    
+    
+    /*
+        Correlates the elements of two sequences based on matching keys. The default equality comparer is used to compare keys.
+     */
+    template<typename outer_container, typename inner_container,
+             typename outer_key_selector, typename inner_key_selector,
+             typename result_selector>
+    auto Join(const outer_container& outer, const inner_container& inner,
+              outer_key_selector&& outer_key, inner_key_selector&& inner_key,
+              result_selector&& result_sel) {
+        using key_type = std::decay_t<decltype(outer_key(*std::begin(outer)))>;
+        
+        return Join(outer, inner, outer_key, inner_key, result_sel,
+                    std::hash<key_type>(), std::equal_to<key_type>());
+    }
+    
+
+    /*
+        Returns the last element of a sequence.
+    */
+    template <typename container>
+    auto Last(const container &src) {
+        using optional_type = std::optional<typename container::value_type>;
+
+        return std::begin(src) == std::end(src)
+            ? optional_type()
+            : optional_type(*detail::last_element(src));
+    }
+
+
+    /*
+        Returns the last element of a sequence that satisfies a specified condition.
+    */
+    template<typename container, typename unary_predicate>
+    auto Last(const container& c, unary_predicate&& cond) {
+        using optional_type = std::optional<typename container::value_type>;
+
+        auto res = detail::find_last_if(c, cond);
+        return res == std::end(c)
+                ? optional_type()
+                : optional_type(*res);
+    }
+
+
+    /*
+        Returns the last element of a sequence that satisfies a specified condition, using the specified execution policy.
+    */
+    template<typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    auto Last(const policy& p, const container& c, unary_predicate&& cond) {
+        using optional_type = std::optional<typename container::value_type>;
+
+        const auto found = detail::parallel_find_last(p, c, cond);
+        if (not found)
+            return Last(c, cond);
+        return *found != std::size(c)
+                ? optional_type(std::begin(c)[*found])
+                : optional_type();
+    }
+
+
+    /* 
+        Returns the last element of a sequence, or a default value if the sequence contains no elements.
+    */
+    template<typename container>
+    auto LastOrDefault(const container& c) {
+        return std::begin(c) == std::end(c)
+            ? typename container::value_type()
+            : typename container::value_type(*detail::last_element(c));
+    }
+
+
+    /*
+        Returns the last element of a sequence that satisfies a condition or a default value if no such element is found.
+    */
+    template<typename container, typename condition>
+    auto LastOrDefault(const container& c, condition&& cond) {
+        auto res = detail::find_last_if(c, cond);
+        return res == std::end(c)
+                ? typename container::value_type()
+                : *res;
+    }
+
+
+    /*
+        Returns the last element of a sequence that satisfies a condition or a default value, using the specified execution policy.
+    */
+    template<typename policy, typename container, typename condition, typename = detail::enable_for_policy<policy>>
+    auto LastOrDefault(const policy& p, const container& c, condition&& cond) {
+        const auto found = detail::parallel_find_last(p, c, cond);
+        if (not found)
+            return LastOrDefault(c, cond);
+        return *found != std::size(c)
+                ? std::begin(c)[*found]
+                : typename container::value_type();
+    }
+
+
+    /*
+        Returns an Int64 that represents the total number of elements in a sequence.
+     */
+    template <typename container>
+    long long LongCount(const container &src) {
+        return static_cast<long long>( std::size(src) );
+    }
+
+    /*
+        Returns an Int64 that represents how many elements in a sequence satisfy a condition.
+     */
+    template <typename container, typename unary_predicate, typename = detail::disable_for_policy<container>>
+    long long LongCount(const container &src, unary_predicate &&condition) {
+        return static_cast<long long>(std::count_if(std::begin(src),
+                                                    std::end(src),
+                                                    condition));
+    }
+    
+    /*
+        Returns an Int64 that represents how many elements in a sequence satisfy a condition, using the specified execution policy.
+     */
+    template <typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    long long LongCount(const policy &p, const container &src, unary_predicate &&condition) {
+        return static_cast<long long>(Count(p, src, condition));
+    }
+
+        
+    /*
+        Returns the maximum value in a sequence.
+    */
+    template <typename container>
+    auto Max(const container &src) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        if constexpr (detail::simd::has_kernel_v<container>) {
+            return std::size(src) == 0
+                ? optional_type()
+                : optional_type(detail::simd::extremum<true>(std::data(src), std::size(src)));
+        } else {
+            return std::begin(src) == std::end(src)
+                ? optional_type()
+                : optional_type(*(std::max_element(std::begin(src), std::end(src))));
+        }
+    }
+    
+    
+    /*
+        Returns the maximum value in a sequence, using the specified execution policy.
+    */
+    template <typename policy, typename container, typename = detail::enable_for_policy<policy>>
+    auto Max(const policy& p, const container &src) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        auto result = detail::parallel_reduce(p, src,
+                                              [](auto first, auto last) {
+                                                  if constexpr (detail::simd::has_kernel_v<container>)
+                                                      return detail::simd::extremum<true>(&*first, static_cast<size_t>(last - first));
+                                                  else
+                                                      return *std::max_element(first, last);
+                                              },
+                                              [](auto l, auto r) { return l < r ? r : l; });
+        return result
+            ? optional_type(std::move(*result))
+            : Max(src);
+    }
+    
+    
+    /*
+        Invokes a transform function on each element of a generic sequence and returns the maximum resulting value.
+    */
+    template<typename container, typename transform, typename = detail::disable_for_policy<container>>
+    auto Max(const container& c, transform&& trans) {
+        using optional_type = std::optional<std::decay_t<decltype(trans(*std::begin(c)))>>;
+
+        if (std::begin(c) == std::end(c)) {
+            return optional_type();
+        }
+        
+        auto max_value = trans(*std::begin(c));
+        for (const auto& value : c) {
+            max_value = std::max(trans(value), max_value);
+        } 
+        return optional_type(max_value);
+    }
+    
+
+    /*
+        Returns the minimum value in a sequence.
+    */
+    template<typename container>
+    auto Min(const container& c) {
+        using optional_type = std::optional<typename container::value_type>;
+
+        if constexpr (detail::simd::has_kernel_v<container>) {
+            return std::size(c) == 0
+                ? optional_type()
+                : optional_type(detail::simd::extremum<false>(std::data(c), std::size(c)));
+        } else {
+            return std::begin(c) == std::end(c)
+                ? optional_type()
+                : optional_type(*(std::min_element(std::begin(c), std::end(c))));
+        }
+    }
+    
+    
+    /*
+        Returns the minimum value in a sequence, using the specified execution policy.
+    */
+    template<typename policy, typename container, typename = detail::enable_for_policy<policy>>
+    auto Min(const policy& p, const container& c) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        auto result = detail::parallel_reduce(p, c,
+                                              [](auto first, auto last) {
+                                                  if constexpr (detail::simd::has_kernel_v<container>)
+                                                      return detail::simd::extremum<false>(&*first, static_cast<size_t>(last - first));
+                                                  else
+                                                      return *std::min_element(first, last);
+                                              },
+                                              [](auto l, auto r) { return r < l ? r : l; });
+        return result
+            ? optional_type(std::move(*result))
+            : Min(c);
+    }
+
+
+    /*
+        Invokes a transform function on each element of a generic sequence and returns the minimum resulting value.
+    */
+    template<typename container, typename transform, typename = detail::disable_for_policy<container>>
+    auto Min(const container& c, transform&& trans) {
+        using optional_type = std::optional<std::decay_t<decltype(trans(*std::begin(c)))>>;
+
+        if (std::begin(c) == std::end(c))
+            return optional_type();
+        
+        auto min_value = trans(*std::begin(c));
+        for (const auto& value : c) {
+            min_value = std::min(trans(value), min_value);
+        } 
+        return optional_type(min_value);
+    }
+
+    
+    /*
+        Filters the elements of an IEnumerable based on a specified type.
+     */
+    template<typename required_type, typename container>
+    auto OfType(const container& src) {
+        auto result = detail::make_like(src);
+        
+    std::copy_if(std::begin(src),
+                 std::end(src),
+                 std::back_inserter(result),
+                 [](auto& v) { return dynamic_cast<required_type>(v) != nullptr; }
+                 );
+        return result;
+    }
+    
+    
+    namespace detail {
+        
+        template<typename key_selector>
+        struct cached_key_selector {
+            key_selector selector;
+            
+            template<typename T>
+            decltype(auto) operator()(const T& value) const {
+                return selector(value);
+            }
+        };
+        
+        template<typename container, typename = void>
+        struct has_reserve : std::false_type {};
+        
+        template<typename container>
+        struct has_reserve<container, std::void_t<decltype(std::declval<container&>().reserve(size_t()))>> : std::true_type {};
+        
+        template<typename T>
+        struct is_cached_key_selector : std::false_type {};
+        
+        template<typename key_selector>
+        struct is_cached_key_selector<cached_key_selector<key_selector>> : std::true_type {};
+        
+        template<typename container, typename key_selector>
+        inline constexpr bool selects_reference_v =
+            std::is_lvalue_reference_v<decltype(std::declval<key_selector&>()(*std::begin(std::declval<const container&>())))>;
+        
+        /*
+            Keys are computed once per element when the selector asks for it, or when it builds a key that is not a
+            scalar: building strings or composite keys costs far more than the extra pass and the permutation. A selector
+            returning a reference to a member is as cheap as a comparison and would only have its keys copied.
+         */
+        template<typename container, typename key_selector>
+        inline constexpr bool cache_keys_v =
+            is_cached_key_selector<std::decay_t<key_selector>>::value or
+            (not std::is_scalar_v<selected_key_t<container, key_selector>> and not selects_reference_v<container, key_selector>);
+        
+        /* 1 for std::less, -1 for std::greater, 0 for comparers a radix sort cannot reproduce. */
+        template<typename key_compare>
+        struct sort_direction : std::integral_constant<int, 0> {};
+        
+        template<typename T>
+        struct sort_direction<std::less<T>> : std::integral_constant<int, 1> {};
+        
+        template<typename T>
+        struct sort_direction<std::greater<T>> : std::integral_constant<int, -1> {};
+        
+        /*
+            Below this many elements std::sort beats the histogram and scatter passes of the radix sort.
+         */
+        inline constexpr size_t radix_sort_threshold = 1024;
+        
+        /* keys that radix_bits maps to an unsigned integer of the same size; long double has no such integer */
+        template<typename key_type>
+        inline constexpr bool radix_key_v =
+            (std::is_integral_v<key_type> or (std::is_floating_point_v<key_type> and not std::is_same_v<key_type, long double>)) and
+            (sizeof(key_type) == 1 or sizeof(key_type) == 2 or sizeof(key_type) == 4 or sizeof(key_type) == 8);
+        
+        template<typename container, typename key_selector, typename key_compare>
+        inline constexpr bool radix_sortable_v =
+            is_random_access_v<container> and
+            sort_direction<std::decay_t<key_compare>>::value != 0 and
+            radix_key_v<selected_key_t<container, key_selector>>;
+        
+        /*
+            Maps an arithmetic key to an unsigned integer whose unsigned order is the key order: the sign bit of signed
+            integers is flipped, negative floats have all their bits flipped and positive ones only the sign bit.
+         */
+        template<typename key_type>
+        auto radix_bits(key_type key) {
+            if constexpr (std::is_same_v<key_type, bool>) {
+                return static_cast<uint8_t>(key);
+            } else {
+                using bits_type = std::conditional_t<sizeof(key_type) == 1, uint8_t,
+                                  std::conditional_t<sizeof(key_type) == 2, uint16_t,
+                                  std::conditional_t<sizeof(key_type) == 4, uint32_t, uint64_t>>>;
+                static_assert(sizeof(bits_type) == sizeof(key_type), "unsupported key size");
+                
+                bits_type bits;
+                std::memcpy(&bits, &key, sizeof(bits));
+                constexpr bits_type sign = bits_type(1) << (sizeof(bits_type) * 8 - 1);
+                if constexpr (std::is_floating_point_v<key_type>)
+                    return static_cast<bits_type>((bits & sign) ? ~bits : bits | sign);
+                else if constexpr (std::is_signed_v<key_type>)
+                    return static_cast<bits_type>(bits ^ sign);
+                else
+                    return bits;
+            }
+        }
+        
+        /*
+            LSD radix sort of the keys, one byte per pass; returns the positions of the elements in sorted order. Every pass
+            is stable, so equal keys keep their original order. Passes over a byte that all keys share are skipped, and so
+            are all of them when the keys already come in order.
+         */
+        template<typename container, typename key_selector>
+        std::vector<size_t> radix_order(const container& src, key_selector& key_func, bool descending) {
+            using bits_type = decltype(radix_bits(std::declval<selected_key_t<container, key_selector>>()));
+            constexpr size_t passes = sizeof(bits_type);
+            
+            const size_t n = std::size(src);
+            std::vector<std::pair<bits_type, size_t>> keys(n), buffer(n);
+            std::vector<std::array<size_t, 256>> counts(passes);
+            for (auto& count : counts)
+                count.fill(0);
+            
+            auto first = std::begin(src);
+            bool sorted = true;
+            for (size_t i = 0; i < n; ++i) {
+                auto bits = radix_bits(key_func(first[i]));
+                if (descending)
+                    bits = static_cast<bits_type>(~bits);
+                sorted = sorted and (i == 0 or keys[i - 1].first <= bits);
+                keys[i] = { bits, i };
+                for (size_t pass = 0; pass < passes; ++pass)
+                    ++counts[pass][(bits >> (pass * 8)) & 0xFF];
+            }
+            
+            for (size_t pass = 0; pass < passes; ++pass) {
+                auto& count = counts[pass];
+                if (sorted or count[(keys[0].first >> (pass * 8)) & 0xFF] == n)
+                    continue;
+                
+                size_t offset = 0;
+                for (auto& c : count)
+                    offset += std::exchange(c, offset);
+                for (const auto& key : keys)
+                    buffer[count[(key.first >> (pass * 8)) & 0xFF]++] = key;
+                keys.swap(buffer);
+            }
+            
+            std::vector<size_t> order(n);
+            for (size_t i = 0; i < n; ++i)
+                order[i] = keys[i].second;
+            return order;
+        }
+        
+        /*
+            Evaluates every key once and returns the positions of the elements in sorted order. Equal keys keep their
+            original order.
+         */
+        template<typename container, typename key_selector, typename key_compare>
+        std::vector<size_t> sorted_order(const container& src, key_selector& key_func, key_compare& compare) {
+            using key_type = std::decay_t<decltype(key_func(*std::begin(src)))>;
+            
+            std::vector<std::pair<key_type, size_t>> keys;
+            keys.reserve(std::size(src));
+            for (const auto& value : src)
+                keys.emplace_back(key_func(value), keys.size());
+            
+            std::sort(keys.begin(), keys.end(), [&compare](const auto& l, const auto& r) {
+                if (compare(l.first, r.first))
+                    return true;
+                return not compare(r.first, l.first) and l.second < r.second;
+            });
+            
+            std::vector<size_t> order(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                order[i] = keys[i].second;
+            return order;
+        }
+        
+        /*
+            Moves c[order[i]] to position i by walking the cycles of the permutation; `order` is consumed.
+         */
+        template<typename container>
+        void apply_order(container& c, std::vector<size_t>& order) {
+            auto first = std::begin(c);
+            for (size_t i = 0; i < order.size(); ++i) {
+                if (order[i] == i)
+                    continue;
+                
+                auto value = std::move(first[i]);
+                size_t j = i;
+                while (order[j] != i) {
+                    const size_t next = order[j];
+                    first[j] = std::move(first[next]);
+                    order[j] = j;
+                    j = next;
+                }
+                first[j] = std::move(value);
+                order[j] = j;
+            }
+        }
+        
+        template<typename container, typename key_selector, typename key_compare>
+        void sort_by_key(container& c, key_selector& key_func, key_compare&& compare) {
+            if constexpr (radix_sortable_v<container, key_selector, key_compare>) {
+                if (std::size(c) >= radix_sort_threshold) {
+                    auto order = radix_order(c, key_func, sort_direction<std::decay_t<key_compare>>::value < 0);
+                    apply_order(c, order);
+                    return;
+                }
+            }
+            
+            if constexpr (cache_keys_v<container, key_selector>) {
+                auto order = sorted_order(c, key_func, compare);
+                apply_order(c, order);
+            } else {
+                std::sort(std::begin(c), std::end(c), [&key_func, &compare](const auto& l, const auto& r) {
+                    return compare(key_func(l), key_func(r));
+                });
+            }
+        }
+        
+        template<typename container, typename key_selector, typename key_compare>
+        auto sorted_by_key(const container& src, key_selector& key_func, key_compare&& compare) {
+            if constexpr (is_view<container>::value) {
+                /* a view is copied into the vector it materializes into, which is then sorted in place */
+                auto result = make_like(src, src);
+                sort_by_key(result, key_func, compare);
+                return result;
+            } else {
+                auto gather = [&src](const std::vector<size_t>& order) {
+                    auto result = make_like(src);
+                    if constexpr (has_reserve<container>::value)
+                        result.reserve(order.size());
+                    for (auto i : order)
+                        result.push_back(std::begin(src)[i]);
+                    return result;
+                };
+                
+                if constexpr (radix_sortable_v<container, key_selector, key_compare>) {
+                    if (std::size(src) >= radix_sort_threshold)
+                        return gather(radix_order(src, key_func, sort_direction<std::decay_t<key_compare>>::value < 0));
+                }
+                
+                if constexpr (cache_keys_v<container, key_selector>) {
+                    return gather(sorted_order(src, key_func, compare));
+                } else {
+                    auto result = make_like(src, std::begin(src), std::end(src));
+                    sort_by_key(result, key_func, compare);
+                    return result;
+                }
+            }
+        }
+        
+        /*
+            sorted_by_key on the thread pool. Cached keys are computed concurrently and sorted as (key, position) pairs,
+            which makes the order stable as in the serial version; other keys are compared through the selector. Either
+            way the selector must be thread-safe. The keys or the copy are built once and sorted serially when the
+            parallel sort declines.
+         */
+        template<typename policy, typename container, typename key_selector, typename key_compare>
+        auto sorted_by_key(const policy& p, const container& src, key_selector& key_func, key_compare&& compare) {
+            if constexpr (std::is_same_v<policy, parallel_policy> and is_random_access_v<container>) {
+                const size_t count = std::size(src);
+                if (chunk_count(p, count) >= 2) {
+                    if constexpr (cache_keys_v<container, key_selector>) {
+                        using key_type = selected_key_t<container, key_selector>;
+                        
+                        if constexpr (std::is_default_constructible_v<key_type>) {
+                            const auto first = std::begin(src);
+                            std::vector<std::pair<key_type, size_t>> keys(count);
+                            parallel_chunks(executor_of(p), count, chunk_count(p, count), [&](size_t, size_t b, size_t e) {
+                                for (; b < e; ++b)
+                                    keys[b] = { key_func(first[b]), b };
+                            });
+                            
+                            auto less = [&compare](const auto& l, const auto& r) {
+                                if (compare(l.first, r.first))
+                                    return true;
+                                return not compare(r.first, l.first) and l.second < r.second;
+                            };
+                            if (not parallel_sort(p, keys.begin(), count, less, false))
+                                std::sort(keys.begin(), keys.end(), less);
+                            
+                            auto result = make_like(src);
+                            if constexpr (has_reserve<container>::value)
+                                result.reserve(count);
+                            for (const auto& key : keys)
+                                result.push_back(first[key.second]);
+                            return result;
+                        }
+                    } else {
+                        auto result = make_like(src, std::begin(src), std::end(src));
+                        auto less = [&key_func, &compare](const auto& l, const auto& r) {
+                            return compare(key_func(l), key_func(r));
+                        };
+                        if (not parallel_sort(p, std::begin(result), count, less, false))
+                            sort_by_key(result, key_func, compare);
+                        return result;
+                    }
+                }
+            }
+            return sorted_by_key(src, key_func, compare);
+        }
+        
+        template<typename comparer>
+        auto reverse_order(comparer& compare) {
+            return [&compare](const auto& l, const auto& r) { return compare(r, l); };
+        }
+        
+        /*
+            Keeps the k smallest entries offered to it, in `less` order, as a max-heap: the root is the entry the next
+            better candidate replaces. k must not be 0.
+         */
+        template<typename entry, typename entry_less>
+        class bounded_heap {
+        public:
+            bounded_heap(size_t k, entry_less less) : k_(k), less_(std::move(less)) {
+                heap_.reserve(std::min<size_t>(k, 1024));
+            }
+            
+            /* The entry a candidate must beat, or nullptr while fewer than k entries are kept. */
+            const entry* worst() const {
+                return heap_.size() < k_ ? nullptr : &heap_.front();
+            }
+            
+            void push(entry e) {
+                if (heap_.size() < k_) {
+                    heap_.push_back(std::move(e));
+                    std::push_heap(heap_.begin(), heap_.end(), less_);
+                } else {
+                    std::pop_heap(heap_.begin(), heap_.end(), less_);
+                    heap_.back() = std::move(e);
+                    std::push_heap(heap_.begin(), heap_.end(), less_);
+                }
+            }
+            
+            /* The kept entries, best first. */
+            std::vector<entry> sorted() && {
+                std::sort_heap(heap_.begin(), heap_.end(), less_);
+                return std::move(heap_);
+            }
+            
+        private:
+            size_t k_;
+            entry_less less_;
+            std::vector<entry> heap_;
+        };
+        
+        /*
+            Single pass over src with O(k) memory: keys are computed once per element and an element is copied only when it
+            enters the heap. Equal keys keep their original order.
+         */
+        template<typename container, typename key_selector, typename key_compare>
+        auto top_by_key(const container& src, size_t k, key_selector& key_func, key_compare&& compare) {
+            using key_type = selected_key_t<container, key_selector>;
+            using value_type = std::decay_t<decltype(*std::begin(src))>;
+            
+            struct entry {
+                key_type key;
+                size_t index;
+                value_type value;
+            };
+            
+            auto less = [&compare](const entry& l, const entry& r) {
+                if (compare(l.key, r.key))
+                    return true;
+                return not compare(r.key, l.key) and l.index < r.index;
+            };
+            
+            auto result = make_like(src);
+            if (k == 0)
+                return result;
+            
+            bounded_heap<entry, decltype(less)> heap(k, less);
+            size_t index = 0;
+            for (const auto& value : src) {
+                auto key = key_func(value);
+                const entry* worst = heap.worst();
+                if (worst == nullptr or compare(key, worst->key))
+                    heap.push(entry{ std::move(key), index, value });
+                ++index;
+            }
+            
+            auto top = std::move(heap).sorted();
+            if constexpr (has_reserve<container>::value)
+                result.reserve(top.size());
+            for (auto& e : top)
+                result.push_back(std::move(e.value));
+            return result;
+        }
+        
+    }
+    
+    
+    /*
+        Marks a key selector whose keys must be computed only once per element by the ordering operators, e.g. an expensive hash.
+        Selectors returning non-scalar keys (strings, tuples, ...) are cached without it.
+     */
+    template<typename key_selector>
+    auto cached_key(key_selector&& key_func) {
+        return detail::cached_key_selector<std::decay_t<key_selector>>{ std::forward<key_selector>(key_func) };
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order according to a key.
+     */
+    template<typename container, typename predicate>
+    auto OrderBy(const container& src, predicate&& key_func) {
+        return detail::sorted_by_key(src, key_func, std::less<>());
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order according to a key. The sequence is sorted in place.
+     */
+    template<typename container, typename predicate, typename = detail::enable_for_rvalue<container>>
+    auto OrderBy(container&& src, predicate&& key_func) {
+        detail::sort_by_key(src, key_func, std::less<>());
+        return std::move(src);
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order by using a specified comparer.
+     */
+    template<typename container, typename predicate, typename comparer, typename = detail::disable_for_policy<container>>
+    auto OrderBy(const container& src, predicate&& key_func, comparer&& compare) {
+        return detail::sorted_by_key(src, key_func, compare);
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order by using a specified comparer. The sequence is sorted in place.
+     */
+    template<typename container, typename predicate, typename comparer,
+             typename = detail::enable_for_rvalue<container>, typename = detail::disable_for_policy<container>>
+    auto OrderBy(container&& src, predicate&& key_func, comparer&& compare) {
+        detail::sort_by_key(src, key_func, compare);
+        return std::move(src);
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in descending order according to a key.
+     */
+    template<typename container, typename predicate>
+    auto OrderByDescending(const container& src, predicate&& key_func) {
+        return detail::sorted_by_key(src, key_func, std::greater<>());
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in descending order according to a key. The sequence is sorted in place.
+     */
+    template<typename container, typename predicate, typename = detail::enable_for_rvalue<container>>
+    auto OrderByDescending(container&& src, predicate&& key_func) {
+        detail::sort_by_key(src, key_func, std::greater<>());
+        return std::move(src);
+    }
+
+    
+    /*
+        Sorts the elements of a sequence in descending order by using a specified comparer.
+     */
+    template<typename container, typename predicate, typename comparer, typename = detail::disable_for_policy<container>>
+    auto OrderByDescending(const container& src, predicate&& key_func, comparer&& compare) {
+        return detail::sorted_by_key(src, key_func, detail::reverse_order(compare));
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in descending order by using a specified comparer. The sequence is sorted in place.
+     */
+    template<typename container, typename predicate, typename comparer,
+             typename = detail::enable_for_rvalue<container>, typename = detail::disable_for_policy<container>>
+    auto OrderByDescending(container&& src, predicate&& key_func, comparer&& compare) {
+        detail::sort_by_key(src, key_func, detail::reverse_order(compare));
+        return std::move(src);
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order according to a key, using the specified execution policy.
+     */
+    template<typename policy, typename container, typename predicate, typename = detail::enable_for_policy<policy>>
+    auto OrderBy(const policy& p, const container& src, predicate&& key_func) {
+        return detail::sorted_by_key(p, src, key_func, std::less<>());
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in ascending order by using a specified comparer and execution policy.
+     */
+    template<typename policy, typename container, typename predicate, typename comparer, typename = detail::enable_for_policy<policy>>
+    auto OrderBy(const policy& p, const container& src, predicate&& key_func, comparer&& compare) {
+        return detail::sorted_by_key(p, src, key_func, compare);
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in descending order according to a key, using the specified execution policy.
+     */
+    template<typename policy, typename container, typename predicate, typename = detail::enable_for_policy<policy>>
+    auto OrderByDescending(const policy& p, const container& src, predicate&& key_func) {
+        return detail::sorted_by_key(p, src, key_func, std::greater<>());
+    }
+    
+    
+    /*
+        Sorts the elements of a sequence in descending order by using a specified comparer and execution policy.
+     */
+    template<typename policy, typename container, typename predicate, typename comparer, typename = detail::enable_for_policy<policy>>
+    auto OrderByDescending(const policy& p, const container& src, predicate&& key_func, comparer&& compare) {
+        return detail::sorted_by_key(p, src, key_func, detail::reverse_order(compare));
+    }
+    
+    
+    /*
+        Returns the first count elements of the sequence sorted in ascending order according to a key, i.e.
+        Take(OrderBy(src, key), count), in O(n log count) time and O(count) memory.
+     */
+    template<typename container, typename predicate>
+    auto TopBy(const container& src, size_t count, predicate&& key_func) {
+        return detail::top_by_key(src, count, key_func, std::less<>());
+    }
+    
+    
+    /*
+        Returns the first count elements of the sequence sorted in ascending order by using a specified comparer.
+     */
+    template<typename container, typename predicate, typename comparer>
+    auto TopBy(const container& src, size_t count, predicate&& key_func, comparer&& compare) {
+        return detail::top_by_key(src, count, key_func, compare);
+    }
+    
+    
+    /*
+        Returns the first count elements of the sequence sorted in descending order according to a key.
+     */
+    template<typename container, typename predicate>
+    auto TopByDescending(const container& src, size_t count, predicate&& key_func) {
+        return detail::top_by_key(src, count, key_func, std::greater<>());
+    }
+    
+    
+    /*
+        Returns the first count elements of the sequence sorted in descending order by using a specified comparer.
+     */
+    template<typename container, typename predicate, typename comparer>
+    auto TopByDescending(const container& src, size_t count, predicate&& key_func, comparer&& compare) {
+        return detail::top_by_key(src, count, key_func, detail::reverse_order(compare));
+    }
+
+    
+    /*
+        Adds a value to the beginning of the sequence.
+    */
+    template<typename container>
+    void Prepend(const container& src, typename container::value_type&& value) {
+        src.insert(std::begin(src),
+                   value);
+    }
+
+
+    /*
+        Inverts the order of the elements in a sequence.
+    */
+    template<typename container>
+    void Reverse(container& src) {
+        std::reverse( std::begin(src), std::end(src) );
+    }
+
+    namespace detail {
+
+        /* Collection selectors take the element, or the element and its index. */
+        template<typename selector, typename value_type>
+        decltype(auto) select_collection(selector& collections, const value_type& value, size_t index) {
+            if constexpr (std::is_invocable_v<selector&, const value_type&>)
+                return collections(value);
+            else
+                return collections(value, index);
+        }
+
+        template<typename container, typename selector>
+        using selected_collection_t = decltype(select_collection(std::declval<selector&>(),
+                                                                 *std::begin(std::declval<const container&>()),
+                                                                 size_t()));
+
+        /* The default result selector of SelectMany: the inner element itself. */
+        struct inner_element {
+            template<typename source, typename element>
+            decltype(auto) operator()(const source&, element&& inner) const { return std::forward<element>(inner); }
+        };
+
+        /*
+            When the selector returns references to sized collections, they are measured first so that the result is
+            allocated exactly once; collections built on the fly are only visited once.
+         */
+        template<typename container, typename collection_selector, typename result_selector>
+        auto select_many(const container& src, collection_selector& collections, result_selector& result_of) {
+            using collection_type = selected_collection_t<container, collection_selector>;
+            using result_type = std::decay_t<decltype(result_of(*std::begin(src),
+                                                                *std::begin(std::declval<collection_type&>())))>;
+
+            std::vector<result_type> result;
+            if constexpr (std::is_lvalue_reference_v<collection_type> and is_sized<std::decay_t<collection_type>>::value) {
+                size_t total = 0;
+                size_t index = 0;
+                for (const auto& value : src)
+                    total += std::size(select_collection(collections, value, index++));
+                result.reserve(total);
+            }
+
+            size_t index = 0;
+            for (const auto& value : src) {
+                auto&& inner = select_collection(collections, value, index++);
+                for (auto&& element : inner)
+                    result.push_back(result_of(value, element));
+            }
+            return result;
+        }
+
+    }
+
+
+    /*
+        Projects each element of a sequence to a collection and flattens the resulting collections into one sequence.
+        The selector may also take the index of the element as its second argument. A selector that returns a reference
+        to a member, e.g. [](const order& o) -> const auto& { return o.lines; }, avoids copying the collections.
+     */
+    template<typename container, typename collection_selector>
+    auto SelectMany(const container& src, collection_selector&& collections) {
+        detail::inner_element result_of;
+        return detail::select_many(src, collections, result_of);
+    }
+
+
+    /*
+        Projects each element of a sequence to a collection, flattens the resulting collections into one sequence, and
+        invokes a result selector function on each element and the inner element it was projected to.
+     */
+    template<typename container, typename collection_selector, typename result_selector>
+    auto SelectMany(const container& src, collection_selector&& collections, result_selector&& result_of) {
+        return detail::select_many(src, collections, result_of);
+    }
+    
+    
+    /*
+        Returns the only element of a sequence, and throws an exception if there is not exactly one element in the sequence.
+     */
+    template<typename container>
+    auto Single(const container& src) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        return detail::has_single(src)
+            ? optional_type(*std::begin(src))
+            : optional_type();
+    }
+    
+
+    /*
+        Returns the only element of a sequence that satisfies a specified condition, and throws an exception if more than one such element exists.
+     */
+    template<typename container, typename unary_predicate>
+    auto Single(const container& src, unary_predicate&& condition) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        const auto found = detail::find_single_if(src, condition);
+        return found != std::end(src)
+            ? optional_type(*found)
+            : optional_type();
+    }
+    
+    
+    /*
+        Returns the only element of a sequence that satisfies a specified condition, using the specified execution policy.
+     */
+    template<typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    auto Single(const policy& p, const container& src, unary_predicate&& condition) {
+        using optional_type = std::optional<typename container::value_type>;
+        
+        const auto found = detail::parallel_find_single(p, src, condition);
+        if (not found)
+            return Single(src, condition);
+        return *found != std::size(src)
+            ? optional_type(std::begin(src)[*found])
+            : optional_type();
+    }
+
+    
+    /*
+        Returns the only element of a sequence, or a default value if the sequence is empty; this method throws an exception if there is more than one element in the sequence.
+    */
+    template<typename container>
+    auto SingleOrDefault(const container& src) {
+        return detail::has_single(src)
+        ? *std::begin(src)
+        : typename container::value_type();
+    }
+    
+    
+    /*
+        Returns the only element of a sequence that satisfies a specified condition or a default value if no such element exists; this method throws an exception if more than one element satisfies the condition.
+    */
+    template<typename container, typename unary_predicate>
+    auto SingleOrDefault(const container& src, unary_predicate&& condition) {
+        const auto found = detail::find_single_if(src, condition);
+        return found != std::end(src)
+            ? *found
+            : typename container::value_type();
+    }
+    
+    
+    /*
+        Returns the only element of a sequence that satisfies a specified condition or a default value, using the specified execution policy.
+    */
+    template<typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    auto SingleOrDefault(const policy& p, const container& src, unary_predicate&& condition) {
+        const auto found = detail::parallel_find_single(p, src, condition);
+        if (not found)
+            return SingleOrDefault(src, condition);
+        return *found != std::size(src)
+            ? std::begin(src)[*found]
+            : typename container::value_type();
+    }
+    
+
+    /*
+        Bypasses a specified number of elements in a sequence and then returns the remaining elements.
+     */
+    template<typename container>
+    auto Skip(const container& src, size_t count) {
+        return detail::make_like(src, detail::element_at(src, count), std::end(src));
+    }
+
+
+    /*
+        Bypasses a specified number of elements in a sequence and then returns the remaining elements. The skipped head is erased from the sequence itself.
+     */
+    template<typename container, typename = detail::enable_for_rvalue<container>>
+    auto Skip(container&& src, size_t count) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            src.erase(std::begin(src), detail::element_at(src, count));
+            return std::move(src);
+        } else {
+            return Skip(static_cast<const container&>(src), count);
+        }
+    }
+
+
+    /*
+        Returns the elements of a sequence without its last count elements.
+     */
+    template<typename container>
+    auto SkipLast(const container& src, size_t count) {
+        const size_t size = detail::size_of(src);
+        return detail::make_like(src, std::begin(src), detail::element_at(src, size - std::min(count, size)));
+    }
+
+
+    /*
+        Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements.
+     */
+    template<typename container, typename unary_predicate>
+    auto SkipWhile(const container& src, unary_predicate&& predicate) {
+        return detail::make_like(src,
+                                 std::find_if_not(std::begin(src), std::end(src), predicate),
+                                 std::end(src));
+    }
+    
+
+    /*
+        Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements. The skipped head is erased from the sequence itself.
+     */
+    template<typename container, typename unary_predicate, typename = detail::enable_for_rvalue<container>>
+    auto SkipWhile(container&& src, unary_predicate&& predicate) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            src.erase(std::begin(src),
+                      std::find_if_not(std::begin(src), std::end(src), predicate));
+            return std::move(src);
+        } else {
+            return SkipWhile(static_cast<const container&>(src), predicate);
+        }
+    }
+    
+
+    /*
+        Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements. The element's index is used in the logic of the predicate function.
+     */
+    template<typename index_t, typename container, typename binary_predicate>
+    auto SkipWhile(const container& src, binary_predicate&& predicate) {
+        auto f = std::begin(src);
+        for (index_t ind = 0; ind < std::size(src); ++ind, f++) {
+            if (not predicate(ind, *f)) {
+                break;
+            }
+        };
+        return detail::make_like(src, f, std::end(src));
+    }
+    
+    
+    /*
+        Computes the sum of a sequence.
+    */
+    template<typename container>
+    auto Sum(const container& c) {
+        if constexpr (detail::simd::has_kernel_v<container>) {
+            return detail::simd::sum(std::data(c), std::size(c));
+        } else {
+            return std::accumulate(std::begin(c), 
+                                   std::end(c),
+                                   typename container::value_type());
+        }
+    }
+    
+    
+    /*
+        Computes the sum of a sequence with the specified summation algorithm. Only floating-point sequences are affected by the choice.
+    */
+    template<typename container>
+    auto Sum(const container& c, summation mode) {
+        using value_type = typename container::value_type;
+        
+        if constexpr (std::is_floating_point_v<value_type>) {
+            if (mode == summation::kahan) {
+                return detail::kahan_sum(std::begin(c), std::end(c));
+            }
+            if (mode == summation::pairwise) {
+                if constexpr (detail::is_contiguous_v<container>) {
+                    return detail::pairwise_sum(std::data(c), std::size(c));
+                } else {
+                    const std::vector<value_type> values(std::begin(c), std::end(c));
+                    return detail::pairwise_sum(values.data(), values.size());
+                }
+            }
+        }
+        return Sum(c);
+    }
+    
+    
+    /*
+        Computes the sum of a sequence, using the specified execution policy.
+    */
+    template<typename policy, typename container, typename = detail::enable_for_policy<policy>>
+    auto Sum(const policy& p, const container& c) {
+        using value_type = typename container::value_type;
+        
+        auto result = detail::parallel_reduce(p, c,
+                                              [](auto first, auto last) {
+                                                  if constexpr (detail::simd::has_kernel_v<container>)
+                                                      return detail::simd::sum(&*first, static_cast<size_t>(last - first));
+                                                  else
+                                                      return std::accumulate(first, last, value_type());
+                                              },
+                                              [](value_type l, value_type r) { return value_type(l + r); });
+        return result
+            ? *result
+            : Sum(c);
+    }
+
+
+    /*
+        Computes the sum of the sequence of Decimal values that are obtained by invoking a transform function on each element of the input sequence.
+    */
+    template<typename container, typename transform, typename = detail::disable_for_policy<container>>
+    auto Sum(const container& c, transform&& trans) {
+        return std::accumulate(std::begin(c),
+                               std::end(c),
+                               typename container::value_type(),
+                               trans);
+    }
+
+    
+    /*
+        Returns elements from a sequence as long as a specified condition is true.
+     */
+    template<typename container, typename condition>
+    auto TakeWhile(const container& src, condition&& cond) {
+        auto it = std::begin(src);
+        while (it != std::end(src) and cond(*it))
+            it++;
+        
+        return detail::make_like(src, std::begin(src), it);
+    }
+    
+    
+    /*
+        Returns elements from a sequence as long as a specified condition is true. The rest is erased from the sequence itself.
+     */
+    template<typename container, typename condition, typename = detail::enable_for_rvalue<container>>
+    auto TakeWhile(container&& src, condition&& cond) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            src.erase(std::find_if_not(std::begin(src), std::end(src), cond),
+                      std::end(src));
+            return std::move(src);
+        } else {
+            return TakeWhile(static_cast<const container&>(src), cond);
+        }
+    }
+    
+    
+    /*
+        Returns elements from a sequence as long as a specified condition is true. The element's index is used in the logic of the predicate function.
+     */
+    template<typename index_t, typename container, typename condition>
+    auto TakeWhile(const container& src, condition&& cond) {
+        auto it = std::begin(src);
+        index_t index = 0;
+        while (it != std::end(src) and cond(index, *it)) {
+            it++;
+            index++;
+        }
+        
+        return detail::make_like(src, std::begin(src), it);
+    }
+    
+//ThenBy / ThenByDescending are members of the ordered query returned by from(src).OrderBy(...), see ordered_query.
+//ThenBy<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>)
+//Performs a subsequent ordering of the elements in a sequence in ascending order according to a key.
+//ThenBy<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>, IComparer<TKey>)
+//Performs a subsequent ordering of the elements in a sequence in ascending order by using a specified comparer.
+//ThenByDescending<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>)
+//Performs a subsequent ordering of the elements in a sequence in descending order, according to a key.
+//ThenByDescending<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>, IComparer<TKey>)
+//Performs a subsequent ordering of the elements in a sequence in descending order by using a specified comparer.
+//ToArray<TSource>(IEnumerable<TSource>)
+//Creates an array from a IEnumerable<T>.
+//ToList<TSource>(IEnumerable<TSource>)
+//Creates a List<T> from an IEnumerable<T>.
+
+    /*
+        Creates a dictionary from a sequence according to a specified key selector function, a comparer, and an element selector function.
+        The backing table is std::unordered_map unless another map template (e.g. simlinq::flat_map) is requested; throws std::invalid_argument on duplicate keys.
+    */
+    template<template<typename...> class map_type = std::unordered_map,
+             typename container, typename key_selector, typename element_selector, typename hash, typename key_equal>
+    auto ToDictionary(const container& src, key_selector&& key_sel, element_selector&& elem_sel,
+                      const equality_comparer<hash, key_equal>& comparer) {
+        return detail::to_dictionary<map_type>(src, key_sel, elem_sel, comparer.hasher, comparer.equal);
+    }
+
+
+    /*
+        Creates a dictionary from a sequence according to specified key selector and element selector functions.
+    */
+    template<template<typename...> class map_type = std::unordered_map,
+             typename container, typename key_selector, typename element_selector,
+             typename = detail::disable_for_comparer<element_selector>>
+    auto ToDictionary(const container& src, key_selector&& key_sel, element_selector&& elem_sel) {
+        return detail::to_dictionary<map_type>(src, key_sel, elem_sel,
+                                               detail::key_hash_t<container, key_selector>(),
+                                               detail::key_equal_t<container, key_selector>());
+    }
+
+
+    /*
+        Creates a dictionary from a sequence according to a specified key selector function and key comparer.
+    */
+    template<template<typename...> class map_type = std::unordered_map,
+             typename container, typename key_selector, typename hash, typename key_equal>
+    auto ToDictionary(const container& src, key_selector&& key_sel, const equality_comparer<hash, key_equal>& comparer) {
+        detail::identity elem_sel;
+        return detail::to_dictionary<map_type>(src, key_sel, elem_sel, comparer.hasher, comparer.equal);
+    }
+
+
+    /*
+        Creates a dictionary from a sequence according to a specified key selector function.
+    */
+    template<template<typename...> class map_type = std::unordered_map,
+             typename container, typename key_selector>
+    auto ToDictionary(const container& src, key_selector&& key_sel) {
+        detail::identity elem_sel;
+        return detail::to_dictionary<map_type>(src, key_sel, elem_sel,
+                                               detail::key_hash_t<container, key_selector>(),
+                                               detail::key_equal_t<container, key_selector>());
+    }
+
+
+    /*
+        Creates a hash set from a sequence using the comparer to compare keys.
+        The backing table is std::unordered_set unless another set template (e.g. simlinq::flat_set) is requested.
+    */
+    template<template<typename...> class set_type = std::unordered_set,
+             typename container, typename hash, typename key_equal>
+    auto ToHashSet(const container& src, const equality_comparer<hash, key_equal>& comparer) {
+        return detail::to_hash_set<set_type>(src, comparer.hasher, comparer.equal);
+    }
+
+
+    /*
+        Creates a hash set from a sequence.
+    */
+    template<template<typename...> class set_type = std::unordered_set,
+             typename container>
+    auto ToHashSet(const container& src) {
+        using value_type = detail::value_type_t<container>;
+        return detail::to_hash_set<set_type>(src, std::hash<value_type>(), std::equal_to<value_type>());
+    }
+
+
+    /*
+        Creates a lookup from a sequence according to a specified key selector function, a comparer and an element selector function.
+        All elements are stored in a single buffer indexed by per-key offsets.
+    */
+    template<typename container, typename key_selector, typename element_selector, typename hash, typename key_equal>
+    auto ToLookup(const container& src, key_selector&& key_sel, element_selector&& elem_sel,
+                  const equality_comparer<hash, key_equal>& comparer) {
+        return detail::make_lookup(src, key_sel, elem_sel, comparer.hasher, comparer.equal);
+    }
+
+
+    /*
+        Creates a lookup from a sequence according to specified key selector and element selector functions.
+    */
+    template<typename container, typename key_selector, typename element_selector,
+             typename = detail::disable_for_comparer<element_selector>>
+    auto ToLookup(const container& src, key_selector&& key_sel, element_selector&& elem_sel) {
+        return detail::make_lookup(src, key_sel, elem_sel,
+                                   detail::key_hash_t<container, key_selector>(),
+                                   detail::key_equal_t<container, key_selector>());
+    }
+
+
+    /*
+        Creates a lookup from a sequence according to a specified key selector function and key comparer.
+    */
+    template<typename container, typename key_selector, typename hash, typename key_equal>
+    auto ToLookup(const container& src, key_selector&& key_sel, const equality_comparer<hash, key_equal>& comparer) {
+        detail::identity elem_sel;
+        return detail::make_lookup(src, key_sel, elem_sel, comparer.hasher, comparer.equal);
+    }
+
+
+    /*
+        Creates a lookup from a sequence according to a specified key selector function.
+    */
+    template<typename container, typename key_selector>
+    auto ToLookup(const container& src, key_selector&& key_sel) {
+        detail::identity elem_sel;
+        return detail::make_lookup(src, key_sel, elem_sel,
+                                   detail::key_hash_t<container, key_selector>(),
+                                   detail::key_equal_t<container, key_selector>());
+    }
+
+    /*
+        Produces the set union of two sequences by using the default equality comparer.
+    */
+    template<typename container>
+    auto Union(const container& first, const container& second) {
+        std::unordered_set<typename container::value_type> result;
+        result.reserve(std::size(first) + std::size(second));
+
+        result.insert(std::begin(first), std::end(first));
+        result.insert(std::begin(second), std::end(second));
+        return result;
+    }
+
+
+    /*
+        Produces the set union of two sequences by using a specified IEqualityComparer<T>.
+    */
+    template<typename container, typename comparator>
+    auto Union(const container& first, const container& second, comparator&& comp) {
+        using value_type = typename container::value_type;
+        std::unordered_set<value_type, std::hash<value_type>, std::decay_t<comparator>> result(std::size(first) + std::size(second),
+                                                                                             std::hash<value_type>(),
+                                                                                             comp);
+
+        result.insert(std::begin(first), std::end(first));
+        result.insert(std::begin(second), std::end(second));
+        return result;
+    }
+
+
+    /*
+        Filters a sequence of values based on a predicate.
+    */
+    template<typename container, typename unary_predicate>
+    auto Where(const container& src, unary_predicate&& predicate) {
+        auto result = detail::make_like(src);
+
+        std::copy_if(std::begin(src),
+                     std::end(src),
+                     std::back_inserter(result),
+                     predicate);
+        return result;
+    }
+
+
+    /*
+        Filters a sequence of values based on a predicate. The rejected elements are removed from the sequence itself.
+    */
+    template<typename container, typename unary_predicate, typename = detail::enable_for_rvalue<container>>
+    auto Where(container&& src, unary_predicate&& predicate) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            src.erase(std::remove_if(std::begin(src),
+                                     std::end(src),
+                                     [&predicate](const auto& value) { return not predicate(value); }),
+                      std::end(src));
+            return std::move(src);
+        } else {
+            return detail::through_vector(src, [&predicate](auto values) { return Where(std::move(values), predicate); });
+        }
+    }
+
+
+    /*
+        Filters a sequence of values based on a predicate. Each element's index is used in the logic of the predicate function.
+    */
+//    template<typename container, typename binary_predicate>
+//    auto Where(const container& src, binary_predicate&& predicate) {
+//        container result;
+//        size_t index = 0;
+//        for (const auto& value : src) {
+//            if (predicate(index, value)) {
+//                result.push_back(value);
+//            }
+//            index ++;
+//        }
+//
+//        return result;
+//    }
+
+
+
+    /*
+        Applies a specified function to the corresponding elements of two sequences, producing a sequence of the results.
+     */
+    template<typename first_container,
+             typename second_container,
+             typename binary_predicate>
+    auto Zip(const first_container& first, const second_container& second, binary_predicate&& predicate) {
+        using result_type = std::decay_t<decltype(predicate(*std::begin(first), *std::begin(second)))>;
+        std::vector<result_type> result;
+        if constexpr (detail::is_sized<first_container>::value and detail::is_sized<second_container>::value)
+            result.reserve(std::min<size_t>(std::size(first), std::size(second)));
         
-        return std::begin(src) == std::end(src)
-            ? optional_type()
-            : optional_type(src.front());
+        auto fit = std::begin(first);
+        auto sit = std::begin(second);
+        for (;
+             fit != std::end(first) and sit != std::end(second);
+             ++fit, ++sit) {
+            result.push_back( predicate(*fit, *sit));
+        }
+        
+        return result;
+    }
+
+    /*
+        Determines whether all elements of a sequence satisfy a condition.
+     */
+    template <typename container, typename unary_predicate>
+    bool All(const container &src, unary_predicate &&condition) {
+        return std::all_of(std::begin(src),
+                           std::end(src),
+                           condition);
+    }
+
+    /*
+        Determines whether all elements of a sequence satisfy a condition, using the specified execution policy.
+     */
+    template <typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    bool All(const policy &p, const container &src, unary_predicate &&condition) {
+        auto violated = detail::parallel_any(p, src, [&condition](const auto &value) { return not condition(value); });
+        return violated
+            ? not *violated
+            : All(src, condition);
+    }
+
+    /*
+        Determines whether a sequence contains any elements.
+     */
+    template <typename container>
+    bool Any(const container &src) {
+        return std::begin(src) != std::end(src);
+    }
+
+    /*
+        Determines whether any element of a sequence satisfies a condition.
+    */
+    template <typename container, typename unary_predicate, typename = detail::disable_for_policy<container>>
+    bool Any(const container &src, unary_predicate &&condition) {
+        for (auto it = std::begin(src); it != std::end(src); ++it)
+        {
+            if (condition(*it))
+                return true;
+        }
+        return false;
+    }
+
+    /*
+        Determines whether any element of a sequence satisfies a condition, using the specified execution policy.
+    */
+    template <typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    bool Any(const policy &p, const container &src, unary_predicate &&condition) {
+        auto found = detail::parallel_any(p, src, condition);
+        return found
+            ? *found
+            : Any(src, condition);
+    }
+
+    /*
+        Concatenates two sequences.
+    */
+    template <typename container>
+    auto Concat(const container &first, const container &second) {
+        if constexpr (detail::is_contiguous_v<container>) {
+            /* one allocation, and a bulk copy of each half for trivially copyable elements */
+            auto result = detail::make_like(first);
+            result.reserve(std::size(first) + std::size(second));
+            result.insert(std::end(result), std::begin(first), std::end(first));
+            result.insert(std::end(result), std::begin(second), std::end(second));
+            return result;
+        } else {
+            auto result = detail::make_like(first, detail::size_of(first) + detail::size_of(second));
+
+            std::copy(std::begin(second),
+                    std::end(second),
+                    std::copy(std::begin(first),
+                                std::end(first),
+                                std::begin(result)));
+            return result;
+        }
+    }
+
+    /*
+        Determines whether any element of a sequence satisfies a condition.
+    */
+    template <typename container, typename T>
+    bool Contains(const container &src, const T &&value) {
+        return std::find(std::begin(src),
+                        std::end(src),
+                        value) != std::end(src);
+    }
+
+    /*
+        Determines whether a sequence contains a specified element, using the specified execution policy.
+    */
+    template <typename policy, typename container, typename T, typename = detail::enable_for_policy<policy>>
+    bool Contains(const policy &p, const container &src, const T &value) {
+        auto found = detail::parallel_any(p, src, [&value](const auto &v) { return v == value; });
+        return found
+            ? *found
+            : std::find(std::begin(src), std::end(src), value) != std::end(src);
+    }
+
+    /*
+        Determines whether a sequence contains a specified element by using a specified binary predicate.
+    */
+    template <typename container, typename T, typename binary_predicate, typename = detail::disable_for_policy<container>>
+    bool Contains(const container &src, const T &&value, binary_predicate &&predicate) {
+        for (auto it = std::begin(src); it != std::end(src); ++it)
+        {
+            if (predicate(*it, value))
+                return true;
+        }
+
+        return false;
+    }
+
+    /*
+        Returns the number of elements in a sequence.
+    */
+    template <typename container>
+    auto Count(const container &src) {
+        return detail::size_of(src);
+    }
+
+    /*
+        Returns a number that represents how many elements in the specified sequence satisfy a condition.
+    */
+    template <typename container, typename unary_predicate, typename = detail::disable_for_policy<container>>
+    auto Count(const container &src, unary_predicate &&condition) {
+        return std::count_if(std::begin(src),
+                            std::end(src),
+                            condition);
+    }
+
+    /*
+        Returns a number that represents how many elements in the specified sequence satisfy a condition, using the specified execution policy.
+    */
+    template <typename policy, typename container, typename unary_predicate, typename = detail::enable_for_policy<policy>>
+    auto Count(const policy &p, const container &src, unary_predicate &&condition) {
+        using count_type = decltype(std::count_if(std::begin(src), std::end(src), condition));
+        
+        auto result = detail::parallel_reduce(p, src,
+                                              [&condition](auto first, auto last) { return std::count_if(first, last, condition); },
+                                              std::plus<count_type>());
+        return result
+            ? *result
+            : Count(src, condition);
+    }
+
+    /*
+        Returns the number of elements of every group of a sequence, keys are compared by using a specified comparer.
+    */
+    template <typename container, typename key_selector, typename hash, typename key_equal>
+    auto CountBy(const container &src, key_selector &&key_sel, const equality_comparer<hash, key_equal> &comparer) {
+        return AggregateBy(src, key_sel, size_t(0),
+                           [](const auto &, size_t &count) { ++count; },
+                           comparer);
+    }
+
+    /*
+        Returns the number of elements of every group of a sequence as (key, count) pairs ordered by the first occurrence of the key.
+    */
+    template <typename container, typename key_selector>
+    auto CountBy(const container &src, key_selector &&key_sel) {
+        return AggregateBy(src, key_sel, size_t(0),
+                           [](const auto &, size_t &count) { ++count; });
+    }
+
+    /*
+        Returns an empty IEnumerable<T> that has the specified type argument.
+    */
+    template <typename T>
+    auto Empty() {
+        return T{};
+    }
+
+    /*
+        Produces the set difference of two sequences by using the default equality comparer to compare values.
+        A short second sequence is scanned linearly, sorted inputs are merged and hashable elements are looked up in a
+        hash index over the second sequence; the order of the first sequence is kept.
+    */
+    template <typename container>
+    auto except(const container &first, const container &second) {
+        using value_type = detail::value_type_t<container>;
+        
+        if constexpr (detail::is_hashable<value_type>::value) {
+            if (std::size(second) > detail::hash_set_threshold) {
+                auto result = detail::make_like(first);
+                
+                if (detail::is_sorted(first) and detail::is_sorted(second)) {
+                    auto other = std::begin(second);
+                    for (const auto& value : first) {
+                        while (other != std::end(second) and *other < value)
+                            ++other;
+                        if (other == std::end(second) or value < *other)
+                            result.push_back(value);
+                    }
+                    return result;
+                }
+                
+                detail::flat_index<value_type> index;
+                index.reserve(std::size(second));
+                for (const auto& value : second)
+                    index.insert(value);
+                std::copy_if(std::begin(first), std::end(first), std::back_inserter(result),
+                             [&index](const value_type& value) { return index.find(value) == detail::flat_index<value_type>::npos; });
+                return result;
+            }
+        }
+        
+        auto result = detail::make_like(first);
+        std::copy_if(std::begin(first),
+                    std::end(first),
+                    std::back_inserter(result),
+                    [&second](const typename container::value_type &value) {
+                        return std::find(std::begin(second), std::end(second), value) == std::end(second);
+                    });
+        return result;
+    }
+
+    /*
+        Produces the set difference of two sequences by using the specified IEqualityComparer<T> to compare values.
+    */
+    template <typename container, typename binary_predicate>
+    auto except(const container &first, const container &second, binary_predicate &&comparator) {
+        auto result = detail::make_like(first);
+        std::copy_if(std::begin(first),
+                    std::end(first),
+                    std::back_inserter(result),
+                    [&second, &comparator](const typename container::value_type &value) {
+                        return std::find_if(std::begin(second),
+                                            std::end(second),
+                                            [&comparator, &value](const typename container::value_type &nested_value) {
+                                                return comparator(value, nested_value);
+                                            }) == std::end(second);
+                    });
+        return result;
+    }
+    
+
+    /*
+        Projects each element of a sequence into a new form by incorporating the element's index. The result is allocated with the specified allocator.
+    */
+    template <template <typename, typename> class ret_type, typename container, typename allocator, typename ind_type = uint32_t,
+              typename = std::enable_if_t<detail::is_allocator_v<allocator>>>
+    auto select(container &src, const allocator &alloc) {
+        using pair = std::pair<ind_type, typename container::value_type>;
+        using allocator_type = detail::rebind_alloc_t<allocator, pair>;
+        ret_type<pair, allocator_type> result{ allocator_type(alloc) };
+        if constexpr (detail::has_reserve<ret_type<pair, allocator_type>>::value)
+            result.reserve(detail::size_of(src));
+
+        ind_type i = 0;
+        for (const auto& value : src)
+        {
+            result.push_back(pair{i++, value});
+        }
+        return result;
+    }
+
+    /*
+        Projects each element of a sequence into a new form by incorporating the element's index.
+    */
+    template <template <typename, typename> class ret_type, typename container, typename ind_type = uint32_t>
+    auto select(container &src) {
+        using pair = std::pair<ind_type, typename container::value_type>;
+        return select<ret_type, container, std::allocator<pair>, ind_type>(src, std::allocator<pair>());
+    }
+
+    /*
+        Projects each element of a sequence into a new form.
+    */
+    template <template <typename, typename> class ret_type, typename container, typename transform_func,
+              typename = detail::disable_for_allocator<transform_func>>
+    auto select(container &src, transform_func &&f) {
+        ret_type<typename container::value_type, std::allocator<typename container::value_type>> result(src);
+
+        std::transform(std::begin(src), std::end(src), result.begin(), f);
+
+        return result;
+    }
+
+    /*
+        Projects each element of a sequence into a new form. The result is allocated with the specified allocator.
+    */
+    template <template <typename, typename> class ret_type, typename container, typename transform_func, typename allocator>
+    auto select(container &src, transform_func &&f, const allocator &alloc) {
+        using value_type = std::decay_t<std::invoke_result_t<transform_func&, const typename container::value_type&>>;
+        using allocator_type = detail::rebind_alloc_t<allocator, value_type>;
+        ret_type<value_type, allocator_type> result{ allocator_type(alloc) };
+        if constexpr (detail::has_reserve<ret_type<value_type, allocator_type>>::value)
+            result.reserve(detail::size_of(src));
+
+        std::transform(std::begin(src), std::end(src), std::back_inserter(result), f);
+
+        return result;
+    }
+
+    /*
+        Determines whether two sequences are equal by comparing the elements by using the default equality comparer for their type.
+    */
+    template <typename container>
+    bool SequenceEqual(const container &first, const container &second) {
+        if constexpr (not detail::is_sized<container>::value)
+            return std::equal(std::begin(first), std::end(first), std::begin(second), std::end(second));
+        else
+            return std::size(first) == std::size(second)
+                    ? std::equal(std::begin(first), std::end(first), std::begin(second))
+                    : false;
+    }
+
+    /*
+        Determines whether two sequences are equal by comparing their elements by using a specified IEqualityComparer<T>
+    */
+    template <typename container, typename comparator>
+    bool SequenceEqual(const container &first, const container &second, comparator &&comp) {
+        if constexpr (not detail::is_sized<container>::value)
+            return std::equal(std::begin(first), std::end(first), std::begin(second), std::end(second), comp);
+        else
+            return std::size(first) == std::size(second)
+                    ? std::equal(std::begin(first), std::end(first), std::begin(second), comp)
+                    : false;
+    }
+
+    /*
+        Generates a sequence of integral numbers within a specified range.
+    */
+    template <typename container, typename T>
+    auto range(T &&value, uint32_t count) {
+        container c(count);
+        std::iota(std::begin(c), std::end(c), value);
+        return c;
+    }
+
+    /*
+        Generates a sequence of integral numbers within a specified range, allocated with the specified allocator.
+    */
+    template <typename container, typename T>
+    auto range(T &&value, uint32_t count, const typename container::allocator_type &alloc) {
+        container c(count, alloc);
+        std::iota(std::begin(c), std::end(c), value);
+        return c;
+    }
+
+    /*
+        Generates a sequence that contains one repeated value.
+    */
+    template <typename container, typename T>
+    container Repeat(T &&value, uint32_t count) {
+        return container(count, value);
+    }
+
+    /*
+        Generates a sequence that contains one repeated value, allocated with the specified allocator.
+    */
+    template <typename container, typename T>
+    container Repeat(T &&value, uint32_t count, const typename container::allocator_type &alloc) {
+        return container(count, value, alloc);
     }
 
-
     /*
-        Returns the first element in a sequence that satisfies a specified condition.
+        Returns a specified number of contiguous elements from the start of a sequence.
     */
-    template<typename container, typename unary_predicate>
-    auto First(const container& c, unary_predicate&& condition) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        auto res = std::find_if(std::begin(c),
-                                std::end(c),
-                                condition);
-        return res == std::end(c)
-                ? optional_type()
-                : optional_type(*res);
+    template <unsigned int N, typename container>
+    container Take(const container &src) {
+        return detail::make_like(src, std::begin(src), detail::element_at(src, N));
     }
 
+    /*
+        Returns a specified number of contiguous elements from the start of a sequence. Only the taken elements are read.
+    */
+    template <typename container>
+    auto Take(const container &src, size_t count) {
+        return detail::make_like(src, std::begin(src), detail::element_at(src, count));
+    }
 
     /*
-        Returns the first element of a sequence, or a default value if the sequence contains no elements.
+        Returns a specified number of contiguous elements from the start of a sequence. The rest is erased from the sequence itself.
     */
-    template<typename container>
-    auto FirstOrDefault(const container& c) {
-        return std::begin(c) == std::end(c)
-            ? typename container::value_type()
-            : typename container::value_type(c.front());
+    template <typename container, typename = detail::enable_for_rvalue<container>>
+    auto Take(container &&src, size_t count) {
+        if constexpr (detail::has_range_erase<container>::value) {
+            src.erase(detail::element_at(src, count), std::end(src));
+            return std::move(src);
+        } else {
+            return Take(static_cast<const container&>(src), count);
+        }
     }
 
+    /*
+        Returns the last count elements of a sequence.
+    */
+    template <typename container>
+    auto TakeLast(const container &src, size_t count) {
+        const size_t size = detail::size_of(src);
+        return detail::make_like(src, detail::element_at(src, size - std::min(count, size)), std::end(src));
+    }
 
     /*
-        Returns the first element of the sequence that satisfies a condition or a default value if no such element is found.
+        Returns at most limit elements of a sequence, starting at offset: Skip(offset) followed by Take(limit), without
+        reading past the page. Random-access sequences are sliced in constant time before the page is copied.
     */
-    template<typename container, typename condition>
-    auto FirstOrDefault(const container& c, condition&& cond) {
-        auto res = std::find_if(std::begin(c),
-                                std::end(c),
-                                cond);
-        return res == std::end(c)
-                ? typename container::value_type()
-                : *res;
+    template <typename container>
+    auto Page(const container &src, size_t offset, size_t limit) {
+        const auto first = detail::element_at(src, offset);
+        return detail::make_like(src, first, detail::advance_within(first, std::end(src), limit));
     }
 
-//GroupBy<TSource,TKey,TElement,TResult>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>, Func<TKey,IEnumerable<TElement>,TResult>)
-//Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key. The elements of each group are projected by using a specified function.
-//GroupBy<TSource,TKey,TElement,TResult>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>, Func<TKey,IEnumerable<TElement>,TResult>, IEqualityComparer<TKey>)
-//Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key. Key values are compared by using a specified comparer, and the elements of each group are projected by using a specified function.
-//GroupBy<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>)
-//Groups the elements of a sequence according to a specified key selector function and projects the elements for each group by using a specified function.
-//GroupBy<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>, IEqualityComparer<TKey>)
-//Groups the elements of a sequence according to a key selector function. The keys are compared by using a comparer and each group's elements are projected by using a specified function.
-//GroupBy<TSource,TKey,TResult>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TKey,IEnumerable<TSource>,TResult>)
-//Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key.
-//GroupBy<TSource,TKey,TResult>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TKey,IEnumerable<TSource>,TResult>, IEqualityComparer<TKey>)
-//Groups the elements of a sequence according to a specified key selector function and creates a result value from each group and its key. The keys are compared by using a specified comparer.
-//GroupBy<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>)
-//Groups the elements of a sequence according to a specified key selector function.
-//GroupBy<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>, IEqualityComparer<TKey>)
-//Groups the elements of a sequence according to a specified key selector function and compares the keys by using a specified comparer.
-//GroupJoin<TOuter,TInner,TKey,TResult>(IEnumerable<TOuter>, IEnumerable<TInner>, Func<TOuter,TKey>, Func<TInner,TKey>, Func<TOuter,IEnumerable<TInner>,TResult>)
-//Correlates the elements of two sequences based on equality of keys and groups the results. The default equality comparer is used to compare keys.
-//GroupJoin<TOuter,TInner,TKey,TResult>(IEnumerable<TOuter>, IEnumerable<TInner>, Func<TOuter,TKey>, Func<TInner,TKey>, Func<TOuter,IEnumerable<TInner>,TResult>, IEqualityComparer<TKey>)
-//Correlates the elements of two sequences based on key equality and groups the results. A specified IEqualityComparer<T> is used to compare keys.
     
     /*
-        Produces the set intersection of two sequences by using the default equality comparer to compare values.
+        Lazy query pipeline.
+
+        `from(src)` wraps a sequence into a query object. Query operators do not touch the data: each one
+        composes a new range on top of the previous stage, and the whole chain is evaluated in a single pass
+        only when the query is consumed (ToVector, Sum, First, range-based for, ...). Short-circuiting
+        consumers (First, Any, All, Contains) stop reading the source as soon as the answer is known.
      */
-    template<typename container>
-    auto Intersect(const container& first, const container& second) {
-        auto prepare = [](auto src) {
-             std::sort(std::begin(src), std::end(src));
-            return src;
+    namespace detail {
+        
+        template<typename range>
+        using range_iterator_t = decltype(std::declval<const range&>().begin());
+        
+        
+        template<typename iterator>
+        class iterator_range {
+        public:
+            iterator_range(iterator first, iterator last)
+                : first_(first), last_(last) {}
+            
+            iterator begin() const { return first_; }
+            iterator end() const { return last_; }
+            
+        private:
+            iterator first_;
+            iterator last_;
         };
-
-        container first_c = prepare(first);
-        container second_c = prepare(second);
         
-        container result;
-        std::set_intersection(std::begin(first_c), std::end(first_c),
-                              std::begin(second_c), std::end(second_c),
-                              std::back_inserter(result));
-        return result;
-    }
+        
+        /* Keeps a moved-in container alive for the lifetime of the query (and all of its copies). */
+        template<typename container>
+        class owning_range {
+        public:
+            explicit owning_range(container&& src)
+                : src_(std::make_shared<const container>(std::move(src))) {}
+            
+            auto begin() const { return std::begin(*src_); }
+            auto end() const { return std::end(*src_); }
+            
+        private:
+            std::shared_ptr<const container> src_;
+        };
+        
+        
+        template<typename range, typename unary_predicate>
+        class where_range {
+        public:
+            using base_iterator = range_iterator_t<range>;
+            
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = typename std::iterator_traits<base_iterator>::value_type;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = typename std::iterator_traits<base_iterator>::reference;
+                using pointer           = typename std::iterator_traits<base_iterator>::pointer;
+                
+                iterator() = default;
+                iterator(const where_range* parent, base_iterator it)
+                    : parent_(parent), it_(it) { satisfy(); }
+                
+                reference operator*() const { return *it_; }
+                iterator& operator++() { ++it_; satisfy(); return *this; }
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const { return it_ == other.it_; }
+                bool operator!=(const iterator& other) const { return it_ != other.it_; }
+                
+            private:
+                void satisfy() {
+                    const auto last = parent_->base_.end();
+                    while (it_ != last and not parent_->predicate_(*it_))
+                        ++it_;
+                }
+                
+                const where_range* parent_ = nullptr;
+                base_iterator it_;
+            };
+            
+            where_range(range base, unary_predicate predicate)
+                : base_(std::move(base)), predicate_(std::move(predicate)) {}
+            
+            iterator begin() const { return iterator(this, base_.begin()); }
+            iterator end() const { return iterator(this, base_.end()); }
+            
+        private:
+            range base_;
+            unary_predicate predicate_;
+        };
+        
+        
+        template<typename range, typename transform>
+        class select_range {
+        public:
+            using base_iterator = range_iterator_t<range>;
+            
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using reference         = decltype(std::declval<const transform&>()(*std::declval<base_iterator>()));
+                using value_type        = std::decay_t<reference>;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = void;
+                
+                iterator() = default;
+                iterator(const select_range* parent, base_iterator it)
+                    : parent_(parent), it_(it) {}
+                
+                reference operator*() const { return parent_->trans_(*it_); }
+                iterator& operator++() { ++it_; return *this; }
+                iterator operator++(int) { auto tmp = *this; ++it_; return tmp; }
+                
+                bool operator==(const iterator& other) const { return it_ == other.it_; }
+                bool operator!=(const iterator& other) const { return it_ != other.it_; }
+                
+            private:
+                const select_range* parent_ = nullptr;
+                base_iterator it_;
+            };
+            
+            select_range(range base, transform trans)
+                : base_(std::move(base)), trans_(std::move(trans)) {}
+            
+            iterator begin() const { return iterator(this, base_.begin()); }
+            iterator end() const { return iterator(this, base_.end()); }
+            
+        private:
+            range base_;
+            transform trans_;
+        };
+        
+        
+        /*
+            Walks the collection selected for each element in turn. Collections returned by value are kept alive by the
+            iterator that selected them (and its copies); collections returned by reference are not copied.
+         */
+        template<typename range, typename collection_selector, typename result_selector>
+        class select_many_range {
+        public:
+            using base_iterator = range_iterator_t<range>;
+            
+            class iterator {
+                using collection_result = decltype(select_collection(std::declval<collection_selector&>(),
+                                                                     *std::declval<base_iterator>(),
+                                                                     size_t()));
+                using collection_type   = std::remove_reference_t<collection_result>;
+                using holder_type       = std::conditional_t<std::is_lvalue_reference_v<collection_result>,
+                                                             collection_type*,
+                                                             std::shared_ptr<collection_type>>;
+                using inner_iterator    = decltype(std::begin(std::declval<collection_type&>()));
+                
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using reference         = decltype(std::declval<const result_selector&>()(*std::declval<base_iterator>(),
+                                                                                           *std::declval<inner_iterator>()));
+                using value_type        = std::decay_t<reference>;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = void;
+                
+                iterator() = default;
+                iterator(const select_many_range* parent, base_iterator it)
+                    : parent_(parent), it_(it) { settle(); }
+                
+                reference operator*() const { return parent_->result_(*it_, *inner_); }
+                
+                iterator& operator++() {
+                    if (++inner_ == std::end(*collection_)) {
+                        ++it_;
+                        ++index_;
+                        settle();
+                    }
+                    return *this;
+                }
+                
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const {
+                    return it_ == other.it_ and (it_ == parent_->base_.end() or inner_ == other.inner_);
+                }
+                bool operator!=(const iterator& other) const { return not (*this == other); }
+                
+            private:
+                /* moves to the first element of the next non-empty collection */
+                void settle() {
+                    for (const auto last = parent_->base_.end(); it_ != last; ++it_, ++index_) {
+                        if constexpr (std::is_lvalue_reference_v<collection_result>)
+                            collection_ = &select_collection(parent_->collections_, *it_, index_);
+                        else
+                            collection_ = std::make_shared<collection_type>(select_collection(parent_->collections_, *it_, index_));
+                        inner_ = std::begin(*collection_);
+                        if (inner_ != std::end(*collection_))
+                            return;
+                    }
+                }
+                
+                const select_many_range* parent_ = nullptr;
+                base_iterator it_;
+                size_t index_ = 0;
+                holder_type collection_{};
+                inner_iterator inner_{};
+            };
+            
+            select_many_range(range base, collection_selector collections, result_selector result)
+                : base_(std::move(base)), collections_(std::move(collections)), result_(std::move(result)) {}
+            
+            iterator begin() const { return iterator(this, base_.begin()); }
+            iterator end() const { return iterator(this, base_.end()); }
+            
+        private:
+            range base_;
+            mutable collection_selector collections_;
+            result_selector result_;
+        };
+        
+        
+        template<typename range>
+        class skip_range {
+        public:
+            skip_range(range base, size_t count)
+                : base_(std::move(base)), count_(count) {}
+            
+            auto begin() const { return advance_within(base_.begin(), base_.end(), count_); }
+            auto end() const { return base_.end(); }
+            
+        private:
+            range base_;
+            size_t count_;
+        };
+        
+        
+        template<typename range, typename unary_predicate>
+        class skip_while_range {
+        public:
+            skip_while_range(range base, unary_predicate predicate)
+                : base_(std::move(base)), predicate_(std::move(predicate)) {}
+            
+            auto begin() const {
+                auto it = base_.begin();
+                const auto last = base_.end();
+                while (it != last and predicate_(*it))
+                    ++it;
+                return it;
+            }
+            auto end() const { return base_.end(); }
+            
+        private:
+            range base_;
+            unary_predicate predicate_;
+        };
+        
+        
+        template<typename range>
+        class take_range {
+        public:
+            using base_iterator = range_iterator_t<range>;
+            
+            /* Iterators of one range are ordered by the number of elements left, which also marks the end. */
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = typename std::iterator_traits<base_iterator>::value_type;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = typename std::iterator_traits<base_iterator>::reference;
+                using pointer           = typename std::iterator_traits<base_iterator>::pointer;
+                
+                iterator() = default;
+                iterator(const take_range* parent, base_iterator it, size_t left)
+                    : parent_(parent), it_(it), left_(left) { satisfy(); }
+                
+                reference operator*() const { return *it_; }
+                iterator& operator++() {
+                    /* do not advance past the last taken element: the base stage may be expensive to step */
+                    if (--left_ != 0) {
+                        ++it_;
+                        satisfy();
+                    }
+                    return *this;
+                }
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const { return left_ == other.left_; }
+                bool operator!=(const iterator& other) const { return left_ != other.left_; }
+                
+            private:
+                void satisfy() {
+                    if (left_ != 0 and it_ == parent_->base_.end())
+                        left_ = 0;
+                }
+                
+                const take_range* parent_ = nullptr;
+                base_iterator it_;
+                size_t left_ = 0;
+            };
+            
+            take_range(range base, size_t count)
+                : base_(std::move(base)), count_(count) {}
+            
+            iterator begin() const { return iterator(this, base_.begin(), count_); }
+            iterator end() const { return iterator(this, base_.end(), 0); }
+            
+        private:
+            range base_;
+            size_t count_;
+        };
+        
+        
+        template<typename range, typename unary_predicate>
+        class take_while_range {
+        public:
+            using base_iterator = range_iterator_t<range>;
+            
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = typename std::iterator_traits<base_iterator>::value_type;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = typename std::iterator_traits<base_iterator>::reference;
+                using pointer           = typename std::iterator_traits<base_iterator>::pointer;
+                
+                iterator() = default;
+                iterator(const take_while_range* parent, base_iterator it)
+                    : parent_(parent), it_(it) { satisfy(); }
+                
+                reference operator*() const { return *it_; }
+                iterator& operator++() { ++it_; satisfy(); return *this; }
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const {
+                    return done_ == other.done_ and (done_ or it_ == other.it_);
+                }
+                bool operator!=(const iterator& other) const { return not (*this == other); }
+                
+            private:
+                void satisfy() {
+                    done_ = it_ == parent_->base_.end() or not parent_->predicate_(*it_);
+                }
+                
+                const take_while_range* parent_ = nullptr;
+                base_iterator it_;
+                bool done_ = true;
+            };
+            
+            take_while_range(range base, unary_predicate predicate)
+                : base_(std::move(base)), predicate_(std::move(predicate)) {}
+            
+            iterator begin() const { return iterator(this, base_.begin()); }
+            iterator end() const { return iterator(this, base_.end()); }
+            
+        private:
+            range base_;
+            unary_predicate predicate_;
+        };
+        
+        
+        template<typename first_range, typename second_range>
+        class concat_range {
+        public:
+            using first_iterator  = range_iterator_t<first_range>;
+            using second_iterator = range_iterator_t<second_range>;
+            
+            class iterator {
+                using first_reference  = typename std::iterator_traits<first_iterator>::reference;
+                using second_reference = typename std::iterator_traits<second_iterator>::reference;
+                
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = typename std::iterator_traits<first_iterator>::value_type;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = std::conditional_t<std::is_same_v<first_reference, second_reference>,
+                                                             first_reference,
+                                                             value_type>;
+                using pointer           = void;
+                
+                iterator() = default;
+                iterator(const concat_range* parent, first_iterator first, second_iterator second)
+                    : parent_(parent), first_(first), second_(second) {}
+                
+                reference operator*() const {
+                    if (first_ != parent_->first_.end())
+                        return *first_;
+                    return *second_;
+                }
+                iterator& operator++() {
+                    if (first_ != parent_->first_.end())
+                        ++first_;
+                    else
+                        ++second_;
+                    return *this;
+                }
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const { return first_ == other.first_ and second_ == other.second_; }
+                bool operator!=(const iterator& other) const { return not (*this == other); }
+                
+            private:
+                const concat_range* parent_ = nullptr;
+                first_iterator first_;
+                second_iterator second_;
+            };
+            
+            concat_range(first_range first, second_range second)
+                : first_(std::move(first)), second_(std::move(second)) {}
+            
+            iterator begin() const { return iterator(this, first_.begin(), second_.begin()); }
+            iterator end() const { return iterator(this, first_.end(), second_.end()); }
+            
+        private:
+            first_range first_;
+            second_range second_;
+        };
+        
+        
+        /* The empty ordering every OrderBy chain starts from. */
+        struct no_order {
+            template<typename T>
+            int compare(const T&, const T&) const { return 0; }
+        };
+        
+        
+        /*
+            One level of a lexicographic ordering. compare() is three-way, so a chain of k keys costs at most one
+            comparison per level, and the levels after the first are only evaluated on ties.
+         */
+        template<typename previous, typename key_selector, typename key_compare, bool descending>
+        class order_level {
+        public:
+            order_level(previous prev, key_selector key, key_compare compare)
+                : previous_(std::move(prev)), key_(std::move(key)), compare_(std::move(compare)) {}
+            
+            template<typename T>
+            int compare(const T& l, const T& r) const {
+                if (const int c = previous_.compare(l, r))
+                    return c;
+                
+                const auto& lk = key_(l);
+                const auto& rk = key_(r);
+                if (compare_(lk, rk))
+                    return descending ? 1 : -1;
+                if (compare_(rk, lk))
+                    return descending ? -1 : 1;
+                return 0;
+            }
+            
+        private:
+            previous previous_;
+            key_selector key_;
+            key_compare compare_;
+        };
+        
+        
+        /*
+            Materializes and sorts the base stage on first use; every copy of the range shares the sorted buffer, which is
+            filled once even when several threads iterate the range or its copies at the same time.
+            With a limit only the first `limit` elements are kept, through a bounded heap filled in a single pass.
+         */
+        template<typename range, typename order>
+        class sorted_range {
+        public:
+            using value_type = typename std::iterator_traits<range_iterator_t<range>>::value_type;
+            
+            sorted_range(range base, order ord, bool stable, size_t limit = std::numeric_limits<size_t>::max(),
+                         std::optional<parallel_policy> parallel = std::nullopt)
+                : base_(std::move(base)), order_(std::move(ord)), stable_(stable), limit_(limit), parallel_(parallel),
+                  cache_(std::make_shared<cache>()) {}
+            
+            auto begin() const { return items().begin(); }
+            auto end() const { return items().end(); }
+            
+            const range& base() const { return base_; }
+            const order& ordering() const { return order_; }
+            bool stable() const { return stable_; }
+            size_t limit() const { return limit_; }
+            const std::optional<parallel_policy>& parallel() const { return parallel_; }
+            
+        private:
+            struct cache {
+                std::once_flag once;
+                std::vector<value_type> items;
+            };
+            
+            const std::vector<value_type>& items() const {
+                std::call_once(cache_->once, [this] { cache_->items = sorted(); });
+                return cache_->items;
+            }
+            
+            std::vector<value_type> sorted() const {
+                if (limit_ != std::numeric_limits<size_t>::max())
+                    return top();
+                
+                std::vector<value_type> values(base_.begin(), base_.end());
+                auto less = [this](const value_type& l, const value_type& r) { return order_.compare(l, r) < 0; };
+                if (not parallel_ or not parallel_sort(*parallel_, values.begin(), values.size(), less, stable_)) {
+                    if (stable_)
+                        std::stable_sort(values.begin(), values.end(), less);
+                    else
+                        std::sort(values.begin(), values.end(), less);
+                }
+                return values;
+            }
+            
+            /* Ties are broken by position, so the result is the prefix of the stable order either way. */
+            std::vector<value_type> top() const {
+                using entry = std::pair<value_type, size_t>;
+                std::vector<value_type> result;
+                if (limit_ == 0)
+                    return result;
+                
+                auto less = [this](const entry& l, const entry& r) {
+                    const int c = order_.compare(l.first, r.first);
+                    return c < 0 or (c == 0 and l.second < r.second);
+                };
+                bounded_heap<entry, decltype(less)> heap(limit_, less);
+                size_t index = 0;
+                for (auto&& value : base_) {
+                    const entry* worst = heap.worst();
+                    if (worst == nullptr or order_.compare(value, worst->first) < 0)
+                        heap.push(entry(value, index));
+                    ++index;
+                }
+                
+                auto kept = std::move(heap).sorted();
+                result.reserve(kept.size());
+                for (auto& e : kept)
+                    result.push_back(std::move(e.first));
+                return result;
+            }
+            
+            range base_;
+            order order_;
+            bool stable_;
+            size_t limit_;
+            std::optional<parallel_policy> parallel_;
+            std::shared_ptr<cache> cache_;
+        };
+        
+    }
+    
+    
+    template<typename range, typename order>
+    class ordered_query;
+    
+    
+    template<typename range>
+    class query {
+    public:
+        using iterator   = detail::range_iterator_t<range>;
+        using value_type = typename std::iterator_traits<iterator>::value_type;
+        
+        explicit query(range r)
+            : range_(std::move(r)) {}
+        
+        iterator begin() const { return range_.begin(); }
+        iterator end() const { return range_.end(); }
+        
+        
+        /*
+            Filters a sequence of values based on a predicate.
+         */
+        template<typename unary_predicate>
+        auto Where(unary_predicate&& predicate) const {
+            return make_query<detail::where_range<range, std::decay_t<unary_predicate>>>(
+                        std::forward<unary_predicate>(predicate));
+        }
+        
+        
+        /*
+            Projects each element of a sequence into a new form.
+         */
+        template<typename transform>
+        auto Select(transform&& trans) const {
+            return make_query<detail::select_range<range, std::decay_t<transform>>>(
+                        std::forward<transform>(trans));
+        }
+        
+        
+        /*
+            Projects each element of a sequence to a collection and flattens the collections, without materializing the
+            flattened sequence. The selector may also take the index of the element as its second argument.
+         */
+        template<typename collection_selector>
+        auto SelectMany(collection_selector&& collections) const {
+            return SelectMany(std::forward<collection_selector>(collections), detail::inner_element());
+        }
+        
+        
+        /*
+            Projects each element of a sequence to a collection, flattens the collections and invokes a result selector
+            function on each element and the inner element it was projected to.
+         */
+        template<typename collection_selector, typename result_selector>
+        auto SelectMany(collection_selector&& collections, result_selector&& result_of) const {
+            return make_query<detail::select_many_range<range,
+                                                        std::decay_t<collection_selector>,
+                                                        std::decay_t<result_selector>>>(
+                        std::forward<collection_selector>(collections),
+                        std::forward<result_selector>(result_of));
+        }
+        
+        
+        /*
+            Bypasses a specified number of elements in a sequence and then returns the remaining elements.
+         */
+        auto Skip(size_t count) const {
+            return make_query<detail::skip_range<range>>(count);
+        }
+        
+        
+        /*
+            Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements.
+         */
+        template<typename unary_predicate>
+        auto SkipWhile(unary_predicate&& predicate) const {
+            return make_query<detail::skip_while_range<range, std::decay_t<unary_predicate>>>(
+                        std::forward<unary_predicate>(predicate));
+        }
+        
+        
+        /*
+            Returns a specified number of contiguous elements from the start of a sequence.
+         */
+        auto Take(size_t count) const {
+            return make_query<detail::take_range<range>>(count);
+        }
+        
+        
+        /*
+            Returns at most limit elements starting at offset; the offset is skipped in constant time on random-access
+            sources.
+         */
+        auto Page(size_t offset, size_t limit) const {
+            return Skip(offset).Take(limit);
+        }
+        
+        
+        /*
+            Returns elements from a sequence as long as a specified condition is true.
+         */
+        template<typename unary_predicate>
+        auto TakeWhile(unary_predicate&& predicate) const {
+            return make_query<detail::take_while_range<range, std::decay_t<unary_predicate>>>(
+                        std::forward<unary_predicate>(predicate));
+        }
+        
+        
+        /*
+            Concatenates two sequences. The second sequence is referenced, not copied.
+         */
+        template<typename container>
+        auto Concat(const container& second) const {
+            using second_range = detail::iterator_range<decltype(std::begin(second))>;
+            return make_query<detail::concat_range<range, second_range>>(
+                        second_range(std::begin(second), std::end(second)));
+        }
+        
+        
+        /*
+            Sorts the elements of a sequence in ascending order according to a key.
+            Further keys are added with ThenBy / ThenByDescending; the sequence is sorted once, when it is first read.
+         */
+        template<typename key_selector>
+        auto OrderBy(key_selector&& key_func) const {
+            return order_by<false>(std::forward<key_selector>(key_func), std::less<>());
+        }
+        
+        
+        /*
+            Sorts the elements of a sequence in ascending order by using a specified comparer.
+         */
+        template<typename key_selector, typename comparer>
+        auto OrderBy(key_selector&& key_func, comparer&& compare) const {
+            return order_by<false>(std::forward<key_selector>(key_func), std::forward<comparer>(compare));
+        }
+        
+        
+        /*
+            Sorts the elements of a sequence in descending order according to a key.
+         */
+        template<typename key_selector>
+        auto OrderByDescending(key_selector&& key_func) const {
+            return order_by<true>(std::forward<key_selector>(key_func), std::less<>());
+        }
+        
+        
+        /*
+            Sorts the elements of a sequence in descending order by using a specified comparer.
+         */
+        template<typename key_selector, typename comparer>
+        auto OrderByDescending(key_selector&& key_func, comparer&& compare) const {
+            return order_by<true>(std::forward<key_selector>(key_func), std::forward<comparer>(compare));
+        }
+        
+        
+        /*
+            Determines whether all elements of a sequence satisfy a condition.
+         */
+        template<typename unary_predicate>
+        bool All(unary_predicate&& condition) const {
+            for (auto&& value : *this) {
+                if (not condition(value))
+                    return false;
+            }
+            return true;
+        }
+        
+        
+        /*
+            Determines whether a sequence contains any elements.
+         */
+        bool Any() const {
+            return begin() != end();
+        }
+        
+        
+        /*
+            Determines whether any element of a sequence satisfies a condition.
+         */
+        template<typename unary_predicate>
+        bool Any(unary_predicate&& condition) const {
+            for (auto&& value : *this) {
+                if (condition(value))
+                    return true;
+            }
+            return false;
+        }
+        
+        
+        /*
+            Determines whether a sequence contains a specified element by using the default equality comparer.
+         */
+        template<typename T>
+        bool Contains(const T& value) const {
+            for (auto&& v : *this) {
+                if (v == value)
+                    return true;
+            }
+            return false;
+        }
+        
+        
+        /*
+            Returns the number of elements in a sequence.
+         */
+        size_t Count() const {
+            size_t count = 0;
+            for (auto it = begin(), last = end(); it != last; ++it)
+                ++count;
+            return count;
+        }
+        
+        
+        /*
+            Returns a number that represents how many elements in the specified sequence satisfy a condition.
+         */
+        template<typename unary_predicate>
+        size_t Count(unary_predicate&& condition) const {
+            size_t count = 0;
+            for (auto&& value : *this) {
+                if (condition(value))
+                    ++count;
+            }
+            return count;
+        }
+        
+        
+        /*
+            Returns the number of elements of every key as (key, count) pairs ordered by the first occurrence of the key.
+            Only one counter per key is kept, so the sequence can be far larger than memory. Keys must own their data
+            when the source is single-pass.
+         */
+        template<typename key_selector>
+        auto CountBy(key_selector&& key_func) const {
+            return simlinq::CountBy(*this, key_func);
+        }
+        
+        
+        /*
+            Applies an accumulator function over the elements of every key, starting from seed, in a single pass over the
+            sequence: a streaming GroupBy followed by Aggregate that keeps one accumulator per key.
+         */
+        template<typename key_selector, typename seed_type, typename accumulator>
+        auto AggregateBy(key_selector&& key_func, const seed_type& seed, accumulator&& acc) const {
+            return simlinq::AggregateBy(*this, key_func, seed, acc);
+        }
+        
+        
+        /*
+            Returns the first element of a sequence.
+         */
+        std::optional<value_type> First() const {
+            auto it = begin();
+            return it == end()
+                ? std::optional<value_type>()
+                : std::optional<value_type>(*it);
+        }
+        
+        
+        /*
+            Returns the first element in a sequence that satisfies a specified condition.
+         */
+        template<typename unary_predicate>
+        std::optional<value_type> First(unary_predicate&& condition) const {
+            for (auto&& value : *this) {
+                if (condition(value))
+                    return std::optional<value_type>(value);
+            }
+            return std::optional<value_type>();
+        }
+        
+        
+        /*
+            Returns the first element of a sequence, or a default value if the sequence contains no elements.
+         */
+        value_type FirstOrDefault() const {
+            auto it = begin();
+            return it == end()
+                ? value_type()
+                : value_type(*it);
+        }
+        
+        
+        /*
+            Returns the maximum value in a sequence.
+         */
+        std::optional<value_type> Max() const {
+            auto it = begin();
+            const auto last = end();
+            if (it == last)
+                return std::optional<value_type>();
+            
+            value_type max_value = *it;
+            for (++it; it != last; ++it) {
+                value_type value = *it;
+                if (max_value < value)
+                    max_value = std::move(value);
+            }
+            return std::optional<value_type>(std::move(max_value));
+        }
+        
+        
+        /*
+            Returns the minimum value in a sequence.
+         */
+        std::optional<value_type> Min() const {
+            auto it = begin();
+            const auto last = end();
+            if (it == last)
+                return std::optional<value_type>();
+            
+            value_type min_value = *it;
+            for (++it; it != last; ++it) {
+                value_type value = *it;
+                if (value < min_value)
+                    min_value = std::move(value);
+            }
+            return std::optional<value_type>(std::move(min_value));
+        }
+        
+        
+        /*
+            Computes the sum of a sequence.
+         */
+        value_type Sum() const {
+            value_type result{};
+            for (auto&& value : *this)
+                result += value;
+            return result;
+        }
+        
+        
+        /*
+            Computes the sum of the sequence of values that are obtained by invoking a transform function on each element of the input sequence.
+         */
+        template<typename transform>
+        auto Sum(transform&& trans) const {
+            std::decay_t<decltype(trans(*begin()))> result{};
+            for (auto&& value : *this)
+                result += trans(value);
+            return result;
+        }
+        
+        
+        /*
+            Materializes the query into a container of the requested type.
+         */
+        template<typename container>
+        container To() const {
+            if constexpr (detail::has_allocator<container>::value) {
+                return To<container>(typename container::allocator_type());
+            } else {
+                container result;
+                std::copy(begin(), end(), std::inserter(result, std::end(result)));
+                return result;
+            }
+        }
+        
+        
+        /*
+            Materializes the query into a container of the requested type allocated with the specified allocator.
+         */
+        template<typename container>
+        container To(const typename container::allocator_type& alloc) const {
+            container result(alloc);
+            std::copy(begin(), end(), std::inserter(result, std::end(result)));
+            return result;
+        }
+        
+        
+        /*
+            Materializes the query into a std::vector.
+         */
+        std::vector<value_type> ToVector() const {
+            return ToVector(std::allocator<value_type>());
+        }
+        
+        
+        /*
+            Materializes the query into a std::vector allocated with the specified allocator, e.g. one from simlinq::arena.
+         */
+        template<typename allocator>
+        auto ToVector(const allocator& alloc) const {
+            using allocator_type = detail::rebind_alloc_t<allocator, value_type>;
+            std::vector<value_type, allocator_type> result{ allocator_type(alloc) };
+            for (auto&& value : *this)
+                result.push_back(value);
+            return result;
+        }
+        
+    protected:
+        range range_;
+        
+    private:
+        template<typename stage, typename... args>
+        auto make_query(args&&... a) const {
+            return query<stage>(stage(range_, std::forward<args>(a)...));
+        }
+        
+        template<bool descending, typename key_selector, typename comparer>
+        auto order_by(key_selector&& key_func, comparer&& compare) const {
+            using order = detail::order_level<detail::no_order, std::decay_t<key_selector>, std::decay_t<comparer>, descending>;
+            return ordered_query<range, order>(range_,
+                                               order(detail::no_order(),
+                                                     std::forward<key_selector>(key_func),
+                                                     std::forward<comparer>(compare)),
+                                               false);
+        }
+    };
     
     
     /*
-        Produces the set intersection of two sequences by using the specified IEqualityComparer<T> to compare values.
+        A query sorted by one or more keys (IOrderedEnumerable). ThenBy and ThenByDescending extend the ordering
+        instead of sorting again: the keys are fused into one lexicographic comparison and the sort runs once, when the
+        query is first read. Stable() keeps elements with equal keys in their source order.
      */
-    template<typename container, typename comparator>
-    auto Intersect(const container& first, const container& second, comparator&& comp) {
-        auto prepare = [&comp](auto src) {
-            std::sort(std::begin(src), std::end(src), comp);
-            return src;
-        };
-
-        container first_c = prepare(first);
-        container second_c = prepare(second);
+    template<typename range, typename order>
+    class ordered_query : public query<detail::sorted_range<range, order>> {
+        using sorted = detail::sorted_range<range, order>;
         
-        container result;
-        std::set_intersection(std::begin(first_c), std::end(first_c),
-                              std::begin(second_c), std::end(second_c),
-                              std::back_inserter(result),
-                              comp);
-        return result;
-    }
+    public:
+        ordered_query(range base, order ord, bool stable, std::optional<parallel_policy> parallel = std::nullopt)
+            : query<sorted>(sorted(std::move(base), std::move(ord), stable, std::numeric_limits<size_t>::max(), parallel)) {}
+        
+        
+        /*
+            Performs a subsequent ordering of the elements in a sequence in ascending order according to a key.
+         */
+        template<typename key_selector>
+        auto ThenBy(key_selector&& key_func) const {
+            return then_by<false>(std::forward<key_selector>(key_func), std::less<>());
+        }
+        
+        
+        /*
+            Performs a subsequent ordering of the elements in a sequence in ascending order by using a specified comparer.
+         */
+        template<typename key_selector, typename comparer>
+        auto ThenBy(key_selector&& key_func, comparer&& compare) const {
+            return then_by<false>(std::forward<key_selector>(key_func), std::forward<comparer>(compare));
+        }
+        
+        
+        /*
+            Performs a subsequent ordering of the elements in a sequence in descending order according to a key.
+         */
+        template<typename key_selector>
+        auto ThenByDescending(key_selector&& key_func) const {
+            return then_by<true>(std::forward<key_selector>(key_func), std::less<>());
+        }
+        
+        
+        /*
+            Performs a subsequent ordering of the elements in a sequence in descending order by using a specified comparer.
+         */
+        template<typename key_selector, typename comparer>
+        auto ThenByDescending(key_selector&& key_func, comparer&& compare) const {
+            return then_by<true>(std::forward<key_selector>(key_func), std::forward<comparer>(compare));
+        }
+        
+        
+        /*
+            Requests a stable sort: elements with equal keys keep the order of the source sequence.
+         */
+        ordered_query Stable() const {
+            return ordered_query(this->range_.base(), this->range_.ordering(), true, this->range_.parallel());
+        }
+        
+        
+        /*
+            Sorts on the library thread pool with a parallel merge sort; the key selectors and comparers are then called
+            concurrently and must be thread-safe.
+         */
+        ordered_query Parallel(const parallel_policy& p = par) const {
+            return ordered_query(this->range_.base(), this->range_.ordering(), this->range_.stable(), p);
+        }
+        
+        
+        /*
+            Returns the first count elements of the sorted sequence. The base is read once and only count elements are
+            kept, so the sort costs O(n log count) and the query can stream over inputs larger than memory.
+         */
+        auto Take(size_t count) const {
+            return query<sorted>(sorted(this->range_.base(), this->range_.ordering(), this->range_.stable(), count));
+        }
+        
+    private:
+        template<bool descending, typename key_selector, typename comparer>
+        auto then_by(key_selector&& key_func, comparer&& compare) const {
+            using next = detail::order_level<order, std::decay_t<key_selector>, std::decay_t<comparer>, descending>;
+            return ordered_query<range, next>(this->range_.base(),
+                                              next(this->range_.ordering(),
+                                                   std::forward<key_selector>(key_func),
+                                                   std::forward<comparer>(compare)),
+                                              this->range_.stable(),
+                                              this->range_.parallel());
+        }
+    };
+    
     
-//Join<TOuter,TInner,TKey,TResult>(IEnumerable<TOuter>, IEnumerable<TInner>, Func<TOuter,TKey>, Func<TInner,TKey>, Func<TOuter,TInner,TResult>)
-//Correlates the elements of two sequences based on matching keys. The default equality comparer is used to compare keys.
-//Join<TOuter,TInner,TKey,TResult>(IEnumerable<TOuter>, IEnumerable<TInner>, Func<TOuter,TKey>, Func<TInner,TKey>, Func<TOuter,TInner,TResult>, IEqualityComparer<TKey>)
-//Correlates the elements of two sequences based on matching keys. A specified IEqualityComparer<T> is used to compare keys.
-
-    /*
-        Returns the last element of a sequence.
-    */
-    template <typename container>
-    auto Last(const container &src) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        return std::begin(src) == std::end(src)
-            ? optional_type()
-            : optional_type(src.back());
-    }
-
-
     /*
-        Returns the last element of a sequence that satisfies a specified condition.
-    */
-    template<typename container, typename unary_predicate>
-    auto Last(const container& c, unary_predicate&& cond) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        auto res = std::find_if(std::rbegin(c),
-                                std::rend(c),
-                                cond);
-        return res == std::rend(c)
-                ? optional_type()
-                : optional_type(*res);
-    }
-
-
-    /* 
-        Returns the last element of a sequence, or a default value if the sequence contains no elements.
-    */
+        Starts a lazy query over a sequence. The sequence is referenced and must outlive the query.
+     */
     template<typename container>
-    auto LastOrDefault(const container& c) {
-        return std::begin(c) == std::end(c)
-            ? typename container::value_type()
-            : typename container::value_type(c.back());
-    }
-
-
-    /*
-        Returns the last element of a sequence that satisfies a condition or a default value if no such element is found.
-    */
-    template<typename container, typename condition>
-    auto LastOrDefault(const container& c, condition&& cond) {
-        auto res = std::find_if(std::rbegin(c),
-                                std::rend(c),
-                                cond);
-        return res == std::rend(c)
-                ? typename container::value_type()
-                : *res;
+    auto from(const container& src) {
+        using range = detail::iterator_range<decltype(std::begin(src))>;
+        return query<range>(range(std::begin(src), std::end(src)));
     }
-
-
+    
+    
     /*
-        Returns an Int64 that represents the total number of elements in a sequence.
+        Starts a lazy query over a temporary sequence. The query takes ownership of the sequence.
      */
-    template <typename container>
-    long long LongCount(const container &src) {
-        return static_cast<long long>( std::size(src) );
+    template<typename container,
+             typename = std::enable_if_t<not std::is_lvalue_reference_v<container>>>
+    auto from(container&& src) {
+        using range = detail::owning_range<std::decay_t<container>>;
+        return query<range>(range(std::move(src)));
     }
-
+    
+    
     /*
-        Returns an Int64 that represents how many elements in a sequence satisfy a condition.
+        Starts a lazy query over an iterator pair.
      */
-    template <typename container, typename unary_predicate>
-    long long LongCount(const container &src, unary_predicate &&condition) {
-        return static_cast<long long>(std::count_if(std::begin(src),
-                                                    std::end(src),
-                                                    condition));
-    }
-
-        
-    /*
-        Returns the maximum value in a sequence.
-    */
-    template <typename container>
-    auto Max(const container &src) {
-        using optional_type = std::optional<typename container::value_type>;
-        
-        return std::begin(src) == std::end(src)
-            ? optional_type()
-            : optional_type(*(std::max_element(std::begin(src), std::end(src))));
+    template<typename iterator>
+    auto from(iterator first, iterator last) {
+        using range = detail::iterator_range<iterator>;
+        return query<range>(range(first, last));
     }
     
     
-    /*
-        Invokes a transform function on each element of a generic sequence and returns the maximum resulting value.
-    */
-    template<typename container, typename transform>
-    auto Max(const container& c, transform&& trans) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        if (std::begin(c) == std::end(c)) {
-            return optional_type();
-        }
+    namespace detail {
         
-        auto max_value = trans(*std::begin(c));
-        for (const auto& value : c) {
-            max_value = std::max(trans(value), max_value);
-        } 
-        return optional_type(max_value);
-    }
-    
-
-    /*
-        Returns the minimum value in a sequence.
-    */
-    template<typename container>
-    auto Min(const container& c) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        return std::begin(c) == std::end(c)
-            ? optional_type()
-            : optional_type(*(std::min_element(std::begin(c), std::end(c))));
-    }
-
-
-    /*
-        Invokes a transform function on each element of a generic sequence and returns the minimum resulting value.
-    */
-    template<typename container, typename transform>
-    auto Min(const container& c, transform&& trans) {
-        using optional_type = std::optional<typename container::value_type>;
-
-        if (std::begin(c) == std::end(c))
-            return optional_type();
+        inline size_t popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_popcountll(word));
+#else
+            size_t count = 0;
+            for (; word != 0; word &= word - 1)
+                ++count;
+            return count;
+#endif
+        }
         
-        auto min_value = trans(*std::begin(c));
-        for (const auto& value : c) {
-            min_value = std::min(trans(value), min_value);
-        } 
-        return optional_type(min_value);
-    }
-
-    
-    /*
-        Filters the elements of an IEnumerable based on a specified type.
-     */
-    template<typename required_type, typename container>
-    auto OfType(const container& src) {
-        container result;
+        /* index of the lowest set bit of a non-zero word */
+        inline size_t lowest_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(word));
+#else
+            size_t index = 0;
+            for (; (word & 1) == 0; word >>= 1)
+                ++index;
+            return index;
+#endif
+        }
         
-    std::copy_if(std::begin(src),
-                 std::end(src),
-                 std::back_inserter(result),
-                 [](auto& v) { return dynamic_cast<required_type>(v) != nullptr; }
-                 );
-        return result;
     }
     
     
     /*
-        Sorts the elements of a sequence in ascending order according to a key.
+        A bitmap over a random-access sequence that marks the elements still selected. Each Where evaluates its predicate
+        over blocks of 64 elements without branching and ANDs the result into the bitmap, skipping blocks with nothing
+        left; the elements themselves are only read again by the final consumer. Predicates must be free of side effects,
+        since they also see the elements of a block that an earlier filter already rejected.
      */
-    template<typename container, typename predicate>
-    auto OrderBy(const container& src, predicate&& key_func) {
-        container result(std::begin(src), std::end(src));
+    template<typename container>
+    class selection {
+        using source_iterator = decltype(std::begin(std::declval<const container&>()));
+        
+        static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                        typename std::iterator_traits<source_iterator>::iterator_category>,
+                      "selections need a random-access sequence");
+        
+    public:
+        using value_type = typename std::iterator_traits<source_iterator>::value_type;
+        
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = typename selection::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = typename std::iterator_traits<source_iterator>::pointer;
+            using reference         = typename std::iterator_traits<source_iterator>::reference;
+            
+            iterator() = default;
+            iterator(const selection* parent, size_t index)
+                : parent_(parent), index_(index) {}
+            
+            reference operator*() const { return std::begin(*parent_->src_)[index_]; }
+            
+            iterator& operator++() { index_ = parent_->next(index_ + 1); return *this; }
+            iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+            
+            bool operator==(const iterator& other) const { return index_ == other.index_; }
+            bool operator!=(const iterator& other) const { return index_ != other.index_; }
+            
+        private:
+            const selection* parent_ = nullptr;
+            size_t index_ = 0;
+        };
+        
+        /* Selects every element of the sequence. */
+        explicit selection(const container& src)
+            : src_(&src), size_(static_cast<size_t>(std::distance(std::begin(src), std::end(src)))),
+              words_((size_ + 63) / 64, ~uint64_t(0)) {
+            if (size_ % 64 != 0)
+                words_.back() = (uint64_t(1) << (size_ % 64)) - 1;
+        }
+        
+        iterator begin() const { return iterator(this, next(0)); }
+        iterator end() const { return iterator(this, size_); }
+        
+        
+        /*
+            Keeps the selected elements that satisfy a predicate.
+         */
+        template<typename unary_predicate>
+        selection Where(unary_predicate&& predicate) const& {
+            return selection(*this).Where(predicate);
+        }
+        
+        template<typename unary_predicate>
+        selection Where(unary_predicate&& predicate) && {
+            const auto first = std::begin(*src_);
+            for (size_t w = 0; w < words_.size(); ++w) {
+                if (words_[w] == 0)
+                    continue;
+                
+                const size_t base = w * 64;
+                const size_t count = std::min<size_t>(64, size_ - base);
+                uint64_t passed = 0;
+                for (size_t i = 0; i < count; ++i)
+                    passed |= uint64_t(static_cast<bool>(predicate(first[base + i]))) << i;
+                words_[w] &= passed;
+            }
+            return std::move(*this);
+        }
+        
+        
+        /*
+            Returns the number of selected elements.
+         */
+        size_t Count() const {
+            size_t count = 0;
+            for (auto word : words_)
+                count += detail::popcount(word);
+            return count;
+        }
+        
+        
+        /*
+            Determines whether any element is selected.
+         */
+        bool Any() const {
+            return std::any_of(words_.begin(), words_.end(), [](uint64_t word) { return word != 0; });
+        }
+        
+        
+        /*
+            Returns the positions of the selected elements in the sequence.
+         */
+        std::vector<size_t> Indices() const {
+            std::vector<size_t> result;
+            result.reserve(Count());
+            for_each_index([&result](size_t index) { result.push_back(index); });
+            return result;
+        }
+        
+        
+        /*
+            Copies the selected elements into a std::vector.
+         */
+        std::vector<value_type> ToVector() const {
+            return ToVector(std::allocator<value_type>());
+        }
         
-        auto comparer = [&key_func]
-                        (const auto& l, const auto& r)
-                        { return key_func(l) < key_func(r); };
-        std::sort(std::begin(result),
-                  std::end(result),
-                  comparer);
         
-        return result;
-    }
+        /*
+            Copies the selected elements into a std::vector allocated with the specified allocator.
+         */
+        template<typename allocator>
+        auto ToVector(const allocator& alloc) const {
+            using allocator_type = detail::rebind_alloc_t<allocator, value_type>;
+            std::vector<value_type, allocator_type> result{ allocator_type(alloc) };
+            result.reserve(Count());
+            const auto first = std::begin(*src_);
+            for_each_index([&result, &first](size_t index) { result.push_back(first[index]); });
+            return result;
+        }
+        
+    private:
+        /* position of the first selected element at or after `from`, or size_ */
+        size_t next(size_t from) const {
+            size_t w = from / 64;
+            if (w >= words_.size())
+                return size_;
+            
+            uint64_t word = words_[w] & (~uint64_t(0) << (from % 64));
+            while (word == 0) {
+                if (++w == words_.size())
+                    return size_;
+                word = words_[w];
+            }
+            return w * 64 + detail::lowest_bit(word);
+        }
+        
+        template<typename function>
+        void for_each_index(function&& f) const {
+            for (size_t w = 0; w < words_.size(); ++w)
+                for (uint64_t word = words_[w]; word != 0; word &= word - 1)
+                    f(w * 64 + detail::lowest_bit(word));
+        }
+        
+        const container* src_;
+        size_t size_;
+        std::vector<uint64_t> words_;
+    };
     
     
     /*
-        Sorts the elements of a sequence in ascending order by using a specified comparer.
+        Starts a selection over a random-access sequence, with every element selected. The sequence is referenced and
+        must outlive the selection.
      */
-    template<typename container, typename predicate, typename comparer>
-    auto OrderBy(const container& src, predicate&& key_func, comparer&& compare) {
-        container result(std::begin(src), std::end(src));
-        
-        auto final_comparer = [&key_func, &compare]
-        (const auto& lhv, const auto& rhv)
-        { return compare(key_func(lhv),key_func(rhv)); };
-        std::sort(std::begin(result),
-                  std::end(result),
-                  final_comparer);
-        
-        return result;
+    template<typename container>
+    selection<container> mask(const container& src) {
+        return selection<container>(src);
     }
     
+    template<typename container,
+             typename = std::enable_if_t<not std::is_lvalue_reference_v<container>>>
+    void mask(container&& src) = delete;
+    
     
     /*
-        Sorts the elements of a sequence in descending order according to a key.
+        Views.
+        
+        Non-owning slices of a sequence, made in constant time (SkipWhile and TakeWhile only scan up to the first element
+        that fails the condition). Views of a contiguous sequence are pointer ranges and keep the contiguous fast paths of
+        the aggregate operators. A view must not outlive its sequence; use from(view) to query it and
+        from(view).ToVector() (or To<container>()) when ownership is needed.
      */
-    template<typename container, typename predicate>
-    auto OrderByDescending(const container& src, predicate&& key_func) {
-        container result(std::begin(src), std::end(src));
+    template<typename iterator>
+    class view {
+    public:
+        using value_type     = typename std::iterator_traits<iterator>::value_type;
+        using const_iterator = iterator;
+        using size_type      = size_t;
         
-        auto comparer = [&key_func]
-                        (const auto& l, const auto& r)
-                        { return key_func(l) > key_func(r); };
-        std::sort(std::begin(result),
-                  std::end(result),
-                  comparer);
+        view() = default;
+        view(iterator first, iterator last)
+            : first_(first), last_(last) {}
         
-        return result;
-    }
-
+        iterator begin() const { return first_; }
+        iterator end() const { return last_; }
+        
+        bool empty() const { return first_ == last_; }
+        size_t size() const { return static_cast<size_t>(std::distance(first_, last_)); }
+        
+        decltype(auto) front() const { return *first_; }
+        decltype(auto) back() const { return *std::prev(last_); }
+        decltype(auto) operator[](size_t index) const { return first_[static_cast<std::ptrdiff_t>(index)]; }
+        
+        template<typename pointer = iterator, typename = std::enable_if_t<std::is_pointer_v<pointer>>>
+        pointer data() const { return first_; }
+        
+    private:
+        iterator first_{};
+        iterator last_{};
+    };
     
-    /*
-        Sorts the elements of a sequence in descending order by using a specified comparer.
-     */
-    template<typename container, typename predicate, typename comparer>
-    auto OrderByDescending(const container& src, predicate&& key_func, comparer&& compare) {
-        container result(std::begin(src), std::end(src));
+    
+    namespace detail {
         
-        auto final_comparer = [&key_func, &compare]
-        (const auto& lhv, const auto& rhv)
-        { return not compare(key_func(lhv),key_func(rhv)); };
-        std::sort(std::begin(result),
-                  std::end(result),
-                  final_comparer);
+        /* Selects the overloads that refuse temporaries a view would dangle on; views themselves are fine. */
+        template<typename container>
+        using enable_for_owning_rvalue = std::enable_if_t<not std::is_lvalue_reference_v<container> and
+                                                          not is_view<std::decay_t<container>>::value>;
+        
+        /* the bounds of a sequence as pointers when it is contiguous, as its own iterators otherwise */
+        template<typename container>
+        auto view_bounds(const container& src) {
+            if constexpr (is_contiguous_v<container>)
+                return std::make_pair(std::data(src), std::data(src) + std::size(src));
+            else
+                return std::make_pair(std::begin(src), std::end(src));
+        }
         
-        return result;
     }
-
+    
     
     /*
-        Adds a value to the beginning of the sequence.
-    */
-    template<typename container>
-    void Prepend(const container& src, typename container::value_type&& value) {
-        src.insert(std::begin(src),
-                   value);
-    }
-
-
-    /*
-        Inverts the order of the elements in a sequence.
-    */
+        Bypasses a specified number of elements in a sequence and returns a view of the remaining elements.
+     */
     template<typename container>
-    void Reverse(container& src) {
-        std::reverse( std::begin(src), std::end(src) );
+    auto SkipView(const container& src, size_t count) {
+        const auto bounds = detail::view_bounds(src);
+        return view(detail::advance_within(bounds.first, bounds.second, count), bounds.second);
     }
-
-//SelectMany<TSource,TCollection,TResult>(IEnumerable<TSource>, Func<TSource,IEnumerable<TCollection>>, Func<TSource,TCollection,TResult>)
-//Projects each element of a sequence to an IEnumerable<T>, flattens the resulting sequences into one sequence, and invokes a result selector function on each element therein.
-//SelectMany<TSource,TCollection,TResult>(IEnumerable<TSource>, Func<TSource,Int32,IEnumerable<TCollection>>, Func<TSource,TCollection,TResult>)
-//Projects each element of a sequence to an IEnumerable<T>, flattens the resulting sequences into one sequence, and invokes a result selector function on each element therein. The index of each source element is used in the intermediate projected form of that element.
-//SelectMany<TSource,TResult>(IEnumerable<TSource>, Func<TSource,IEnumerable<TResult>>)
-//Projects each element of a sequence to an IEnumerable<T> and flattens the resulting sequences into one sequence.
-//SelectMany<TSource,TResult>(IEnumerable<TSource>, Func<TSource,Int32,IEnumerable<TResult>>)
-//Projects each element of a sequence to an IEnumerable<T>, and flattens the resulting sequences into one sequence. The index of each source element is used in the projected form of that element.
     
     
     /*
-        Returns the only element of a sequence, and throws an exception if there is not exactly one element in the sequence.
+        Returns a view of a specified number of elements from the start of a sequence.
      */
     template<typename container>
-    auto Single(const container& src) {
-        using optional_type = std::optional<typename container::value_type>;
-        
-        return std::size(src) == 1
-            ? optional_type(src.front())
-            : optional_type();
+    auto TakeView(const container& src, size_t count) {
+        const auto bounds = detail::view_bounds(src);
+        return view(bounds.first, detail::advance_within(bounds.first, bounds.second, count));
     }
     
-
-    /*
-        Returns the only element of a sequence that satisfies a specified condition, and throws an exception if more than one such element exists.
-     */
-    template<typename container, typename unary_predicate>
-    auto Single(const container& src, unary_predicate&& condition) {
-        using optional_type = std::optional<typename container::value_type>;
-        
-        return std::count_if(std::begin(src), std::end(src), condition) == 1
-            ? optional_type(*std::find_if(std::begin(src), std::end(src), condition))
-            : optional_type();
-        
-    }
-
     
     /*
-        Returns the only element of a sequence, or a default value if the sequence is empty; this method throws an exception if there is more than one element in the sequence.
-    */
+        Returns a view of a sequence without its last count elements.
+     */
     template<typename container>
-    auto SingleOrDefault(const container& src) {
-        return std::size(src) == 1
-        ? src.front()
-        : typename container::value_type();
+    auto SkipLastView(const container& src, size_t count) {
+        const auto bounds = detail::view_bounds(src);
+        const size_t size = detail::size_of(src);
+        return view(bounds.first, detail::advance_within(bounds.first, bounds.second, size - std::min(count, size)));
     }
     
     
     /*
-        Returns the only element of a sequence that satisfies a specified condition or a default value if no such element exists; this method throws an exception if more than one element satisfies the condition.
-    */
-    template<typename container, typename unary_predicate>
-    auto SingleOrDefault(const container& src, unary_predicate&& condition) {
-        return std::count_if(std::begin(src), std::end(src), condition) == 1
-            ? *std::find_if(std::begin(src), std::end(src), condition)
-            : typename container::value_type();
-        
+        Returns a view of the last count elements of a sequence.
+     */
+    template<typename container>
+    auto TakeLastView(const container& src, size_t count) {
+        const auto bounds = detail::view_bounds(src);
+        const size_t size = detail::size_of(src);
+        return view(detail::advance_within(bounds.first, bounds.second, size - std::min(count, size)), bounds.second);
     }
     
-
+    
     /*
-        Bypasses a specified number of elements in a sequence and then returns the remaining elements.
+        Returns a view of at most limit elements of a sequence, starting at offset.
      */
     template<typename container>
-    auto Skip(const container& src, size_t count) {
-        return (count <= std::size(src))
-            ? container(std::begin(src) + count, std::end(src))
-            : container();
+    auto PageView(const container& src, size_t offset, size_t limit) {
+        const auto bounds = detail::view_bounds(src);
+        const auto first = detail::advance_within(bounds.first, bounds.second, offset);
+        return view(first, detail::advance_within(first, bounds.second, limit));
     }
-
-
+    
+    
     /*
-        Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements.
+        Bypasses elements in a sequence as long as a specified condition is true and returns a view of the remaining
+        elements.
      */
     template<typename container, typename unary_predicate>
-    auto SkipWhile(const container& src, unary_predicate&& predicate) {
-        return container(std::find_if_not(std::begin(src), std::end(src), predicate),
-                         std::end(src));
+    auto SkipWhileView(const container& src, unary_predicate&& predicate) {
+        const auto bounds = detail::view_bounds(src);
+        return view(std::find_if_not(bounds.first, bounds.second, predicate), bounds.second);
     }
     
-
+    
     /*
-        Bypasses elements in a sequence as long as a specified condition is true and then returns the remaining elements. The element's index is used in the logic of the predicate function.
+        Returns a view of the elements of a sequence as long as a specified condition is true.
      */
-    template<typename index_t, typename container, typename binary_predicate>
-    auto SkipWhile(const container& src, binary_predicate&& predicate) {
-        auto f = std::begin(src);
-        for (index_t ind = 0; ind < std::size(src); ++ind, f++) {
-            if (not predicate(ind, *f)) {
-                break;
-            }
-        };
-        return container(f, std::end(src));
+    template<typename container, typename unary_predicate>
+    auto TakeWhileView(const container& src, unary_predicate&& predicate) {
+        const auto bounds = detail::view_bounds(src);
+        return view(bounds.first, std::find_if_not(bounds.first, bounds.second, predicate));
     }
     
     
     /*
-        Computes the sum of a sequence.
-    */
+        Returns a view of a sequence in reverse order; the sequence itself is not modified.
+     */
     template<typename container>
-    auto Sum(const container& c) {
-        return std::accumulate(std::begin(c), 
-                               std::end(c),
-                               typename container::value_type());
-        
-    }
-
-
-    /*
-        Computes the sum of the sequence of Decimal values that are obtained by invoking a transform function on each element of the input sequence.
-    */
-    template<typename container, typename transform>        
-    auto Sum(const container& c, transform&& trans) {
-        return std::accumulate(std::begin(c),
-                               std::end(c),
-                               typename container::value_type(),
-                               trans);
+    auto ReverseView(const container& src) {
+        const auto bounds = detail::view_bounds(src);
+        using reverse = std::reverse_iterator<decltype(bounds.first)>;
+        return view(reverse(bounds.second), reverse(bounds.first));
     }
-
+    
+    
+    /* Views of temporaries would dangle. */
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void SkipView(container&& src, size_t count) = delete;
+    
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void TakeView(container&& src, size_t count) = delete;
+    
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void SkipLastView(container&& src, size_t count) = delete;
+    
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void TakeLastView(container&& src, size_t count) = delete;
+    
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void PageView(container&& src, size_t offset, size_t limit) = delete;
+    
+    template<typename container, typename unary_predicate, typename = detail::enable_for_owning_rvalue<container>>
+    void SkipWhileView(container&& src, unary_predicate&& predicate) = delete;
+    
+    template<typename container, typename unary_predicate, typename = detail::enable_for_owning_rvalue<container>>
+    void TakeWhileView(container&& src, unary_predicate&& predicate) = delete;
+    
+    template<typename container, typename = detail::enable_for_owning_rvalue<container>>
+    void ReverseView(container&& src) = delete;
+    
     
     /*
-        Returns elements from a sequence as long as a specified condition is true.
+        Columnar storage.
+        
+        columns<&record::a, &record::b, ...> keeps every listed member of a record type in a vector of its own. A query
+        that reads one or two members then streams only those columns instead of whole records. field<&record::m> and
+        on<&record::m>(predicate) are projections that work on records and on columns alike: the aggregate and filter
+        operators below run them directly over the column vector, and inside from() pipelines they read a single column
+        per row.
      */
-    template<typename container, typename condition>
-    auto TakeWhile(const container& src, condition&& cond) {
-        auto it = std::begin(src);
-        while (it != std::end(src) and cond(*it))
-            it++;
+    
+    
+    namespace detail {
+        
+        template<typename member_pointer>
+        struct member_pointer_traits;
+        
+        template<typename record_type, typename member_type>
+        struct member_pointer_traits<member_type record_type::*> {
+            using record = record_type;
+            using type   = member_type;
+        };
+        
+        template<auto l, auto r>
+        constexpr bool same_member() {
+            if constexpr (std::is_same_v<decltype(l), decltype(r)>)
+                return l == r;
+            else
+                return false;
+        }
+        
+        /* position of `member` in `members`, or sizeof...(members) if it is not there */
+        template<auto member, auto... members>
+        constexpr size_t member_index() {
+            const bool matches[] = { same_member<member, members>()... };
+            for (size_t i = 0; i < sizeof...(members); ++i)
+                if (matches[i])
+                    return i;
+            return sizeof...(members);
+        }
         
-        return container(std::begin(src), it);
     }
     
     
     /*
-        Returns elements from a sequence as long as a specified condition is true. The element's index is used in the logic of the predicate function.
+        Projects a record, or a row of columns, onto one of its data members.
      */
-    template<typename index_t, typename container, typename condition>
-    auto TakeWhile(const container& src, condition&& cond) {
-        auto it = std::begin(src);
-        index_t index = 0;
-        while (it != std::end(src) and cond(index, *it)) {
-            it++;
-            index++;
-        }
+    template<auto member>
+    struct field {
+        using record = typename detail::member_pointer_traits<decltype(member)>::record;
+        using type   = typename detail::member_pointer_traits<decltype(member)>::type;
         
-        return container(std::begin(src), it);
-    }
+        const type& operator()(const record& r) const { return r.*member; }
+        
+        template<typename row, typename = decltype(std::declval<const row&>().template get<member>())>
+        const type& operator()(const row& r) const { return r.template get<member>(); }
+    };
     
-//ThenBy<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>)
-//Performs a subsequent ordering of the elements in a sequence in ascending order according to a key.
-//ThenBy<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>, IComparer<TKey>)
-//Performs a subsequent ordering of the elements in a sequence in ascending order by using a specified comparer.
-//ThenByDescending<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>)
-//Performs a subsequent ordering of the elements in a sequence in descending order, according to a key.
-//ThenByDescending<TSource,TKey>(IOrderedEnumerable<TSource>, Func<TSource,TKey>, IComparer<TKey>)
-//Performs a subsequent ordering of the elements in a sequence in descending order by using a specified comparer.
-//ToArray<TSource>(IEnumerable<TSource>)
-//Creates an array from a IEnumerable<T>.
-//ToDictionary<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>)
-//Creates a Dictionary<TKey,TValue> from an IEnumerable<T> according to specified key selector and element selector functions.
-//ToDictionary<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>, IEqualityComparer<TKey>)
-//Creates a Dictionary<TKey,TValue> from an IEnumerable<T> according to a specified key selector function, a comparer, and an element selector function.
-//ToDictionary<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>)
-//Creates a Dictionary<TKey,TValue> from an IEnumerable<T> according to a specified key selector function.
-//ToDictionary<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>, IEqualityComparer<TKey>)
-//Creates a Dictionary<TKey,TValue> from an IEnumerable<T> according to a specified key selector function and key comparer.
-//ToHashSet<TSource>(IEnumerable<TSource>)
-//Creates a HashSet<T> from an IEnumerable<T>.
-//ToHashSet<TSource>(IEnumerable<TSource>, IEqualityComparer<TSource>)
-//Creates a HashSet<T> from an IEnumerable<T> using the comparer to compare keys.
-//ToList<TSource>(IEnumerable<TSource>)
-//Creates a List<T> from an IEnumerable<T>.
-//ToLookup<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>)
-//Creates a Lookup<TKey,TElement> from an IEnumerable<T> according to specified key selector and element selector functions.
-//ToLookup<TSource,TKey,TElement>(IEnumerable<TSource>, Func<TSource,TKey>, Func<TSource,TElement>, IEqualityComparer<TKey>)
-//Creates a Lookup<TKey,TElement> from an IEnumerable<T> according to a specified key selector function, a comparer and an element selector function.
-//ToLookup<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>)
-//Creates a Lookup<TKey,TElement> from an IEnumerable<T> according to a specified key selector function.
-//ToLookup<TSource,TKey>(IEnumerable<TSource>, Func<TSource,TKey>, IEqualityComparer<TKey>)
-//Creates a Lookup<TKey,TElement> from an IEnumerable<T> according to a specified key selector function and key comparer.
-
-    /*
-        Produces the set union of two sequences by using the default equality comparer.
-    */
-    template<typename container>
-    auto Union(const container& first, const container& second) {
-        std::unordered_set<typename container::value_type> result(std::begin(first), std::end(first));
-
-        std::copy(std::begin(second), 
-                  std::end(second),
-                  std::inserter(result, std::end(result))
-                  );
-        return result;
-    }
-
-
-    /*
-        Produces the set union of two sequences by using a specified IEqualityComparer<T>.
-    */
-    template<typename container, typename comparator>
-    auto Union(const container& first, const container& second, comparator&& comp) {
-        using value_type = typename container::value_type;
-        std::unordered_set<value_type, std::hash<value_type>, decltype(comp)> result(std::begin(first), std::end(second));
-
-        std::copy(std::begin(second), 
-                  std::end(second),
-                  std::inserter(result, std::end(result))
-                  );
-        return result;
+    
+    namespace detail {
+        
+        template<auto member, typename predicate>
+        struct field_predicate {
+            predicate test;
+            
+            template<typename value_type>
+            bool operator()(const value_type& value) const { return test(field<member>()(value)); }
+        };
+        
     }
-
-
+    
+    
     /*
-        Filters a sequence of values based on a predicate.
-    */
-    template<typename container, typename unary_predicate>
-    auto Where(const container& src, unary_predicate&& predicate) {
-        container result;
-
-        std::copy_if(std::begin(src),
-                     std::end(src),
-                     std::back_inserter(result),
-                     predicate);
-        return result;
+        A predicate on one data member: on<&order::price>([](double p) { return p > 100; }).
+     */
+    template<auto member, typename predicate>
+    auto on(predicate&& test) {
+        return detail::field_predicate<member, std::decay_t<predicate>>{ std::forward<predicate>(test) };
     }
-
-
-    /*
-        Filters a sequence of values based on a predicate. Each element's index is used in the logic of the predicate function.
-    */
-//    template<typename container, typename binary_predicate>
-//    auto Where(const container& src, binary_predicate&& predicate) {
-//        container result;
-//        size_t index = 0;
-//        for (const auto& value : src) {
-//            if (predicate(index, value)) {
-//                result.push_back(value);
-//            }
-//            index ++;
-//        }
-//
-//        return result;
-//    }
-
-
-
+    
+    
     /*
-        Applies a specified function to the corresponding elements of two sequences, producing a sequence of the results.
+        A sequence of records stored as one vector per listed member. Members that are not listed are not stored: the
+        records read back from the container have them value-initialized.
      */
-    template<typename first_container,
-             typename second_container,
-             typename binary_predicate>
-    auto Zip(const first_container& first, const second_container& second, binary_predicate&& predicate) {
-        /*
-            TODO: Further investigations required
-         */
-        std::vector<std::string> result;
+    template<auto... members>
+    class columns {
+        static_assert(sizeof...(members) > 0, "columns need at least one member");
+        
+        using first_field = field<std::get<0>(std::make_tuple(members...))>;
+        
+        static_assert((std::is_same_v<typename field<members>::record, typename first_field::record> and ...),
+                      "all columns must be members of the same record type");
+        
+        template<auto member>
+        static constexpr size_t index_of = detail::member_index<member, members...>();
+        
+    public:
+        using record     = typename first_field::record;
+        using value_type = record;
+        
+        static_assert(std::is_default_constructible_v<record>, "records are rebuilt from their columns");
+        
+        /* A row of the container; converts to the record, or reads single members with get(). */
+        class row {
+        public:
+            row(const columns* parent, size_t index)
+                : parent_(parent), index_(index) {}
+            
+            template<auto member>
+            const typename field<member>::type& get() const { return parent_->template column<member>()[index_]; }
+            
+            operator record() const {
+                record result{};
+                ((result.*members = get<members>()), ...);
+                return result;
+            }
+            
+        private:
+            const columns* parent_;
+            size_t index_;
+        };
         
-        auto count = std::min(std::size(first), std::size(second));
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = record;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = row;
+            
+            iterator() = default;
+            iterator(const columns* parent, size_t index)
+                : parent_(parent), index_(index) {}
+            
+            row operator*() const { return row(parent_, index_); }
+            row operator[](difference_type n) const { return row(parent_, index_ + n); }
+            
+            iterator& operator++() { ++index_; return *this; }
+            iterator operator++(int) { auto tmp = *this; ++index_; return tmp; }
+            iterator& operator--() { --index_; return *this; }
+            iterator operator--(int) { auto tmp = *this; --index_; return tmp; }
+            
+            iterator& operator+=(difference_type n) { index_ += n; return *this; }
+            iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+            iterator operator+(difference_type n) const { return iterator(parent_, index_ + n); }
+            iterator operator-(difference_type n) const { return iterator(parent_, index_ - n); }
+            difference_type operator-(const iterator& other) const {
+                return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+            }
+            
+            bool operator==(const iterator& other) const { return index_ == other.index_; }
+            bool operator!=(const iterator& other) const { return index_ != other.index_; }
+            bool operator<(const iterator& other) const { return index_ < other.index_; }
+            bool operator>(const iterator& other) const { return index_ > other.index_; }
+            bool operator<=(const iterator& other) const { return index_ <= other.index_; }
+            bool operator>=(const iterator& other) const { return index_ >= other.index_; }
+            
+        private:
+            const columns* parent_ = nullptr;
+            size_t index_ = 0;
+        };
         
-        auto fit = std::begin(first);
-        auto sit = std::begin(second);
-        for (;
-             fit < std::begin(first) + count;
-             ++fit, ++sit) {
-            result.push_back( predicate(*fit, *sit));
+        using const_iterator = iterator;
+        
+        columns() = default;
+        
+        columns(std::initializer_list<record> records) {
+            reserve(records.size());
+            for (const auto& r : records)
+                push_back(r);
         }
         
-        return result;
-    }
-
+        template<typename input_iterator>
+        columns(input_iterator first, input_iterator last) {
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                            typename std::iterator_traits<input_iterator>::iterator_category>)
+                reserve(static_cast<size_t>(std::distance(first, last)));
+            for (; first != last; ++first)
+                push_back(*first);
+        }
+        
+        size_t size() const { return std::get<0>(columns_).size(); }
+        bool empty() const { return size() == 0; }
+        
+        void reserve(size_t count) { (std::get<index_of<members>>(columns_).reserve(count), ...); }
+        void clear() { (std::get<index_of<members>>(columns_).clear(), ...); }
+        
+        void push_back(const record& r) { (std::get<index_of<members>>(columns_).push_back(r.*members), ...); }
+        
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size()); }
+        
+        row operator[](size_t index) const { return row(this, index); }
+        row front() const { return row(this, 0); }
+        row back() const { return row(this, size() - 1); }
+        
+        /* The values of one member, in row order. */
+        template<auto member>
+        const std::vector<typename field<member>::type>& column() const {
+            static_assert(index_of<member> < sizeof...(members), "the member is not stored in these columns");
+            return std::get<index_of<member>>(columns_);
+        }
+        
+        /* The rows at the given indices, copied column by column. */
+        columns gather(const std::vector<size_t>& rows) const {
+            columns result;
+            (gather_column<members>(rows, std::get<index_of<members>>(result.columns_)), ...);
+            return result;
+        }
+        
+        bool operator==(const columns& other) const { return columns_ == other.columns_; }
+        bool operator!=(const columns& other) const { return columns_ != other.columns_; }
+        
+    private:
+        template<auto member, typename column_type>
+        void gather_column(const std::vector<size_t>& rows, column_type& to) const {
+            const auto& from = column<member>();
+            to.reserve(rows.size());
+            for (auto row : rows)
+                to.push_back(from[row]);
+        }
+        
+        std::tuple<std::vector<typename field<members>::type>...> columns_;
+    };
+    
+    
     /*
-        Determines whether all elements of a sequence satisfy a condition.
+        Computes the sum of one member of every record.
      */
-    template <typename container, typename unary_predicate>
-    bool All(const container &src, unary_predicate &&condition) {
-        return std::all_of(std::begin(src),
-                           std::end(src),
-                           condition);
+    template<typename container, auto member, typename = detail::disable_for_policy<container>>
+    auto Sum(const container& c, field<member> f) {
+        typename field<member>::type total{};
+        for (const auto& value : c)
+            total += f(value);
+        return total;
     }
-
+    
+    
     /*
-        Determines whether a sequence contains any elements.
+        Computes the sum of one column.
      */
-    template <typename container>
-    bool Any(const container &src) {
-        return std::begin(src) != std::end(src);
-    }
-
-    /*
-        Determines whether any element of a sequence satisfies a condition.
-    */
-    template <typename container, typename unary_predicate>
-    bool Any(const container &src, unary_predicate &&condition) {
-        for (auto it = std::begin(src); it != std::end(src); ++it)
-        {
-            if (condition(*it))
-                return true;
-        }
-        return false;
+    template<auto... members, auto member>
+    auto Sum(const columns<members...>& c, field<member>) {
+        return Sum(c.template column<member>());
     }
-
+    
+    
     /*
-        Concatenates two sequences.
-    */
-    template <typename container>
-    auto Concat(const container &first, const container &second) {
-        container result(std::size(first) + std::size(second));
-
-        std::copy(std::begin(second),
-                std::end(second),
-                std::copy(std::begin(first),
-                            std::end(first),
-                            std::begin(result)));
-        return result;
+        Computes the average of one column.
+     */
+    template<auto... members, auto member>
+    auto Average(const columns<members...>& c, field<member>) {
+        using optional_type = std::optional<typename field<member>::type>;
+        
+        return c.empty()
+            ? optional_type()
+            : optional_type(Average(c.template column<member>()));
     }
-
+    
+    
     /*
-        Determines whether any element of a sequence satisfies a condition.
-    */
-    template <typename container, typename T>
-    bool Contains(const container &src, const T &&value) {
-        return std::find(std::begin(src),
-                        std::end(src),
-                        value) != std::end(src);
+        Returns the maximum value of one column.
+     */
+    template<auto... members, auto member>
+    auto Max(const columns<members...>& c, field<member>) {
+        return Max(c.template column<member>());
     }
-
+    
+    
     /*
-        Determines whether a sequence contains a specified element by using a specified binary predicate.
-    */
-    template <typename container, typename T, typename binary_predicate>
-    bool Contains(const container &src, const T &&value, binary_predicate &&predicate) {
-        for (auto it = std::begin(src); it != std::end(src); ++it)
-        {
-            if (predicate(*it, value))
-                return true;
-        }
-
-        return false;
+        Returns the minimum value of one column.
+     */
+    template<auto... members, auto member>
+    auto Min(const columns<members...>& c, field<member>) {
+        return Min(c.template column<member>());
     }
-
+    
+    
     /*
-        Returns the number of elements in a sequence.
-    */
-    template <typename container>
-    auto Count(const container &src) {
-        return std::size(src);
+        Returns how many rows satisfy a condition on one column.
+     */
+    template<auto... members, auto member, typename predicate>
+    auto Count(const columns<members...>& c, detail::field_predicate<member, predicate> condition) {
+        const auto& column = c.template column<member>();
+        return std::count_if(column.begin(), column.end(), condition.test);
     }
-
+    
+    
     /*
-        Returns a number that represents how many elements in the specified sequence satisfy a condition.
-    */
-    template <typename container, typename unary_predicate>
-    auto Count(const container &src, unary_predicate &&condition) {
-        return std::count_if(std::begin(src),
-                            std::end(src),
-                            condition);
+        Determines whether any row satisfies a condition on one column.
+     */
+    template<auto... members, auto member, typename predicate>
+    bool Any(const columns<members...>& c, detail::field_predicate<member, predicate> condition) {
+        const auto& column = c.template column<member>();
+        return std::any_of(column.begin(), column.end(), condition.test);
     }
-
+    
+    
     /*
-        Returns an empty IEnumerable<T> that has the specified type argument.
-    */
-    template <typename T>
-    auto Empty() {
-        return T{};
+        Determines whether all rows satisfy a condition on one column.
+     */
+    template<auto... members, auto member, typename predicate>
+    bool All(const columns<members...>& c, detail::field_predicate<member, predicate> condition) {
+        const auto& column = c.template column<member>();
+        return std::all_of(column.begin(), column.end(), condition.test);
     }
-
+    
+    
     /*
-        Produces the set difference of two sequences by using the default equality comparer to compare values.
-    */
-    template <typename container>
-    auto except(const container &first, const container &second) {
-        container result;
-        std::copy_if(std::begin(first),
-                    std::end(first),
-                    std::back_inserter(result),
-                    [&second](const typename container::value_type &value) {
-                        return std::find(std::begin(second), std::end(second), value) == std::end(second);
-                    });
-        return result;
+        Filters the rows on a condition on one column. Only that column is scanned; the other columns are read only at
+        the selected rows.
+     */
+    template<auto... members, auto member, typename predicate>
+    auto Where(const columns<members...>& src, detail::field_predicate<member, predicate> condition) {
+        const auto& column = src.template column<member>();
+        
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < column.size(); ++i)
+            if (condition.test(column[i]))
+                rows.push_back(i);
+        return src.gather(rows);
     }
-
+    
+    
     /*
-        Produces the set difference of two sequences by using the specified IEqualityComparer<T> to compare values.
-    */
-    template <typename container, typename binary_predicate>
-    auto except(const container &first, const container &second, binary_predicate &&comparator) {
-        container result;
-        std::copy_if(std::begin(first),
-                    std::end(first),
-                    std::back_inserter(result),
-                    [&second, &comparator](const typename container::value_type &value) {
-                        return std::find_if(std::begin(second),
-                                            std::end(second),
-                                            [&comparator, &value](const typename container::value_type &nested_value) {
-                                                return comparator(value, nested_value);
-                                            }) == std::end(second);
-                    });
-        return result;
-    }
+        Sources.
+        
+        Sequences that are not held in a container: the records of a memory-mapped file, the lines of a text buffer or
+        stream, and the values of a generator. They can be passed to from() and to the operators that only read their
+        input. lines(std::istream&) and generate() are single-pass: every copy of them reads from the same source.
+     */
+    
     
-
     /*
-        Projects each element of a sequence into a new form by incorporating the element's index.
-    */
-    template <template <typename, typename> class ret_type, typename container, typename ind_type = uint32_t>
-    auto select(container &src) {
-        using pair = std::pair<ind_type, typename container::value_type>;
-        ret_type<pair, std::allocator<pair>> result(src.size());
-
-        for (ind_type i = 0; i < std::size(src); ++i)
-        {
-            result[i] = pair{i, src[i]};
+        Read-only memory mapping of a file seen as an array of fixed-size records. The elements are the mapped pages
+        themselves: nothing is copied or loaded up front, so memory use stays bounded by what the system keeps paged in.
+        Trailing bytes that do not fill a whole record are not part of the sequence.
+     */
+    template<typename record>
+    class mapped_file {
+        static_assert(std::is_trivially_copyable_v<record>, "mapped records must be trivially copyable");
+        
+    public:
+        using value_type     = record;
+        using const_iterator = const record*;
+        using iterator       = const_iterator;
+        
+        explicit mapped_file(const std::string& path) {
+#if defined(SIMLINQ_MMAP)
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::system_error(errno, std::generic_category(), "mapped_file: cannot open " + path);
+            
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "mapped_file: cannot stat " + path);
+            }
+            
+            bytes_ = static_cast<size_t>(info.st_size);
+            if (bytes_ != 0) {
+                void* data = ::mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED) {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "mapped_file: cannot map " + path);
+                }
+                ::madvise(data, bytes_, MADV_SEQUENTIAL);
+                data_ = data;
+            }
+            ::close(fd);
+#else
+            throw std::runtime_error("mapped_file: memory mapping is not supported on this platform: " + path);
+#endif
         }
-        return result;
-    }
-
-    /*
-        Projects each element of a sequence into a new form.
-    */
-    template <template <typename, typename> class ret_type, typename container, typename transform_func>
-    auto select(container &src, transform_func &&f) {
-        ret_type<typename container::value_type, std::allocator<typename container::value_type>> result(src);
-
-        std::transform(std::begin(src), std::end(src), result.begin(), f);
-
-        return result;
-    }
-
-    /*
-        Determines whether two sequences are equal by comparing the elements by using the default equality comparer for their type.
-    */
-    template <typename container>
-    bool SequenceEqual(const container &first, const container &second) {
-        return std::size(first) == std::size(second)
-                ? std::equal(std::begin(first), std::end(first), std::begin(second))
-                : false;
+        
+        mapped_file(mapped_file&& other) noexcept
+            : data_(std::exchange(other.data_, nullptr)), bytes_(std::exchange(other.bytes_, 0)) {}
+        
+        mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                bytes_ = std::exchange(other.bytes_, 0);
+            }
+            return *this;
+        }
+        
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        
+        ~mapped_file() { unmap(); }
+        
+        size_t size() const { return bytes_ / sizeof(record); }
+        bool empty() const { return size() == 0; }
+        
+        const record* data() const { return static_cast<const record*>(data_); }
+        iterator begin() const { return data(); }
+        iterator end() const { return data() + size(); }
+        
+        const record& operator[](size_t index) const { return data()[index]; }
+        const record& front() const { return data()[0]; }
+        const record& back() const { return data()[size() - 1]; }
+        
+        /* The mapped bytes, e.g. for lines(). */
+        std::string_view bytes() const { return std::string_view(static_cast<const char*>(data_), bytes_); }
+        
+    private:
+        void unmap() {
+#if defined(SIMLINQ_MMAP)
+            if (data_ != nullptr)
+                ::munmap(data_, bytes_);
+#endif
+            data_ = nullptr;
+            bytes_ = 0;
+        }
+        
+        void* data_ = nullptr;
+        size_t bytes_ = 0;
+    };
+    
+    
+    namespace detail {
+        
+        /* The lines of a character buffer as views into it; "\r\n" line ends are accepted. */
+        class text_lines {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = std::string_view;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const std::string_view*;
+                using reference         = std::string_view;
+                
+                iterator() = default;
+                iterator(const char* first, const char* last)
+                    : first_(first), eol_(find_eol(first, last)), last_(last) {}
+                
+                std::string_view operator*() const {
+                    size_t length = static_cast<size_t>(eol_ - first_);
+                    if (length != 0 and first_[length - 1] == '\r')
+                        --length;
+                    return std::string_view(first_, length);
+                }
+                
+                iterator& operator++() {
+                    first_ = eol_ == last_ ? last_ : eol_ + 1;
+                    eol_ = find_eol(first_, last_);
+                    return *this;
+                }
+                
+                iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+                
+                bool operator==(const iterator& other) const { return first_ == other.first_; }
+                bool operator!=(const iterator& other) const { return first_ != other.first_; }
+                
+            private:
+                static const char* find_eol(const char* first, const char* last) {
+                    const void* eol = first == last ? nullptr : std::memchr(first, '\n', static_cast<size_t>(last - first));
+                    return eol == nullptr ? last : static_cast<const char*>(eol);
+                }
+                
+                const char* first_ = nullptr;
+                const char* eol_ = nullptr;
+                const char* last_ = nullptr;
+            };
+            
+            using value_type = std::string_view;
+            
+            explicit text_lines(std::string_view text)
+                : first_(text.data()), last_(text.data() + text.size()) {}
+            
+            iterator begin() const { return iterator(first_, last_); }
+            iterator end() const { return iterator(last_, last_); }
+            
+        private:
+            const char* first_;
+            const char* last_;
+        };
+        
+        
+        /*
+            Reads a stream line by line into a single buffer shared by all iterators: the current line is only valid until
+            the iterator is advanced.
+         */
+        class stream_lines {
+            struct state {
+                explicit state(std::istream& stream) : in(&stream) {}
+                
+                std::istream* in;
+                std::string line;
+                bool done = false;
+                bool started = false;
+                
+                void next() {
+                    done = not std::getline(*in, line);
+                    if (not done and not line.empty() and line.back() == '\r')
+                        line.pop_back();
+                }
+            };
+            
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = std::string;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const std::string*;
+                using reference         = const std::string&;
+                
+                iterator() = default;
+                explicit iterator(state* s) : state_(s) {}
+                
+                const std::string& operator*() const { return state_->line; }
+                const std::string* operator->() const { return &state_->line; }
+                
+                iterator& operator++() { state_->next(); return *this; }
+                void operator++(int) { state_->next(); }
+                
+                bool operator==(const iterator& other) const { return at_end() == other.at_end(); }
+                bool operator!=(const iterator& other) const { return at_end() != other.at_end(); }
+                
+            private:
+                bool at_end() const { return state_ == nullptr or state_->done; }
+                
+                state* state_ = nullptr;
+            };
+            
+            using value_type = std::string;
+            
+            explicit stream_lines(std::istream& in)
+                : state_(std::make_shared<state>(in)) {}
+            
+            iterator begin() const {
+                if (not state_->started) {
+                    state_->started = true;
+                    state_->next();
+                }
+                return iterator(state_.get());
+            }
+            
+            iterator end() const { return iterator(); }
+            
+        private:
+            std::shared_ptr<state> state_;
+        };
+        
+        
+        /* Calls the generator until it returns an empty optional; the values are produced on demand. */
+        template<typename generator>
+        class generated_range {
+            using result_type = std::decay_t<std::invoke_result_t<generator&>>;
+            using element_type = typename result_type::value_type;
+            
+            struct state {
+                generator produce;
+                result_type current;
+                bool started = false;
+                
+                void next() { current = produce(); }
+            };
+            
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = element_type;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const element_type*;
+                using reference         = const element_type&;
+                
+                iterator() = default;
+                explicit iterator(state* s) : state_(s) {}
+                
+                const element_type& operator*() const { return *state_->current; }
+                const element_type* operator->() const { return &*state_->current; }
+                
+                iterator& operator++() { state_->next(); return *this; }
+                void operator++(int) { state_->next(); }
+                
+                bool operator==(const iterator& other) const { return at_end() == other.at_end(); }
+                bool operator!=(const iterator& other) const { return at_end() != other.at_end(); }
+                
+            private:
+                bool at_end() const { return state_ == nullptr or not state_->current; }
+                
+                state* state_ = nullptr;
+            };
+            
+            using value_type = element_type;
+            
+            explicit generated_range(generator produce)
+                : state_(std::make_shared<state>(state{ std::move(produce), result_type() })) {}
+            
+            iterator begin() const {
+                if (not state_->started) {
+                    state_->started = true;
+                    state_->next();
+                }
+                return iterator(state_.get());
+            }
+            
+            iterator end() const { return iterator(); }
+            
+        private:
+            std::shared_ptr<state> state_;
+        };
+        
     }
-
+    
+    
     /*
-        Determines whether two sequences are equal by comparing their elements by using a specified IEqualityComparer<T>
-    */
-    template <typename container, typename comparator>
-    bool SequenceEqual(const container &first, const container &second, comparator &&comp) {
-        return std::size(first) == std::size(second)
-                ? std::equal(std::begin(first), std::end(first), std::begin(second), comp)
-                : false;
+        The lines of a text buffer, without their line ends, as views into the buffer; e.g. lines(file.bytes()) over a
+        mapped_file<char> reads a text file without copying it.
+     */
+    inline detail::text_lines lines(std::string_view text) {
+        return detail::text_lines(text);
     }
-
+    
+    
     /*
-        Generates a sequence of integral numbers within a specified range.
-    */
-    template <typename container, typename T>
-    auto range(T &&value, uint32_t count) {
-        container c(count);
-        std::iota(std::begin(c), std::end(c), value);
-        return c;
+        The lines of a stream, read one at a time. The stream must outlive the sequence, which can be read only once.
+     */
+    inline detail::stream_lines lines(std::istream& in) {
+        return detail::stream_lines(in);
     }
-
+    
+    
     /*
-        Generates a sequence that contains one repeated value.
-    */
-    template <typename container, typename T>
-    container Repeat(T &&value, uint32_t count) {
-        return container(count, value);
+        The values returned by a generator callable, up to the first empty std::optional it returns. The sequence can be
+        read only once.
+     */
+    template<typename generator>
+    auto generate(generator&& produce) {
+        return detail::generated_range<std::decay_t<generator>>(std::forward<generator>(produce));
     }
 
-    /*
-        Returns a specified number of contiguous elements from the start of a sequence.
-    */
-    template <unsigned int N, typename container>
-    container Take(const container &src) {
-        if (std::begin(src) + N >= std::end(src))
-            return src;
-
-        container result(N);
-        std::copy(std::begin(src), std::begin(src) + N, std::begin(result));
-        return result;
-    }
 
 } // namespace simlinq
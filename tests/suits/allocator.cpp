@@ -0,0 +1,132 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+
+SUITE(AllocatorMethods)
+{
+    /* forwards to the heap and counts the allocations it served */
+    class counting_resource : public std::pmr::memory_resource {
+    public:
+        size_t allocations = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    bool isEven(const int& v) { return v % 2 == 0; }
+
+
+    TEST(ResultsUseSourceAllocator)
+    {
+        counting_resource resource;
+        std::pmr::vector<int> values({ 5, 3, 8, 1, 8, 4 }, &resource);
+
+        auto where = simlinq::Where(values, isEven);
+        CHECK(where == std::pmr::vector<int>({ 8, 8, 4 }));
+        CHECK(where.get_allocator().resource() == &resource);
+
+        CHECK(simlinq::Skip(values, 4).get_allocator().resource() == &resource);
+        CHECK(simlinq::TakeWhile(values, [](int v) { return v != 8; }).get_allocator().resource() == &resource);
+        CHECK(simlinq::Concat(values, values).get_allocator().resource() == &resource);
+        CHECK(simlinq::DefaultIfEmpty(values).get_allocator().resource() == &resource);
+        CHECK(simlinq::Take<2>(values).get_allocator().resource() == &resource);
+
+        auto ordered = simlinq::OrderBy(values, [](int v) { return v; });
+        CHECK(ordered == std::pmr::vector<int>({ 1, 3, 4, 5, 8, 8 }));
+        CHECK(ordered.get_allocator().resource() == &resource);
+
+        CHECK(simlinq::Intersect(values, values).get_allocator().resource() == &resource);
+        CHECK(simlinq::except(values, values).get_allocator().resource() == &resource);
+
+        const auto before = resource.allocations;
+        simlinq::Where(values, isEven);
+        CHECK(resource.allocations > before);
+    }
+
+
+    TEST(ExplicitAllocator)
+    {
+        counting_resource resource;
+        std::pmr::polymorphic_allocator<char> alloc(&resource);
+        std::vector<int> values{ 1, 2, 3 };
+
+        auto doubles = simlinq::Cast<double>(values, alloc);
+        CHECK(doubles == std::pmr::vector<double>({ 1.0, 2.0, 3.0 }));
+        CHECK(doubles.get_allocator().resource() == &resource);
+
+        auto indexed = simlinq::select<std::vector>(values, alloc);
+        CHECK_EQUAL(indexed.size(), 3u);
+        CHECK_EQUAL(indexed[2].first, 2u);
+        CHECK(indexed.get_allocator().resource() == &resource);
+
+        auto incremented = simlinq::select<std::vector>(values, [](int v) { return v + 1; }, alloc);
+        CHECK(incremented == std::pmr::vector<int>({ 2, 3, 4 }));
+        
+        auto names = simlinq::select<std::vector>(values, [](int v) { return std::to_string(v); }, alloc);
+        CHECK(names == std::pmr::vector<std::string>({ "1", "2", "3" }));
+        CHECK(names.get_allocator().resource() == &resource);
+
+        auto repeated = simlinq::Repeat<std::pmr::vector<int>>(7, 3, &resource);
+        CHECK(repeated == std::pmr::vector<int>({ 7, 7, 7 }));
+        CHECK(repeated.get_allocator().resource() == &resource);
+
+        auto numbers = simlinq::range<std::pmr::vector<int>>(1, 3, &resource);
+        CHECK(numbers == std::pmr::vector<int>({ 1, 2, 3 }));
+
+        auto even = simlinq::from(values).Where(isEven).ToVector(alloc);
+        CHECK(even == std::pmr::vector<int>({ 2 }));
+        CHECK(even.get_allocator().resource() == &resource);
+
+        auto list = simlinq::from(values).To<std::pmr::list<int>>(&resource);
+        CHECK(list == std::pmr::list<int>({ 1, 2, 3 }));
+    }
+
+
+    TEST(Arena)
+    {
+        counting_resource upstream;
+        simlinq::arena arena(1024, &upstream);
+
+        std::pmr::vector<int> values(arena.allocator<int>());
+        for (int i = 0; i < 16; ++i)
+            values.push_back(i);
+
+        auto even = simlinq::Where(values, isEven);
+        auto tail = simlinq::Skip(even, 4);
+        auto squares = simlinq::from(tail).Select([](int v) { return v * v; }).ToVector(arena.allocator());
+
+        CHECK(squares == std::pmr::vector<int>({ 64, 100, 144, 196 }));
+        CHECK(squares.get_allocator().resource() == arena.resource());
+        CHECK_EQUAL(upstream.allocations, 1u);
+    }
+
+
+    TEST(ArenaWithBuffer)
+    {
+        alignas(std::max_align_t) char buffer[512];
+        simlinq::arena arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+        std::pmr::vector<int> values({ 1, 2, 3, 4 }, arena.allocator<int>());
+        CHECK(simlinq::Where(values, isEven) == std::pmr::vector<int>({ 2, 4 }));
+
+        arena.release();
+        std::pmr::vector<int> again({ 5, 6 }, arena.allocator<int>());
+        CHECK_EQUAL(simlinq::Count(again, isEven), 1);
+    }
+}
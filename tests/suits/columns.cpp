@@ -0,0 +1,104 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <string>
+#include <vector>
+
+
+SUITE(ColumnMethods)
+{
+    struct order {
+        int id;
+        double price;
+        int quantity;
+        std::string customer;
+
+        bool operator==(const order& other) const {
+            return id == other.id and price == other.price and quantity == other.quantity and customer == other.customer;
+        }
+    };
+
+    using order_columns = simlinq::columns<&order::id, &order::price, &order::quantity, &order::customer>;
+
+    const std::vector<order> orders{
+        { 1, 10.0, 3, "ann" },
+        { 2, 25.5, 1, "bob" },
+        { 3, 4.5, 10, "ann" },
+        { 4, 100.0, 2, "eve" },
+    };
+
+    const auto price = simlinq::field<&order::price>();
+    const auto quantity = simlinq::field<&order::quantity>();
+
+
+    TEST(Storage)
+    {
+        order_columns table(orders.begin(), orders.end());
+        CHECK_EQUAL(table.size(), 4u);
+        CHECK(table.column<&order::price>() == std::vector<double>({ 10.0, 25.5, 4.5, 100.0 }));
+        CHECK(table.column<&order::customer>()[3] == "eve");
+
+        const order second = table[1];
+        CHECK(second == orders[1]);
+        CHECK_EQUAL(table.back().get<&order::id>(), 4);
+
+        CHECK(std::vector<order>(table.begin(), table.end()) == orders);
+        CHECK(table.gather({ 3, 0 }) == order_columns({ orders[3], orders[0] }));
+
+        /* members that are not stored come back value-initialized */
+        simlinq::columns<&order::id> ids(orders.begin(), orders.end());
+        const order first = ids.front();
+        CHECK_EQUAL(first.id, 1);
+        CHECK(first.customer.empty());
+    }
+
+
+    TEST(ColumnAggregates)
+    {
+        order_columns table(orders.begin(), orders.end());
+
+        CHECK_EQUAL(simlinq::Sum(table, price), 140.0);
+        CHECK_EQUAL(simlinq::Sum(table, quantity), 16);
+        CHECK_EQUAL(*simlinq::Average(table, price), 35.0);
+        CHECK_EQUAL(*simlinq::Max(table, quantity), 10);
+        CHECK_EQUAL(*simlinq::Min(table, price), 4.5);
+        CHECK(not simlinq::Average(order_columns(), price));
+
+        auto expensive = simlinq::on<&order::price>([](double p) { return p > 20; });
+        CHECK_EQUAL(simlinq::Count(table, expensive), 2);
+        CHECK(simlinq::Any(table, expensive));
+        CHECK(not simlinq::All(table, expensive));
+
+        auto selected = simlinq::Where(table, expensive);
+        CHECK(selected == order_columns({ orders[1], orders[3] }));
+    }
+
+
+    TEST(ProjectionsOnRecords)
+    {
+        /* the same selectors work on an array of records */
+        auto expensive = simlinq::on<&order::price>([](double p) { return p > 20; });
+        CHECK_EQUAL(simlinq::Sum(orders, price), 140.0);
+        CHECK_EQUAL(*simlinq::Max(orders, quantity), 10);
+        CHECK_EQUAL(simlinq::Count(orders, expensive), 2);
+        CHECK(simlinq::Where(orders, expensive) == std::vector<order>({ orders[1], orders[3] }));
+    }
+
+
+    TEST(ColumnQueries)
+    {
+        order_columns table(orders.begin(), orders.end());
+
+        auto total = simlinq::from(table)
+            .Where(simlinq::on<&order::customer>([](const std::string& c) { return c == "ann"; }))
+            .Select(quantity)
+            .Sum();
+        CHECK_EQUAL(total, 13);
+
+        auto records = simlinq::from(table).Where([](const order& o) { return o.quantity < 3; }).ToVector();
+        CHECK(records == std::vector<order>({ orders[1], orders[3] }));
+
+        CHECK_EQUAL(simlinq::Count(table, [](const order& o) { return o.id % 2 == 0; }), 2);
+        CHECK(simlinq::Where(table, [](const order& o) { return o.id > 2; }) == order_columns({ orders[2], orders[3] }));
+    }
+}
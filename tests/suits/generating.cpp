@@ -2,6 +2,11 @@
 #include <Linq.hpp>
 #include <UnitTest++/UnitTest++.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <forward_list>
+#include <list>
 #include <vector>
 #include <string>
 
@@ -52,6 +57,65 @@ SUITE(GeneratingMethods) {
     }
     
     
+    TEST(DistinctKeepsOrder)
+    {
+        const std::vector<int> values{ 5, 3, 8, 1, 8, 4, 2, 7 };
+        CHECK(simlinq::Distinct(values, std::vector<int>({ 8, 2, 9 })) == std::vector<int>({ 5, 3, 1, 8, 4, 7 }));
+        CHECK(simlinq::Intersect(values, std::vector<int>({ 8, 2, 9, 8, 5 })) == std::vector<int>({ 5, 8, 8, 2 }));
+        CHECK(simlinq::Intersect(values, std::vector<int>({ 8 })) == std::vector<int>({ 8 }));
+        
+        std::vector<std::string> words{ "pear", "fig", "apple", "fig", "kiwi" };
+        CHECK(simlinq::Distinct(words, std::vector<std::string>({ "fig", "kiwi" })) == std::vector<std::string>({ "pear", "apple", "fig" }));
+        CHECK(simlinq::Intersect(words, std::vector<std::string>({ "kiwi", "pear" })) == std::vector<std::string>({ "pear", "kiwi" }));
+    }
+    
+    
+    TEST(except)
+    {
+        std::vector<int> values;
+        std::vector<int> odd;
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(i % 10);
+            if (i % 2 == 1)
+                odd.push_back(i);
+        }
+        std::vector<int> expected;
+        for (int i = 0; i < 100; ++i)
+            if (i % 10 % 2 == 0)
+                expected.push_back(i % 10);
+        
+        CHECK(simlinq::except(values, odd) == expected);
+        CHECK(simlinq::except(values, std::vector<int>({ 1, 3, 5, 7, 9 })) == expected);
+        CHECK(simlinq::except(simlinq::OrderBy(values, [](int v) { return v; }), odd) ==
+              simlinq::OrderBy(expected, [](int v) { return v; }));
+        CHECK(simlinq::except(values, empty) == values);
+    }
+    
+    
+    TEST(DistinctSequence)
+    {
+        /* sorted input, small integral range, wide integral range */
+        CHECK(simlinq::Distinct(std::vector<int>({ 1, 1, 2, 3, 3, 3, 7 })) == std::vector<int>({ 1, 2, 3, 7 }));
+        CHECK(simlinq::Distinct(std::vector<int>({ 5, -3, 5, 8, -3, 1 })) == std::vector<int>({ 5, -3, 8, 1 }));
+        CHECK(simlinq::Distinct(std::vector<int64_t>({ INT64_MAX, 0, INT64_MIN, 0, INT64_MAX })) ==
+              std::vector<int64_t>({ INT64_MAX, 0, INT64_MIN }));
+        CHECK(simlinq::Distinct(std::vector<unsigned char>({ 255, 0, 255, 7 })) == std::vector<unsigned char>({ 255, 0, 7 }));
+        CHECK(simlinq::Distinct(empty).empty());
+        
+        /* hashed and, for keys without std::hash, sorted once */
+        CHECK(simlinq::Distinct(std::list<std::string>({ "b", "a", "b", "c", "a" })) == std::list<std::string>({ "b", "a", "c" }));
+        using point = std::pair<int, int>;
+        CHECK(simlinq::Distinct(std::vector<point>({ {2, 1}, {1, 2}, {2, 1}, {0, 0}, {1, 2} })) ==
+              std::vector<point>({ {2, 1}, {1, 2}, {0, 0} }));
+        
+        auto values = std::vector<int>({ 4, 4, 9, 1, 9 });
+        const auto storage = values.data();
+        auto unique = simlinq::Distinct(std::move(values));
+        CHECK(unique == std::vector<int>({ 4, 9, 1 }));
+        CHECK(unique.data() == storage);
+    }
+    
+    
     TEST(DistinctComparer)
     {
         CHECK(simlinq::Distinct(first,
@@ -81,6 +145,198 @@ SUITE(GeneratingMethods) {
         CHECK(simlinq::Intersect(first, second, [](int f, int s){ return f*2 < s; }) == std::vector<int>({2, 3, 4}));
     }
     
+    /* Join required data */
+    struct Customer {
+        int id;
+        std::string name;
+    };
+    
+    struct Order {
+        int customer;
+        int amount;
+    };
+    
+    std::vector<Customer> customers{ {1, "Ann"}, {2, "Bob"}, {3, "Eve"} };
+    std::vector<Order> orders{ {2, 10}, {1, 20}, {2, 30}, {4, 40}, {1, 50}, {2, 60}, {5, 70} };
+    
+    
+    TEST(Join)
+    {
+        auto result_sel = [](const Customer& c, const Order& o) { return c.name + ":" + std::to_string(o.amount); };
+        auto customer_key = [](const Customer& c) { return c.id; };
+        auto order_key = [](const Order& o) { return o.customer; };
+        
+        std::vector<std::string> expected{ "Ann:20", "Ann:50", "Bob:10", "Bob:30", "Bob:60" };
+        
+        /* the index is built over the smaller input, the order of the result must not depend on it */
+        CHECK(simlinq::Join(customers, orders, customer_key, order_key, result_sel) == expected);
+        
+        std::vector<Order> few_orders{ {2, 10}, {1, 20} };
+        CHECK(simlinq::Join(customers, few_orders, customer_key, order_key, result_sel)
+              == std::vector<std::string>({ "Ann:20", "Bob:10" }));
+        
+        CHECK(simlinq::Join(customers, std::vector<Order>(), customer_key, order_key, result_sel).empty());
+    }
+    
+    
+    TEST(JoinComparer)
+    {
+        std::vector<std::string> keys{ "one", "TWO" };
+        std::vector<std::string> values{ "One", "two", "three" };
+        
+        auto lower = [](std::string s) {
+            std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+            return s;
+        };
+        auto hash = [&lower](const std::string& s) { return std::hash<std::string>()(lower(s)); };
+        auto equal = [&lower](const std::string& l, const std::string& r) { return lower(l) == lower(r); };
+        auto identity = [](const std::string& s) { return s; };
+        auto concat = [](const std::string& l, const std::string& r) { return l + r; };
+        
+        CHECK(simlinq::Join(keys, values, identity, identity, concat, hash, equal)
+              == std::vector<std::string>({ "oneOne", "TWOtwo" }));
+        CHECK(simlinq::Join(keys, values, identity, identity, concat, std::equal_to<std::string>()).empty());
+    }
+    
+    
+    TEST(GroupJoin)
+    {
+        auto customer_key = [](const Customer& c) { return c.id; };
+        auto order_key = [](const Order& o) { return o.customer; };
+        auto total = [](const Customer& c, const auto& group) {
+            int sum = 0;
+            for (const auto& o : group)
+                sum += o.amount;
+            return std::make_pair(c.name, sum);
+        };
+        
+        using result_t = std::vector<std::pair<std::string, int>>;
+        result_t expected{ {"Ann", 70}, {"Bob", 100}, {"Eve", 0} };
+        
+        CHECK(simlinq::GroupJoin(customers, orders, customer_key, order_key, total) == expected);
+        CHECK(simlinq::GroupJoin(customers, std::vector<Order>{ {3, 5} }, customer_key, order_key, total)
+              == result_t({ {"Ann", 0}, {"Bob", 0}, {"Eve", 5} }));
+    }
+    
+    
+    TEST(GroupBy)
+    {
+        std::vector<int> data{ 1, 12, 3, 24, 15, 6, 27 };
+        auto last_digit_parity = [](int v) { return v % 2; };
+        
+        auto groups = simlinq::GroupBy(data, last_digit_parity);
+        REQUIRE CHECK_EQUAL(groups.size(), 2);
+        
+        CHECK_EQUAL(groups.front().Key(), 1);
+        CHECK(std::vector<int>(groups.front().begin(), groups.front().end()) == std::vector<int>({1, 3, 15, 27}));
+        CHECK_EQUAL((*(groups.begin() + 1)).Key(), 0);
+        CHECK(std::vector<int>(groups[0].begin(), groups[0].end()) == std::vector<int>({12, 24, 6}));
+        CHECK(groups.contains(1));
+        CHECK(not groups.contains(2));
+        CHECK(groups[2].empty());
+        
+        CHECK(simlinq::GroupBy(empty, last_digit_parity).empty());
+    }
+    
+    
+    TEST(GroupByBoolKey)
+    {
+        std::vector<int> data{ 1, 12, 3, 24, 15, 6, 27 };
+        auto is_even = [](int v) { return v % 2 == 0; };
+        
+        auto groups = simlinq::GroupBy(data, is_even);
+        REQUIRE CHECK_EQUAL(groups.size(), 2);
+        CHECK_EQUAL(groups.front().Key(), false);
+        CHECK(std::vector<int>(groups[true].begin(), groups[true].end()) == std::vector<int>({12, 24, 6}));
+        
+        auto lookup = simlinq::ToLookup(data, is_even);
+        CHECK_EQUAL(lookup[false].size(), 4);
+        CHECK(lookup.contains(true) and lookup.contains(false));
+        
+        using count_t = std::vector<std::pair<bool, size_t>>;
+        CHECK(simlinq::CountBy(data, is_even) == count_t({ {false, 4}, {true, 3} }));
+    }
+    
+    
+    TEST(GroupByElement)
+    {
+        auto groups = simlinq::GroupBy(orders,
+                                       [](const Order& o) { return o.customer; },
+                                       [](const Order& o) { return o.amount; });
+        REQUIRE CHECK_EQUAL(groups.size(), 4);
+        CHECK(std::vector<int>(groups[2].begin(), groups[2].end()) == std::vector<int>({10, 30, 60}));
+        CHECK(groups.elements() == std::vector<int>({10, 30, 60, 20, 50, 40, 70}));
+    }
+    
+    
+    TEST(GroupByResult)
+    {
+        using result_t = std::vector<std::pair<int, int>>;
+        auto key = [](const Order& o) { return o.customer; };
+        
+        auto totals = simlinq::GroupBy(orders, key, [](int customer, const auto& group) {
+            int sum = 0;
+            for (const auto& o : group)
+                sum += o.amount;
+            return std::make_pair(customer, sum);
+        });
+        CHECK(totals == result_t({ {2, 100}, {1, 70}, {4, 40}, {5, 70} }));
+        
+        auto counts = simlinq::GroupBy(orders, key,
+                                       [](const Order& o) { return o.amount; },
+                                       [](int customer, const auto& amounts) {
+                                           return std::make_pair(customer, simlinq::Sum(amounts));
+                                       });
+        CHECK(counts == totals);
+    }
+    
+    
+    TEST(GroupByComparer)
+    {
+        std::vector<std::string> words{ "Apple", "avocado", "Banana", "blueberry", "cherry" };
+        auto first_letter = [](const std::string& s) { return s.substr(0, 1); };
+        auto comparer = simlinq::equality_comparer{
+            [](const std::string& s) { return std::hash<int>()(std::tolower(s[0])); },
+            [](const std::string& l, const std::string& r) { return std::tolower(l[0]) == std::tolower(r[0]); }
+        };
+        
+        auto groups = simlinq::GroupBy(words, first_letter, comparer);
+        REQUIRE CHECK_EQUAL(groups.size(), 3);
+        CHECK_EQUAL(groups.front().Key(), "A");
+        CHECK_EQUAL(groups.front().size(), 2);
+        
+        auto sizes = simlinq::GroupBy(words, first_letter,
+                                      [](const std::string& k, const auto& g) { return k + std::to_string(g.size()); },
+                                      comparer);
+        CHECK(sizes == std::vector<std::string>({ "A2", "B2", "c1" }));
+    }
+    
+    
+    TEST(AggregateSeed)
+    {
+        auto add = [](const Order& o, int& sum) { sum += o.amount; };
+        CHECK_EQUAL(simlinq::Aggregate(orders, 0, add), 280);
+        CHECK_EQUAL(simlinq::Aggregate(orders, 0, add, [](int sum) { return sum / 10; }), 28);
+        
+        const std::string seed = ">";
+        auto joined = simlinq::Aggregate(orders, seed, [](const Order& o, std::string& text) { text += std::to_string(o.customer); });
+        CHECK_EQUAL(joined, ">2124125");
+        CHECK_EQUAL(simlinq::Aggregate(empty, 7, [](int, int& state) { ++state; }), 7);
+    }
+    
+    
+    TEST(AggregateBy)
+    {
+        using result_t = std::vector<std::pair<int, int>>;
+        auto key = [](const Order& o) { return o.customer; };
+        
+        CHECK(simlinq::AggregateBy(orders, key, 0, [](const Order& o, int& sum) { sum += o.amount; })
+              == result_t({ {2, 100}, {1, 70}, {4, 40}, {5, 70} }));
+        using count_t = std::vector<std::pair<int, size_t>>;
+        CHECK(simlinq::CountBy(orders, key) == count_t({ {2, 3}, {1, 2}, {4, 1}, {5, 1} }));
+    }
+    
+    
     TEST(OfType)
     {
         struct A { virtual void do_smth() {}; virtual ~A() = default; };
@@ -159,6 +415,149 @@ SUITE(GeneratingMethods) {
         CHECK_EQUAL(compare_collections(simlinq::OrderByDescending(data, key, compare), expected), true);
     }
     
+    TEST(OrderByCachedKeys)
+    {
+        S_collection data{ {"C", 10}, {"A", 15 }, {"B", 20 }, {"A", 5 }, {"C", 1 } };
+        
+        /* string keys are computed once per element; equal keys keep their original order */
+        size_t calls = 0;
+        auto key = [&calls](const S& s) { ++calls; return s.name; };
+        
+        S_collection expected{ {"A", 15 }, {"A", 5 }, {"B", 20 }, {"C", 10}, {"C", 1 } };
+        CHECK_EQUAL(compare_collections(simlinq::OrderBy(data, key), expected), true);
+        CHECK_EQUAL(calls, data.size());
+        
+        S_collection descending{ {"C", 10}, {"C", 1 }, {"B", 20 }, {"A", 15 }, {"A", 5 } };
+        CHECK_EQUAL(compare_collections(simlinq::OrderByDescending(S_collection(data), key), descending), true);
+        
+        std::deque<S> queue(data.begin(), data.end());
+        auto ordered = simlinq::OrderBy(queue, key);
+        CHECK_EQUAL(ordered.front().age, 15);
+        CHECK_EQUAL(ordered.back().age, 1);
+        
+        /* a reference to a member is compared in place instead of being copied, unless caching is asked for */
+        size_t lookups = 0;
+        auto name = [&lookups](const S& s) -> const std::string& { ++lookups; return s.name; };
+        auto by_name = simlinq::OrderBy(data, name);
+        CHECK(std::is_sorted(by_name.begin(), by_name.end(), [](const S& l, const S& r) { return l.name < r.name; }));
+        CHECK(lookups > data.size());
+        
+        lookups = 0;
+        simlinq::OrderBy(data, simlinq::cached_key(name));
+        CHECK_EQUAL(lookups, data.size());
+    }
+    
+    TEST(OrderByCachedKeySelector)
+    {
+        S_collection data{ {"C", 10}, {"A", 15 }, {"B", 20 }, {"D", 15 } };
+        
+        size_t calls = 0;
+        auto key = simlinq::cached_key([&calls](const S& s) { ++calls; return s.age; });
+        auto compare = [](const int& lhv, const int& rhv) { return lhv < rhv; };
+        
+        S_collection expected{ {"B", 20 }, {"A", 15 }, {"D", 15 }, {"C", 10} };
+        CHECK_EQUAL(compare_collections(simlinq::OrderByDescending(data, key, compare), expected), true);
+        CHECK_EQUAL(calls, data.size());
+    }
+    
+    TEST(OrderByRadixKeys)
+    {
+        /* large enough for the radix sort; keys repeat, so stability is visible through the position */
+        std::vector<std::pair<int, size_t>> data;
+        for (size_t i = 0; i < 5000; ++i)
+            data.emplace_back(static_cast<int>((i * 7919) % 1000) - 500, i);
+        
+        auto expect = [&data](auto key, auto compare) {
+            auto result = data;
+            std::stable_sort(result.begin(), result.end(), [&](const auto& l, const auto& r) { return compare(key(l), key(r)); });
+            return result;
+        };
+        
+        auto asInt = [](const std::pair<int, size_t>& p) { return p.first; };
+        auto asDouble = [](const std::pair<int, size_t>& p) { return p.first / 8.0; };
+        auto asFloat = [](const std::pair<int, size_t>& p) { return static_cast<float>(p.first) * -0.25f; };
+        auto asChar = [](const std::pair<int, size_t>& p) { return static_cast<signed char>(p.first % 100); };
+        auto asUnsigned = [](const std::pair<int, size_t>& p) { return static_cast<uint64_t>(p.first) * 3; };
+        
+        CHECK(simlinq::OrderBy(data, asInt) == expect(asInt, std::less<>()));
+        CHECK(simlinq::OrderByDescending(data, asInt) == expect(asInt, std::greater<>()));
+        CHECK(simlinq::OrderBy(data, asDouble) == expect(asDouble, std::less<>()));
+        CHECK(simlinq::OrderByDescending(data, asFloat) == expect(asFloat, std::greater<>()));
+        CHECK(simlinq::OrderBy(data, asChar) == expect(asChar, std::less<>()));
+        CHECK(simlinq::OrderBy(data, asUnsigned) == expect(asUnsigned, std::less<>()));
+        CHECK(simlinq::OrderBy(std::vector<std::pair<int, size_t>>(data), asInt) == expect(asInt, std::less<>()));
+        
+        /* no unsigned integer as wide as long double: sorted by comparison, which does not promise stability */
+        auto asLongDouble = [](const std::pair<int, size_t>& p) { return p.first / 3.0L; };
+        auto byLongDouble = [&](const auto& l, const auto& r) { return asLongDouble(l) < asLongDouble(r); };
+        auto ascending = simlinq::OrderBy(data, asLongDouble);
+        CHECK(ascending.size() == data.size() and std::is_sorted(ascending.begin(), ascending.end(), byLongDouble));
+        auto descending = simlinq::OrderByDescending(data, asLongDouble);
+        CHECK(std::is_sorted(descending.rbegin(), descending.rend(), byLongDouble));
+        
+        std::deque<std::pair<int, size_t>> queue(data.begin(), data.end());
+        auto ordered = simlinq::OrderBy(queue, asDouble);
+        CHECK(std::equal(ordered.begin(), ordered.end(), expect(asDouble, std::less<>()).begin()));
+    }
+    
+    TEST(DistinctBy)
+    {
+        S_collection data{ {"C", 10}, {"A", 15 }, {"B", 10 }, {"A", 5 }, {"D", 15 } };
+        
+        CHECK_EQUAL(compare_collections(simlinq::DistinctBy(data, [](const S& s) { return s.age; }),
+                                        S_collection{ {"C", 10}, {"A", 15 }, {"A", 5 } }), true);
+        CHECK_EQUAL(compare_collections(simlinq::DistinctBy(data, [](const S& s) { return s.name; }),
+                                        S_collection{ {"C", 10}, {"A", 15 }, {"B", 10 }, {"D", 15 } }), true);
+        CHECK_EQUAL(compare_collections(simlinq::DistinctBy(S_collection(data), [](const S& s) { return s.age * 1000000; }),
+                                        S_collection{ {"C", 10}, {"A", 15 }, {"A", 5 } }), true);
+        
+        std::vector<int> sorted{ 1, 2, 11, 12, 21 };
+        CHECK(simlinq::DistinctBy(sorted, [](int v) { return v / 10; }) == std::vector<int>({ 1, 11, 21 }));
+    }
+    
+    TEST(SelectMany)
+    {
+        const std::vector<std::vector<int>> nested{ { 1, 2 }, {}, { 3 }, { 4, 5, 6 } };
+        auto self = [](const std::vector<int>& v) -> const std::vector<int>& { return v; };
+        
+        CHECK(simlinq::SelectMany(nested, self) == std::vector<int>({ 1, 2, 3, 4, 5, 6 }));
+        CHECK(simlinq::SelectMany(empty, [](int v) { return std::vector<int>(v, v); }).empty());
+        
+        auto repeated = simlinq::SelectMany(std::list<int>{ 1, 2, 3 }, [](int v) { return std::vector<int>(v, v); });
+        CHECK(repeated == std::vector<int>({ 1, 2, 2, 3, 3, 3 }));
+        
+        auto indexed = simlinq::SelectMany(nested, [](const std::vector<int>& v, size_t index) {
+            return std::vector<size_t>(v.size(), index);
+        });
+        CHECK(indexed == std::vector<size_t>({ 0, 0, 2, 3, 3, 3 }));
+        
+        auto labelled = simlinq::SelectMany(nested, self, [](const std::vector<int>& v, int inner) {
+            return std::to_string(v.size()) + ":" + std::to_string(inner);
+        });
+        CHECK(labelled == std::vector<std::string>({ "2:1", "2:2", "1:3", "3:4", "3:5", "3:6" }));
+    }
+    
+    
+    TEST(TopBy)
+    {
+        S_collection data{ {"C", 10}, {"A", 15 }, {"B", 20 }, {"D", 15 }, {"E", 1 } };
+        auto age = [](const S& s) { return s.age; };
+        
+        CHECK_EQUAL(compare_collections(simlinq::TopBy(data, 3, age), S_collection{ {"E", 1}, {"C", 10}, {"A", 15} }), true);
+        CHECK_EQUAL(compare_collections(simlinq::TopByDescending(data, 2, age), S_collection{ {"B", 20}, {"A", 15} }), true);
+        CHECK_EQUAL(compare_collections(simlinq::TopByDescending(data, 3, age, std::greater<int>()),
+                                        S_collection{ {"E", 1}, {"C", 10}, {"A", 15} }), true);
+        CHECK_EQUAL(compare_collections(simlinq::TopBy(data, 10, age), simlinq::OrderBy(data, age)), true);
+        CHECK(simlinq::TopBy(data, 0, age).empty());
+        
+        std::vector<int> values;
+        for (int i = 0; i < 1000; ++i)
+            values.push_back((i * 7919) % 1000);
+        auto identity = [](int v) { return v; };
+        CHECK(simlinq::TopBy(values, 5, identity) == std::vector<int>({ 0, 1, 2, 3, 4 }));
+        CHECK(simlinq::TopBy(std::list<int>(values.begin(), values.end()), 2, identity, std::greater<int>()) == std::list<int>({ 999, 998 }));
+    }
+    
     TEST(Repeat)
     {
         using type_t = std::vector<int>;
@@ -238,9 +637,159 @@ SUITE(GeneratingMethods) {
     
     TEST(UnionComparer)
     {
-        /* Stub */
+        auto union_set = simlinq::Union(first, second, [](int l, int r) { return l == r; });
+        CHECK_EQUAL(union_set.size(), 7);
+        CHECK_EQUAL(union_set.count(-4), 1);
+    }
+    
+    
+    TEST(ToDictionary)
+    {
+        auto key = [](const Customer& c) { return c.id; };
+        auto name = [](const Customer& c) { return c.name; };
+        
+        auto names = simlinq::ToDictionary(customers, key, name);
+        CHECK_EQUAL(names.size(), 3);
+        CHECK_EQUAL(names.at(2), "Bob");
+        
+        auto flat = simlinq::ToDictionary<simlinq::flat_map>(customers, key, name);
+        CHECK_EQUAL(flat.size(), 3);
+        CHECK_EQUAL(flat.at(3), "Eve");
+        CHECK(flat.find(4) == flat.end());
+        CHECK_EQUAL(flat.find(1)->second, "Ann");
+        
+        auto by_id = simlinq::ToDictionary<simlinq::flat_map>(customers, key);
+        CHECK_EQUAL(by_id.at(1).name, "Ann");
+        
+        CHECK_THROW(simlinq::ToDictionary(orders, [](const Order& o) { return o.customer; }), std::invalid_argument);
+    }
+    
+    
+    TEST(ToHashSet)
+    {
+        std::vector<int> data{ 3, 1, 3, 2, 1 };
+        
+        auto set = simlinq::ToHashSet(data);
+        CHECK_EQUAL(set.size(), 3);
+        CHECK_EQUAL(set.count(2), 1);
+        
+        auto flat = simlinq::ToHashSet<simlinq::flat_set>(data);
+        CHECK(std::vector<int>(flat.begin(), flat.end()) == std::vector<int>({3, 1, 2}));
+        CHECK(flat.contains(1));
+        CHECK(not flat.contains(4));
+        
+        auto parity = simlinq::ToHashSet<simlinq::flat_set>(data, simlinq::equality_comparer{
+            [](int v) { return std::hash<int>()(v % 2); },
+            [](int l, int r) { return l % 2 == r % 2; }
+        });
+        CHECK_EQUAL(parity.size(), 2);
+    }
+    
+    
+    TEST(ToLookup)
+    {
+        auto amounts = simlinq::ToLookup(orders,
+                                         [](const Order& o) { return o.customer; },
+                                         [](const Order& o) { return o.amount; });
+        CHECK_EQUAL(amounts.size(), 4);
+        CHECK(std::vector<int>(amounts[1].begin(), amounts[1].end()) == std::vector<int>({20, 50}));
+        CHECK(amounts[3].empty());
+        
+        auto by_customer = simlinq::ToLookup(orders, [](const Order& o) { return o.customer; });
+        CHECK_EQUAL(by_customer[2].size(), 3);
+        CHECK_EQUAL(by_customer[2].back().amount, 60);
+    }
+    
+    
+    TEST(FlatMap)
+    {
+        simlinq::flat_map<std::string, int> map;
+        for (int i = 0; i < 1000; ++i)
+            map[std::to_string(i % 100)] += i;
+        
+        CHECK_EQUAL(map.size(), 100);
+        CHECK_EQUAL(map.at("7"), 7 * 10 + 100 * 45);
+        CHECK(not map.try_emplace("7", 0).second);
+        CHECK_THROW(map.at("x"), std::out_of_range);
+        
+        int total = 0;
+        for (const auto& [k, v] : map)
+            total += v;
+        CHECK_EQUAL(total, 999 * 1000 / 2);
+    }
+    
+    TEST(RuntimeTakeAndPage)
+    {
+        const size_t count = 3;
+        CHECK(simlinq::Take(first, count) == std::vector<int>({ 1, 2, 3 }));
+        CHECK(simlinq::Take(first, 9) == first);
+        CHECK(simlinq::Take(std::vector<int>(first), 2) == std::vector<int>({ 1, 2 }));
+        CHECK(simlinq::TakeLast(first, 2) == std::vector<int>({ 4, 5 }));
+        CHECK(simlinq::TakeLast(first, 9) == first);
+        CHECK(simlinq::SkipLast(first, 2) == std::vector<int>({ 1, 2, 3 }));
+        CHECK(simlinq::SkipLast(first, 9).empty());
+        
+        CHECK(simlinq::Page(first, 1, 2) == std::vector<int>({ 2, 3 }));
+        CHECK(simlinq::Page(first, 4, 2) == std::vector<int>({ 5 }));
+        CHECK(simlinq::Page(first, 7, 2).empty());
+        
+        const std::forward_list<int> forward{ 1, 2, 3, 4, 5 };
+        CHECK(simlinq::Page(forward, 2, 2) == std::forward_list<int>({ 3, 4 }));
+        CHECK(simlinq::TakeLast(forward, 1) == std::forward_list<int>({ 5 }));
+        CHECK(simlinq::SkipLast(forward, 4) == std::forward_list<int>({ 1 }));
+        
+        auto page = simlinq::PageView(first, 3, 10);
+        CHECK(page.data() == first.data() + 3);
+        CHECK_EQUAL(page.size(), 2u);
+        CHECK_EQUAL(simlinq::TakeLastView(first, 2).front(), 4);
+        CHECK_EQUAL(simlinq::SkipLastView(forward, 2).size(), 3u);
+        
+        CHECK(simlinq::from(first).Page(2, 2).ToVector() == std::vector<int>({ 3, 4 }));
     }
     
+    
+    TEST(Views)
+    {
+        auto tail = simlinq::SkipView(first, 2);
+        CHECK_EQUAL(tail.size(), 3u);
+        CHECK(tail.data() == first.data() + 2);
+        CHECK_EQUAL(simlinq::Sum(tail), 12);
+        CHECK(simlinq::from(tail).ToVector() == std::vector<int>({ 3, 4, 5 }));
+        CHECK(simlinq::SkipView(first, 9).empty());
+        
+        auto head = simlinq::TakeView(first, 2);
+        CHECK(std::vector<int>(head.begin(), head.end()) == std::vector<int>({ 1, 2 }));
+        CHECK_EQUAL(simlinq::TakeView(first, 9).size(), 5u);
+        
+        auto small = simlinq::TakeWhileView(first, [](int v) { return v < 3; });
+        CHECK_EQUAL(small.back(), 2);
+        CHECK_EQUAL(simlinq::SkipWhileView(first, [](int v) { return v < 3; }).front(), 3);
+        
+        auto reversed = simlinq::ReverseView(first);
+        CHECK(std::vector<int>(reversed.begin(), reversed.end()) == std::vector<int>({ 5, 4, 3, 2, 1 }));
+        CHECK_EQUAL(reversed[1], 4);
+        CHECK(first == std::vector<int>({ 1, 2, 3, 4, 5 }));
+        
+        /* pages of a large result without copying the tail */
+        const std::list<int> list{ 1, 2, 3, 4, 5 };
+        auto page = simlinq::TakeView(simlinq::SkipView(list, 2), 2);
+        CHECK(std::list<int>(page.begin(), page.end()) == std::list<int>({ 3, 4 }));
+        CHECK_EQUAL(*simlinq::Max(simlinq::ReverseView(list)), 5);
+        
+        /* operators that build a sequence give an owning vector for views, temporaries included */
+        auto identity = [](int v) { return v; };
+        std::vector<int> even = simlinq::Where(simlinq::SkipView(first, 1), isEven);
+        CHECK(even == std::vector<int>({ 2, 4 }));
+        CHECK(simlinq::Where(tail, isEven) == std::vector<int>({ 4 }));
+        CHECK(simlinq::OrderBy(simlinq::ReverseView(first), identity) == first);
+        CHECK(simlinq::OrderByDescending(simlinq::SkipView(first, 1), identity) == std::vector<int>({ 5, 4, 3, 2 }));
+        CHECK(simlinq::OrderBy(page, identity) == std::vector<int>({ 3, 4 }));
+        CHECK(simlinq::Skip(simlinq::SkipView(first, 1), 2) == std::vector<int>({ 4, 5 }));
+        CHECK(simlinq::Distinct(simlinq::TakeView(first, 3)) == std::vector<int>({ 1, 2, 3 }));
+        CHECK(first == std::vector<int>({ 1, 2, 3, 4, 5 }));
+    }
+    
+    
     TEST(Where)
     {
         auto sequence = simlinq::Where(first, isEven);
@@ -269,5 +818,58 @@ SUITE(GeneratingMethods) {
                                 });
         CHECK(zip == std::vector<std::string>({ "1 : first", "2 : second", "3 : third" }));
     }
+    
+    
+    TEST(NodeBasedSources)
+    {
+        const std::list<int> list{ 1, 2, 3, 4, 5 };
+        const std::forward_list<int> forward{ 1, 2, 3, 4, 5 };
+        
+        CHECK(*simlinq::ElementAt(list, 3) == 4);
+        CHECK(*simlinq::ElementAt(forward, 4) == 5);
+        CHECK(simlinq::ElementAt(forward, 5) == std::nullopt);
+        CHECK_EQUAL(simlinq::ElementAtOrDefault(list, 9), 0);
+        
+        CHECK(simlinq::Skip(list, 3) == std::list<int>({ 4, 5 }));
+        CHECK(simlinq::Skip(forward, 7).empty());
+        CHECK(simlinq::Take<2>(list) == std::list<int>({ 1, 2 }));
+        CHECK(simlinq::Take<9>(forward) == forward);
+        CHECK(simlinq::Take<9>(first) == first);
+        
+        using forward_t = std::forward_list<int>;
+        CHECK(simlinq::Skip(forward_t(forward), 3) == forward_t({ 4, 5 }));
+        CHECK(simlinq::Take(forward_t(forward), 2) == forward_t({ 1, 2 }));
+        CHECK(simlinq::SkipWhile(forward_t(forward), [](int v) { return v < 4; }) == forward_t({ 4, 5 }));
+        CHECK(simlinq::TakeWhile(forward_t(forward), [](int v) { return v < 3; }) == forward_t({ 1, 2 }));
+        CHECK(simlinq::Skip(std::list<int>(list), 7).empty());
+        
+        CHECK(*simlinq::Last(forward) == 5);
+        CHECK(*simlinq::Last(forward, isEven) == 4);
+        CHECK(*simlinq::Last(list, isEven) == 4);
+        CHECK_EQUAL(simlinq::LastOrDefault(forward, [](int v) { return v > 9; }), 0);
+        
+        CHECK_EQUAL(simlinq::Count(forward), 5u);
+        CHECK(simlinq::SequenceEqual(forward, std::forward_list<int>({ 1, 2, 3, 4, 5 })));
+        CHECK(not simlinq::SequenceEqual(forward, std::forward_list<int>({ 1, 2, 3 })));
+        CHECK(simlinq::Concat(list, list).size() == 10u);
+        
+        auto sums = simlinq::Zip(list, forward, [](int l, int r) { return l + r; });
+        CHECK(sums == std::vector<int>({ 2, 4, 6, 8, 10 }));
+        
+        auto indexed = simlinq::select<std::vector>(list);
+        CHECK_EQUAL(indexed[4].first, 4u);
+        CHECK_EQUAL(indexed[4].second, 5);
+        
+        auto queued = simlinq::select<std::deque>(list);
+        CHECK_EQUAL(queued.size(), 5u);
+        CHECK_EQUAL(queued[2].second, 3);
+        
+        std::forward_list<int> appended{ 1, 2 };
+        simlinq::Append(appended, 3);
+        CHECK(appended == std::forward_list<int>({ 1, 2, 3 }));
+        std::list<int> tail{ 1 };
+        simlinq::Append(tail, 2);
+        CHECK(tail == std::list<int>({ 1, 2 }));
+    }
 }
 
@@ -0,0 +1,99 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <array>
+#include <deque>
+#include <vector>
+
+
+SUITE(NumericMethods)
+{
+    template<typename T>
+    std::vector<T> make_data(size_t count) {
+        std::vector<T> v(count);
+        for (size_t i = 0; i < count; ++i)
+            v[i] = static_cast<T>((static_cast<long long>(i) * 7919) % 2003 - 1000);
+        return v;
+    }
+    
+    /* sizes around the vector widths exercise the kernel tails */
+    const std::vector<size_t> sizes{ 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 1000, 4099 };
+    
+    
+    TEST(SumKernels)
+    {
+        for (auto size : sizes) {
+            auto ints = make_data<int>(size);
+            CHECK_EQUAL(simlinq::Sum(ints), std::accumulate(ints.begin(), ints.end(), 0));
+            
+            auto doubles = make_data<double>(size);
+            CHECK_EQUAL(simlinq::Sum(doubles), std::accumulate(doubles.begin(), doubles.end(), 0.0));
+            
+            auto floats = make_data<float>(size);
+            CHECK_EQUAL(simlinq::Sum(floats), std::accumulate(floats.begin(), floats.end(), 0.0f));
+        }
+        
+        CHECK_EQUAL(simlinq::Sum(std::vector<int>()), 0);
+        CHECK_EQUAL(simlinq::Sum(std::array<double, 3>{ 1.5, 2.5, 3.0 }), 7.0);
+        CHECK_EQUAL(simlinq::Sum(std::deque<int>{ 1, 2, 3 }), 6);
+    }
+    
+    
+    TEST(MinMaxKernels)
+    {
+        for (auto size : sizes) {
+            auto ints = make_data<int>(size);
+            CHECK_EQUAL(*simlinq::Min(ints), *std::min_element(ints.begin(), ints.end()));
+            CHECK_EQUAL(*simlinq::Max(ints), *std::max_element(ints.begin(), ints.end()));
+            
+            auto floats = make_data<float>(size);
+            floats[size / 2] = -5000.0f;
+            floats[size - 1] = 5000.0f;
+            CHECK_EQUAL(*simlinq::Min(floats), *std::min_element(floats.begin(), floats.end()));
+            CHECK_EQUAL(*simlinq::Max(floats), 5000.0f);
+            
+            auto doubles = make_data<double>(size);
+            CHECK_EQUAL(*simlinq::Min(doubles), *std::min_element(doubles.begin(), doubles.end()));
+            CHECK_EQUAL(*simlinq::Max(doubles), *std::max_element(doubles.begin(), doubles.end()));
+        }
+        
+        CHECK(simlinq::Min(std::vector<float>()) == std::nullopt);
+        CHECK(simlinq::Max(std::vector<double>()) == std::nullopt);
+    }
+    
+    
+    TEST(Average)
+    {
+        std::vector<double> doubles{ 1.0, 2.0, 3.0, 6.0 };
+        CHECK_EQUAL(simlinq::Average(doubles), 3.0);
+        
+        std::vector<int> ints{ 1, 2, 3, 6 };
+        CHECK_EQUAL(simlinq::Average(ints), 3);
+        CHECK_CLOSE((simlinq::Average<std::vector<int>, double>(ints)), 3.0, 1e-12);
+        CHECK_THROW(simlinq::Average(std::vector<int>()), std::invalid_argument);
+        
+        auto average = simlinq::Average(ints, [](int v) { return v * 0.5; });
+        REQUIRE CHECK(average != std::nullopt);
+        CHECK_CLOSE(*average, 1.5, 1e-12);
+        CHECK(simlinq::Average(std::vector<int>(), [](int v) { return v * 0.5; }) == std::nullopt);
+    }
+    
+    
+    TEST(SumAccuracy)
+    {
+        /* one large value followed by many values too small to register on their own */
+        std::vector<float> values(1000001, 1e-4f);
+        values[0] = 1e4f;
+        const double exact = 1e4 + 1e-4 * 1000000;
+        
+        auto error = [exact](float sum) { return std::abs(static_cast<double>(sum) - exact); };
+        
+        CHECK(error(simlinq::Sum(values, simlinq::summation::kahan)) < 1e-2);
+        CHECK(error(simlinq::Sum(values, simlinq::summation::pairwise)) < 5e-2);
+        CHECK(error(simlinq::Sum(values, simlinq::summation::kahan)) < error(std::accumulate(values.begin(), values.end(), 0.0f)));
+        
+        std::deque<double> deque{ 0.1, 0.2, 0.3 };
+        CHECK_CLOSE(simlinq::Sum(deque, simlinq::summation::pairwise), 0.6, 1e-12);
+        CHECK_EQUAL(simlinq::Sum(std::vector<int>{ 1, 2, 3 }, simlinq::summation::kahan), 6);
+    }
+}
@@ -0,0 +1,268 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <atomic>
+#include <deque>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+SUITE(ParallelMethods)
+{
+    std::vector<int> make_data(int count) {
+        std::vector<int> v(count);
+        for (int i = 0; i < count; ++i)
+            v[i] = (i * 7919) % 100003 - 50000;
+        return v;
+    }
+    
+    std::vector<int> data = make_data(200000);
+    std::vector<int> small{ -1, 1, -4, 5, 2, 3, 6, 5};
+    std::vector<int> empty;
+    
+    bool isEven(const int& v) { return v % 2 == 0; }
+    bool isHuge(const int& v) { return v > 1000000; }
+    
+    
+    TEST(Sum)
+    {
+        std::vector<long long> values(data.begin(), data.end());
+        CHECK_EQUAL(simlinq::Sum(simlinq::par, values), simlinq::Sum(values));
+        CHECK_EQUAL(simlinq::Sum(simlinq::par, small), 17);
+        CHECK_EQUAL(simlinq::Sum(simlinq::seq, small), 17);
+        CHECK_EQUAL(simlinq::Sum(simlinq::par, empty), 0);
+    }
+    
+    TEST(Count)
+    {
+        CHECK_EQUAL(simlinq::Count(simlinq::par, data, isEven), simlinq::Count(data, isEven));
+        CHECK_EQUAL(simlinq::LongCount(simlinq::par, data, isEven), simlinq::LongCount(data, isEven));
+        CHECK_EQUAL(simlinq::Count(simlinq::par, small, isEven), 3);
+        CHECK_EQUAL(simlinq::Count(simlinq::par, empty, isEven), 0);
+    }
+    
+    TEST(MinMax)
+    {
+        CHECK(simlinq::Min(simlinq::par, data) == simlinq::Min(data));
+        CHECK(simlinq::Max(simlinq::par, data) == simlinq::Max(data));
+        CHECK_EQUAL(*simlinq::Min(simlinq::par, small), -4);
+        CHECK_EQUAL(*simlinq::Max(simlinq::seq, small), 6);
+        CHECK(simlinq::Min(simlinq::par, empty) == std::nullopt);
+    }
+    
+    TEST(Search)
+    {
+        CHECK(simlinq::Any(simlinq::par, data, isEven));
+        CHECK(not simlinq::Any(simlinq::par, data, isHuge));
+        CHECK(not simlinq::All(simlinq::par, data, isEven));
+        CHECK(simlinq::All(simlinq::par, data, [](int v) { return v < 100000; }));
+        CHECK(simlinq::Contains(simlinq::par, data, data.back()));
+        CHECK(not simlinq::Contains(simlinq::par, data, 1000001));
+        CHECK(not simlinq::Any(simlinq::par, empty, isEven));
+    }
+    
+    TEST(SingleAndLast)
+    {
+        /* data repeats every 100003 elements: only the values around the middle occur once */
+        const int target = data[100001];
+        auto isTarget = [target](int v) { return v == target; };
+        CHECK(simlinq::Single(simlinq::par, data, isTarget) == target);
+        CHECK_EQUAL(simlinq::SingleOrDefault(simlinq::par, data, isTarget), target);
+        
+        const int twice = data[150000];
+        CHECK(simlinq::Single(simlinq::par, data, [twice](int v) { return v == twice; }) == std::nullopt);
+        CHECK(simlinq::Single(simlinq::par, data, isEven) == std::nullopt);
+        CHECK(simlinq::Single(simlinq::par, data, isHuge) == std::nullopt);
+        CHECK_EQUAL(simlinq::SingleOrDefault(simlinq::par, data, isEven), 0);
+        CHECK(simlinq::Single(simlinq::par, small, [](int v) { return v == 6; }) == 6);
+        
+        CHECK(simlinq::Last(simlinq::par, data, isEven) == simlinq::Last(data, isEven));
+        CHECK(simlinq::Last(simlinq::par, data, [](int v) { return v < -49990; }) == simlinq::Last(data, [](int v) { return v < -49990; }));
+        CHECK(simlinq::Last(simlinq::par, data, isHuge) == std::nullopt);
+        CHECK_EQUAL(simlinq::LastOrDefault(simlinq::par, data, isEven), *simlinq::Last(data, isEven));
+        CHECK_EQUAL(simlinq::LastOrDefault(simlinq::par, empty, isEven), 0);
+    }
+    
+    TEST(Threshold)
+    {
+        auto serial_only = simlinq::par.with_threshold(data.size() + 1);
+        CHECK_EQUAL(simlinq::Sum(serial_only, data), simlinq::Sum(data));
+        CHECK(simlinq::Contains(serial_only, data, data.front()));
+    }
+    
+    TEST(NonRandomAccess)
+    {
+        std::list<int> values(data.begin(), data.end());
+        CHECK_EQUAL(simlinq::Count(simlinq::par, values, isEven), simlinq::Count(data, isEven));
+        CHECK(simlinq::Any(simlinq::par, values, isEven));
+    }
+    
+    TEST(Exception)
+    {
+        CHECK_THROW(simlinq::Any(simlinq::par, data, [](int) -> bool { throw std::runtime_error("failure"); }),
+                    std::runtime_error);
+    }
+    
+    TEST(OrderBy)
+    {
+        auto identity = [](int v) { return v; };
+        CHECK(simlinq::OrderBy(simlinq::par, data, identity) == simlinq::OrderBy(data, identity));
+        CHECK(simlinq::OrderByDescending(simlinq::par, data, identity) == simlinq::OrderByDescending(data, identity));
+        CHECK(simlinq::OrderBy(simlinq::par, data, identity, std::greater<int>()) == simlinq::OrderByDescending(data, identity));
+        CHECK(simlinq::OrderBy(simlinq::par, small, identity) == std::vector<int>({ -4, -1, 1, 2, 3, 5, 5, 6 }));
+        CHECK(simlinq::OrderBy(simlinq::par, empty, identity).empty());
+        
+        /* cached string keys keep equal keys in source order */
+        auto tens = [](int v) { return std::to_string(v / 10); };
+        CHECK(simlinq::OrderBy(simlinq::par, data, tens) == simlinq::OrderBy(data, tens));
+        
+        /* cached keys are computed once per element, on the pool */
+        simlinq::thread_pool_options options;
+        options.workers = 3;
+        simlinq::thread_pool pool(options);
+        std::atomic<size_t> calls{ 0 };
+        auto counted = [&calls, &tens](int v) { calls.fetch_add(1, std::memory_order_relaxed); return tens(v); };
+        CHECK(simlinq::OrderBy(simlinq::par.on(pool), data, counted) == simlinq::OrderBy(data, tens));
+        CHECK_EQUAL(calls.load(), data.size());
+    }
+    
+    TEST(OrderedQuerySharedByThreads)
+    {
+        auto ordered = simlinq::from(data).OrderBy([](int v) { return v; });
+        const auto copy = ordered;
+        const auto expected = simlinq::OrderBy(data, [](int v) { return v; });
+        
+        std::vector<int> matches(4);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < matches.size(); ++i) {
+            threads.emplace_back([&, i] {
+                const auto& q = i % 2 == 0 ? ordered : copy;
+                matches[i] = std::equal(q.begin(), q.end(), expected.begin(), expected.end());
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        
+        CHECK(matches == std::vector<int>(4, 1));
+        CHECK(&*ordered.begin() == &*copy.begin());
+    }
+    
+    TEST(OrderByThenByStable)
+    {
+        auto bucket = [](int v) { return v / 1000; };
+        auto parity = [](int v) { return v & 1; };
+        
+        auto parallel = simlinq::from(data).OrderBy(bucket).ThenByDescending(parity).Stable().Parallel().ToVector();
+        auto serial = simlinq::from(data).OrderBy(bucket).ThenByDescending(parity).Stable().ToVector();
+        CHECK(parallel == serial);
+        
+        auto threshold = simlinq::from(data).OrderBy(bucket).Parallel(simlinq::par.with_threshold(10)).Stable().ToVector();
+        CHECK(threshold == simlinq::from(data).OrderBy(bucket).Stable().ToVector());
+    }
+    
+    /* queues tasks without running them; waiting callers drain the queue themselves */
+    class queueing_executor : public simlinq::executor {
+    public:
+        size_t submitted = 0;
+        
+        size_t concurrency() const override { return 3; }
+        
+        void submit(std::function<void()> task) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++submitted;
+            tasks_.push_back(std::move(task));
+        }
+        
+        bool run_pending() override {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (tasks_.empty())
+                    return false;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+            return true;
+        }
+        
+    private:
+        std::mutex mutex_;
+        std::deque<std::function<void()>> tasks_;
+    };
+    
+    TEST(CustomExecutor)
+    {
+        queueing_executor exec;
+        auto on_exec = simlinq::par.on(exec);
+        CHECK_EQUAL(simlinq::Sum(on_exec, data), simlinq::Sum(data));
+        CHECK(simlinq::OrderBy(on_exec, data, [](int v) { return v; }) == simlinq::OrderBy(data, [](int v) { return v; }));
+        CHECK(exec.submitted > 0);
+        
+        const auto before = exec.submitted;
+        simlinq::set_default_executor(&exec);
+        CHECK_EQUAL(simlinq::Count(simlinq::par, data, isEven), simlinq::Count(data, isEven));
+        simlinq::set_default_executor(nullptr);
+        CHECK(exec.submitted > before);
+        
+        const auto after = exec.submitted;
+        simlinq::Count(simlinq::par, data, isEven);
+        CHECK_EQUAL(exec.submitted, after);
+    }
+    
+    TEST(ThreadPool)
+    {
+        simlinq::thread_pool_options options;
+        options.workers = 3;
+        options.cores = { 0 };
+        simlinq::thread_pool pool(options);
+        CHECK_EQUAL(pool.concurrency(), 3u);
+        
+        auto on_pool = simlinq::par.on(pool);
+        CHECK_EQUAL(simlinq::Sum(on_pool, data), simlinq::Sum(data));
+        CHECK(simlinq::OrderBy(on_pool, data, [](int v) { return -v; }) == simlinq::OrderByDescending(data, [](int v) { return v; }));
+        
+        /* parallel calls from inside tasks of the same pool help instead of waiting for a free worker */
+        const auto expected = simlinq::Sum(data);
+        const std::vector<int> outer(16);
+        auto nested = simlinq::Count(on_pool.with_threshold(0).with_grain(1), outer, [&](int) {
+            return simlinq::Sum(on_pool, data) == expected;
+        });
+        CHECK_EQUAL(nested, 16);
+        
+        simlinq::thread_pool_options no_workers;
+        no_workers.workers = 0;
+        simlinq::thread_pool serial(no_workers);
+        CHECK_EQUAL(simlinq::Max(simlinq::par.on(serial), data), simlinq::Max(data));
+    }
+    
+    TEST(GrainAndCost)
+    {
+        simlinq::thread_pool_options options;
+        options.workers = 3;
+        simlinq::thread_pool pool(options);
+        auto on_pool = simlinq::par.on(pool).with_threshold(0);
+        
+        /* 2000 elements are too few to split at the default grain, but not for an expensive callable */
+        const std::vector<int> few(data.begin(), data.begin() + 2000);
+        size_t calls_off_caller = 0;
+        std::mutex mutex;
+        const auto caller = std::this_thread::get_id();
+        auto counting = [&](int v) {
+            if (std::this_thread::get_id() != caller) {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++calls_off_caller;
+            }
+            return v % 2 == 0;
+        };
+        
+        CHECK_EQUAL(simlinq::Count(on_pool, few, counting), simlinq::Count(few, isEven));
+        CHECK_EQUAL(calls_off_caller, 0u);
+        
+        CHECK_EQUAL(simlinq::Count(on_pool.with_cost(100), few, counting), simlinq::Count(few, isEven));
+        CHECK_EQUAL(simlinq::Count(on_pool.with_grain(100), few, counting), simlinq::Count(few, isEven));
+        CHECK_EQUAL(simlinq::Sum(on_pool.with_grain(1), small), simlinq::Sum(small));
+    }
+}
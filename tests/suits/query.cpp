@@ -0,0 +1,230 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+SUITE(QueryMethods)
+{
+    std::vector<int> data{ -1, 1, -4, 5, 2, 3, 6, 5};
+    std::vector<int> empty;
+    
+    bool isEven(const int& v) { return v % 2 == 0; }
+    bool isOdd(const int& v)  { return v % 2 != 0; }
+    bool isZero(const int& v) { return v == 0; }
+    
+    
+    TEST(Where)
+    {
+        CHECK(simlinq::from(data).Where(isEven).ToVector() == std::vector<int>({-4, 2, 6}));
+        CHECK(simlinq::from(data).Where(isZero).ToVector() == empty);
+        CHECK(simlinq::from(empty).Where(isEven).ToVector() == empty);
+    }
+    
+    TEST(Select)
+    {
+        auto strings = simlinq::from(data)
+                        .Where(isEven)
+                        .Select([](int v) { return std::to_string(v); })
+                        .ToVector();
+        CHECK(strings == std::vector<std::string>({"-4", "2", "6"}));
+    }
+    
+    TEST(SkipTake)
+    {
+        CHECK(simlinq::from(data).Skip(6).ToVector() == std::vector<int>({6, 5}));
+        CHECK(simlinq::from(data).Skip(10).ToVector() == empty);
+        CHECK(simlinq::from(data).Take(3).ToVector() == std::vector<int>({-1, 1, -4}));
+        CHECK(simlinq::from(data).Take(20).ToVector() == data);
+        CHECK(simlinq::from(data).Take(0).ToVector() == empty);
+        CHECK(simlinq::from(data).Skip(2).Take(2).ToVector() == std::vector<int>({-4, 5}));
+    }
+    
+    TEST(SkipWhileTakeWhile)
+    {
+        auto negative = [](int v) { return v < 0; };
+        CHECK(simlinq::from(data).SkipWhile(negative).ToVector() == std::vector<int>({1, -4, 5, 2, 3, 6, 5}));
+        CHECK(simlinq::from(data).TakeWhile(negative).ToVector() == std::vector<int>({-1}));
+        CHECK(simlinq::from(data).TakeWhile(isZero).ToVector() == empty);
+    }
+    
+    TEST(Concat)
+    {
+        std::vector<int> second{ 7, 8 };
+        CHECK(simlinq::from(data).Take(2).Concat(second).ToVector() == std::vector<int>({-1, 1, 7, 8}));
+        CHECK(simlinq::from(empty).Concat(second).ToVector() == second);
+    }
+    
+    TEST(Consumers)
+    {
+        auto q = simlinq::from(data).Where(isOdd);
+        
+        CHECK_EQUAL(q.Count(), 5);
+        CHECK_EQUAL(q.Count(isEven), 0);
+        CHECK_EQUAL(q.Sum(), 13);
+        CHECK_EQUAL(q.Sum([](int v) { return v * 2; }), 26);
+        CHECK_EQUAL(*q.Min(), -1);
+        CHECK_EQUAL(*q.Max(), 5);
+        CHECK_EQUAL(*q.First(), -1);
+        CHECK_EQUAL(*q.First([](int v) { return v > 3; }), 5);
+        CHECK_EQUAL(q.FirstOrDefault(), -1);
+        CHECK(q.All(isOdd));
+        CHECK(q.Any());
+        CHECK(q.Contains(3));
+        CHECK(not q.Contains(2));
+        
+        auto none = simlinq::from(data).Where(isZero);
+        CHECK(none.First() == std::nullopt);
+        CHECK(none.Min() == std::nullopt);
+        CHECK(not none.Any());
+        CHECK_EQUAL(none.FirstOrDefault(), int());
+    }
+    
+    TEST(ShortCircuit)
+    {
+        int visited = 0;
+        auto counting = [&visited](int v) { ++visited; return v > 0; };
+        
+        CHECK_EQUAL(*simlinq::from(data).Where(counting).First(), 1);
+        CHECK_EQUAL(visited, 2);
+        
+        visited = 0;
+        CHECK(simlinq::from(data).Where(counting).Take(1).ToVector() == std::vector<int>({1}));
+        CHECK_EQUAL(visited, 2);
+    }
+    
+    TEST(RangeFor)
+    {
+        std::list<int> source{ 1, 2, 3, 4 };
+        std::vector<int> result;
+        for (auto v : simlinq::from(source).Select([](int v) { return v * v; }))
+            result.push_back(v);
+        CHECK(result == std::vector<int>({1, 4, 9, 16}));
+    }
+    
+    TEST(Owning)
+    {
+        auto q = simlinq::from(std::vector<int>{ 1, 2, 3, 4 }).Where(isEven);
+        CHECK(q.ToVector() == std::vector<int>({2, 4}));
+        CHECK(q.To<std::list<int>>() == std::list<int>({2, 4}));
+        
+        auto set = simlinq::from(std::vector<int>{ 4, 2, 4, 3 }).To<simlinq::flat_set<int>>();
+        CHECK(std::vector<int>(set.begin(), set.end()) == std::vector<int>({4, 2, 3}));
+    }
+    
+    TEST(OrderByThenBy)
+    {
+        using entry = std::pair<std::string, int>;
+        const std::vector<entry> people{ {"bob", 30}, {"amy", 25}, {"cid", 25}, {"amy", 31}, {"bob", 22} };
+        auto name = [](const entry& e) { return e.first; };
+        auto age = [](const entry& e) { return e.second; };
+        
+        CHECK(simlinq::from(people).OrderBy(name).ThenBy(age).ToVector() ==
+              std::vector<entry>({ {"amy", 25}, {"amy", 31}, {"bob", 22}, {"bob", 30}, {"cid", 25} }));
+        CHECK(simlinq::from(people).OrderBy(age).ThenByDescending(name).ToVector() ==
+              std::vector<entry>({ {"bob", 22}, {"cid", 25}, {"amy", 25}, {"bob", 30}, {"amy", 31} }));
+        CHECK(simlinq::from(people).OrderByDescending(name).ThenBy(age, std::greater<int>()).Select(age).ToVector() ==
+              std::vector<int>({ 25, 30, 22, 31, 25 }));
+        CHECK(*simlinq::from(people).Where([](const entry& e) { return e.second > 24; }).OrderBy(age).ThenBy(name).First() ==
+              entry("amy", 25));
+    }
+    
+    TEST(OrderBySortsOnce)
+    {
+        int sorts = 0;
+        auto q = simlinq::from(data).Select([&sorts](int v) { ++sorts; return v; }).OrderBy([](int v) { return v; });
+        
+        CHECK(q.ToVector() == std::vector<int>({ -4, -1, 1, 2, 3, 5, 5, 6 }));
+        CHECK_EQUAL(sorts, 8);
+        CHECK(q.Skip(5).ToVector() == std::vector<int>({ 5, 5, 6 }));
+        CHECK_EQUAL(q.Count(), 8u);
+        CHECK_EQUAL(sorts, 8);
+    }
+    
+    TEST(OrderByStable)
+    {
+        const std::vector<int> values{ 31, 12, 21, 42, 11, 22, 41, 32 };
+        auto tens = [](int v) { return v / 10; };
+        auto odd = [](int v) { return v % 2; };
+        
+        CHECK(simlinq::from(values).OrderBy(tens).Stable().ToVector() ==
+              std::vector<int>({ 12, 11, 21, 22, 31, 32, 42, 41 }));
+        CHECK(simlinq::from(values).OrderByDescending(odd).Stable().ThenBy(tens).ToVector() ==
+              std::vector<int>({ 11, 21, 31, 41, 12, 22, 32, 42 }));
+        CHECK(simlinq::from(empty).OrderBy(tens).ThenBy(odd).ToVector().empty());
+    }
+    
+    TEST(OrderByTake)
+    {
+        auto q = simlinq::from(data).OrderByDescending([](int v) { return v; });
+        CHECK(q.Take(3).ToVector() == std::vector<int>({ 6, 5, 5 }));
+        CHECK(q.Take(0).ToVector().empty());
+        CHECK(q.Take(100).ToVector() == q.ToVector());
+        
+        /* read once from a single-pass source */
+        std::istringstream input("9 4 7 1 8 2 4");
+        auto top = simlinq::from(std::istream_iterator<int>(input), std::istream_iterator<int>())
+                        .OrderBy([](int v) { return v % 2; })
+                        .ThenBy([](int v) { return v; })
+                        .Take(4)
+                        .ToVector();
+        CHECK(top == std::vector<int>({ 2, 4, 4, 8 }));
+    }
+    
+    
+    TEST(SelectMany)
+    {
+        const std::vector<std::vector<int>> nested{ {}, { 1, 2 }, {}, { 3 }, {} };
+        auto self = [](const std::vector<int>& v) -> const std::vector<int>& { return v; };
+        
+        CHECK(simlinq::from(nested).SelectMany(self).ToVector() == std::vector<int>({ 1, 2, 3 }));
+        CHECK_EQUAL(simlinq::from(nested).SelectMany(self).Where(isOdd).Sum(), 4);
+        CHECK(simlinq::from(empty).SelectMany([](int v) { return std::vector<int>(v, v); }).ToVector().empty());
+        
+        /* collections built by the selector live as long as the iterator that reads them */
+        auto ranges = simlinq::from(data).Where([](int v) { return v > 0; }).SelectMany([](int v, size_t index) {
+            return std::vector<int>(index == 0 ? 2 : 1, v);
+        });
+        CHECK(ranges.ToVector() == std::vector<int>({ 1, 1, 5, 2, 3, 6, 5 }));
+        CHECK_EQUAL(ranges.Count(), 7u);
+        
+        auto pairs = simlinq::from(nested).SelectMany(self, [](const std::vector<int>& v, int inner) { return inner * 10 + int(v.size()); });
+        CHECK(pairs.ToVector() == std::vector<int>({ 12, 22, 31 }));
+    }
+    
+    
+    TEST(MaskWhere)
+    {
+        auto positive = simlinq::mask(data).Where([](int v) { return v > 0; });
+        CHECK(positive.ToVector() == std::vector<int>({ 1, 5, 2, 3, 6, 5 }));
+        
+        auto selected = std::move(positive).Where(isOdd).Where([](int v) { return v < 5; });
+        CHECK(selected.ToVector() == std::vector<int>({ 1, 3 }));
+        CHECK(selected.Indices() == std::vector<size_t>({ 1, 5 }));
+        CHECK_EQUAL(selected.Count(), 2u);
+        CHECK(not simlinq::mask(data).Where(isZero).Any());
+        CHECK(not simlinq::mask(empty).Any());
+        
+        /* blocks of 64 and a partial last block */
+        std::vector<int> many(200);
+        for (size_t i = 0; i < many.size(); ++i)
+            many[i] = static_cast<int>(i);
+        auto multiples = simlinq::mask(many).Where([](int v) { return v % 3 == 0; });
+        CHECK_EQUAL(multiples.Count(), 67u);
+        CHECK_EQUAL(simlinq::from(multiples).Sum(), 3 * 66 * 67 / 2);
+        
+        auto filtered = multiples.Where([](int v) { return v >= 190; });
+        CHECK(filtered.ToVector() == std::vector<int>({ 192, 195, 198 }));
+        CHECK_EQUAL(multiples.Count(), 67u);
+        
+        /* a temporary selection lives as long as the loop over it */
+        std::vector<int> looped;
+        for (int v : simlinq::mask(many).Where([](int v) { return v % 50 == 0; }).Where([](int v) { return v > 0; }))
+            looped.push_back(v);
+        CHECK(looped == std::vector<int>({ 50, 100, 150 }));
+    }
+}
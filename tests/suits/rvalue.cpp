@@ -0,0 +1,107 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <forward_list>
+#include <list>
+#include <string>
+#include <vector>
+
+
+SUITE(RvalueMethods)
+{
+    const std::vector<int> data{ 5, 3, 8, 1, 8, 4, 2, 7 };
+
+    bool isEven(const int& v) { return v % 2 == 0; }
+    int identity(const int& v) { return v; }
+
+
+    TEST(OrderByReusesStorage)
+    {
+        auto values = data;
+        const auto storage = values.data();
+
+        auto ordered = simlinq::OrderBy(std::move(values), identity);
+        CHECK(ordered == simlinq::OrderBy(data, identity));
+        CHECK(ordered.data() == storage);
+
+        auto descending = simlinq::OrderByDescending(std::move(ordered), identity);
+        CHECK(descending == simlinq::OrderByDescending(data, identity));
+        CHECK(descending.data() == storage);
+
+        auto compared = simlinq::OrderBy(std::vector<int>(data), identity, std::greater<int>());
+        CHECK(compared == descending);
+    }
+
+
+    TEST(WhereCompactsInPlace)
+    {
+        auto values = data;
+        const auto storage = values.data();
+
+        auto even = simlinq::Where(std::move(values), isEven);
+        CHECK(even == std::vector<int>({ 8, 8, 4, 2 }));
+        CHECK(even.data() == storage);
+
+        std::list<std::string> words{ "a", "bb", "ccc", "dd" };
+        auto pairs = simlinq::Where(std::move(words), [](const std::string& s) { return s.size() == 2; });
+        CHECK(pairs == std::list<std::string>({ "bb", "dd" }));
+    }
+
+
+    TEST(SkipAndTakeWhileErase)
+    {
+        CHECK(simlinq::Skip(std::vector<int>(data), 5) == std::vector<int>({ 4, 2, 7 }));
+        CHECK(simlinq::Skip(std::vector<int>(data), 20).empty());
+        CHECK(simlinq::Skip(std::list<int>{ 1, 2, 3 }, 1) == std::list<int>({ 2, 3 }));
+
+        CHECK(simlinq::SkipWhile(std::vector<int>(data), [](int v) { return v != 1; }) == std::vector<int>({ 1, 8, 4, 2, 7 }));
+        CHECK(simlinq::TakeWhile(std::vector<int>(data), [](int v) { return v != 1; }) == std::vector<int>({ 5, 3, 8 }));
+        CHECK(simlinq::TakeWhile(std::vector<int>(data), [](int v) { return v > 100; }).empty());
+    }
+
+
+    TEST(SetOperationsInPlace)
+    {
+        const std::vector<int> other{ 8, 2, 9, 5 };
+
+        CHECK(simlinq::Distinct(std::vector<int>(data), other) == simlinq::Distinct(data, other));
+        CHECK(simlinq::Intersect(std::vector<int>(data), other) == simlinq::Intersect(data, other));
+
+        auto byDescending = [](int l, int r) { return l > r; };
+        CHECK(simlinq::Distinct(std::vector<int>(data), other, byDescending) == simlinq::Distinct(data, other, byDescending));
+        CHECK(simlinq::Intersect(std::vector<int>(data), other, byDescending) == simlinq::Intersect(data, other, byDescending));
+
+        /* duplicates cancel one for one, as with the copying overloads; the order of the first sequence is kept */
+        const std::vector<int> eights{ 8 };
+        CHECK(simlinq::Distinct(std::vector<int>(data), eights) == std::vector<int>({ 5, 3, 1, 8, 4, 2, 7 }));
+        CHECK(simlinq::Distinct(std::vector<int>({ 1, 2, 2, 3 }), std::vector<int>({ 2 })) == std::vector<int>({ 1, 2, 3 }));
+        CHECK(simlinq::Intersect(std::vector<int>(data), std::vector<int>({ 8, 8, 8 })) == std::vector<int>({ 8, 8 }));
+    }
+
+
+    TEST(ForwardListsAreCopied)
+    {
+        /* std::forward_list cannot erase a range in place: these work on a copy and move the result back */
+        using forward_t = std::forward_list<int>;
+        const forward_t values(data.begin(), data.end());
+        
+        CHECK(simlinq::Where(forward_t(values), isEven) == forward_t({ 8, 8, 4, 2 }));
+        CHECK(simlinq::Distinct(forward_t(values)) == forward_t({ 5, 3, 8, 1, 4, 2, 7 }));
+        CHECK(simlinq::DistinctBy(forward_t(values), [](int v) { return v % 3; }) == forward_t({ 5, 3, 1 }));
+        
+        const forward_t other{ 8, 2, 9, 5 };
+        CHECK(simlinq::Distinct(forward_t(values), other) == forward_t({ 3, 1, 8, 4, 7 }));
+        CHECK(simlinq::Intersect(forward_t(values), other) == forward_t({ 5, 8, 2 }));
+        CHECK(simlinq::Intersect(forward_t(values), other, std::less<int>()) == forward_t({ 2, 5, 8 }));
+    }
+    
+    
+    TEST(LvaluesAreNotModified)
+    {
+        auto values = data;
+        simlinq::OrderBy(values, identity);
+        simlinq::Where(values, isEven);
+        simlinq::Skip(values, 3);
+        CHECK(values == data);
+    }
+}
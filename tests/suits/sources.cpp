@@ -0,0 +1,121 @@
+#include <Linq.hpp>
+#include <UnitTest++/UnitTest++.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+SUITE(SourceMethods)
+{
+    struct trade {
+        int32_t symbol;
+        int32_t quantity;
+        double price;
+    };
+
+    /* writes the bytes to a temporary file and removes it when done */
+    struct temp_file {
+        std::string path;
+
+        temp_file(const void* data, size_t bytes) {
+            char name[] = "/tmp/simlinqXXXXXX";
+            FILE* f = ::fdopen(::mkstemp(name), "wb");
+            if (bytes != 0)
+                std::fwrite(data, 1, bytes, f);
+            std::fclose(f);
+            path = name;
+        }
+
+        ~temp_file() { std::remove(path.c_str()); }
+    };
+
+
+    TEST(MappedFile)
+    {
+        std::vector<trade> trades;
+        for (int i = 0; i < 1000; ++i)
+            trades.push_back({ i % 7, i, i * 0.5 });
+        temp_file file(trades.data(), trades.size() * sizeof(trade));
+
+        simlinq::mapped_file<trade> mapped(file.path);
+        CHECK_EQUAL(mapped.size(), 1000u);
+        CHECK_EQUAL(mapped[999].quantity, 999);
+
+        auto quantity = [](const trade& t) { return t.quantity; };
+        CHECK_EQUAL(simlinq::from(mapped).Select(quantity).Sum(), 999 * 1000 / 2);
+        CHECK_EQUAL(simlinq::from(mapped).Where([](const trade& t) { return t.symbol == 3; }).Count(), 143);
+
+        auto bySymbol = simlinq::GroupBy(mapped, [](const trade& t) { return t.symbol; });
+        CHECK_EQUAL(bySymbol.size(), 7u);
+        CHECK_EQUAL(bySymbol[0].size(), 143u);
+
+        auto moved = std::move(mapped);
+        CHECK(mapped.empty());
+        CHECK_EQUAL(moved.back().symbol, 999 % 7);
+    }
+
+
+    TEST(MappedFileErrors)
+    {
+        temp_file empty(nullptr, 0);
+        simlinq::mapped_file<int> mapped(empty.path);
+        CHECK(mapped.empty());
+        CHECK(mapped.begin() == mapped.end());
+
+        CHECK_THROW(simlinq::mapped_file<int>("/nonexistent/simlinq"), std::system_error);
+    }
+
+
+    TEST(Lines)
+    {
+        auto all = simlinq::from(simlinq::lines("alpha\nbeta\r\n\ngamma\n")).ToVector();
+        CHECK(all == std::vector<std::string_view>({ "alpha", "beta", "", "gamma" }));
+
+        CHECK(simlinq::from(simlinq::lines("last")).ToVector() == std::vector<std::string_view>({ "last" }));
+        CHECK_EQUAL(simlinq::from(simlinq::lines("")).Count(), 0);
+
+        const std::string text = "b 1\na 2\nb 3\n";
+        temp_file file(text.data(), text.size());
+        simlinq::mapped_file<char> mapped(file.path);
+        auto counts = simlinq::from(simlinq::lines(mapped.bytes())).CountBy([](std::string_view line) { return line.substr(0, 1); });
+        CHECK_EQUAL(counts.size(), 2u);
+        CHECK(counts[0].first == "b");
+        CHECK_EQUAL(counts[0].second, 2u);
+    }
+
+
+    TEST(StreamLines)
+    {
+        std::istringstream in("x=1\ny=2\nx=3\n");
+        auto sums = simlinq::from(simlinq::lines(in)).AggregateBy(
+            [](const std::string& line) { return line.substr(0, 1); },
+            0,
+            [](const std::string& line, int& total) { total += std::stoi(line.substr(2)); });
+
+        const std::vector<std::pair<std::string, int>> expected{ { "x", 4 }, { "y", 2 } };
+        CHECK(sums == expected);
+    }
+
+
+    TEST(Generate)
+    {
+        int next = 0;
+        auto numbers = simlinq::generate([&next]() -> std::optional<int> {
+            if (next == 10)
+                return std::nullopt;
+            return next++;
+        });
+        CHECK_EQUAL(simlinq::from(numbers).Where([](int v) { return v % 2 == 0; }).Sum(), 20);
+
+        int counter = 0;
+        auto endless = simlinq::generate([&counter]() { return std::optional<int>(++counter); });
+        CHECK_EQUAL(simlinq::from(endless).TakeWhile([](int v) { return v <= 5; }).Sum(), 15);
+        CHECK(counter <= 6);
+    }
+}